@@ -5,42 +5,528 @@
  *  binary hack encodings
  */
 
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "assembler.h"
 #include "code.h"
+#include "ctable.h"
+#include "decompress.h"
+#include "emit.h"
+#include "expr.h"
 #include "helpers.h"
+#include "include.h"
+#include "object.h"
+#include "optimize.h"
 #include "parser.h"
+#include "patch.h"
+#include "rewrite.h"
+#include "syntax.h"
 #include "table.h"
+#include "vm.h"
+
+typedef struct {
+    asm_command_t **items;
+    size_t n;
+    size_t capacity;
+} command_list_t;
+
+typedef struct include_frame_t {
+    const char *path;                     /* real path of included file */
+    const struct include_frame_t *parent; /* file including this one */
+} include_frame_t;
+
+typedef struct {
+    asm_command_t **words;     /* commands taking ROM words */
+    const uint32_t *addresses; /* list of addresses indexed by symbol ID */
+    char *output;              /* mapped output file */
+    int width;                 /* bits per word */
+    bool extended;             /* C commands are sign extended */
+    size_t begin;              /* first word of the range */
+    size_t end;                /* word after the range */
+} fill_job_t;
+
+typedef struct {
+    table_t *labels;   /* labels of the program */
+    table_t *builtins; /* predefined symbols */
+    bool label;        /* evaluated expression names a label */
+} fold_context_t;
+
+typedef enum {
+    SYMBOLS_COUNT,     /* count words, labels and A commands of the range */
+    SYMBOLS_LABELS,    /* bind labels to ROM addresses */
+    SYMBOLS_VARIABLES, /* record first use of every variable */
+    SYMBOLS_ADDRESSES  /* give A commands IDs and resolve their operands */
+} symbols_stage_t;
+
+typedef struct {
+    symbols_stage_t stage;
+    asm_command_t **commands;
+    size_t begin;         /* first command of the range */
+    size_t end;           /* command after the range */
+    table_t *table;       /* builtins (only read while threads run) */
+    ctable_t *labels;     /* label -> ROM address */
+    ctable_t *variables;  /* variable -> first use, then RAM address */
+    uint32_t *addresses;  /* list of addresses indexed by symbol ID */
+    int32_t max;          /* largest value A command can load */
+    int64_t words;        /* words of the range, then its first address */
+    size_t labels_n;      /* labels of the range */
+    size_t ids;           /* A commands of the range, then its first ID */
+    bool failed;          /* range has constant out of range */
+} symbols_job_t;
+
+/*
+ * Function: append_command
+ * ------------------------
+ *  appends command to growable list
+ *
+ *  list: list to append to
+ *  command: command to append
+ */
+static void append_command(command_list_t *list, asm_command_t *command)
+{
+    if (list->n == list->capacity) {
+        list->capacity = list->capacity
+            ? 2 * list->capacity : COMMANDS_INIT_CAPACITY;
+        list->items = realloc(list->items,
+                list->capacity * sizeof(asm_command_t *));
+    }
+    list->items[list->n++] = command;
+}
+
+/*
+ * Function: expand_include
+ * ------------------------
+ *  appends commands of included file, expanding its own includes
+ *
+ *  list: list to append to
+ *  including: path of including file (NULL if it is not a file)
+ *  path: included path, relative to including file
+ *  parent: frame of including file (NULL if it is not a file)
+ *
+ *  returns: false if file can't be read or includes itself
+ */
+static bool expand_include(command_list_t *list, const char *including,
+        const char *path, const include_frame_t *parent)
+{
+    char *joined = including ? join_path(including, path) : strdup(path);
+    const include_entry_t *entry = include_lookup(joined);
+    include_frame_t frame;
+
+    if (!entry) {
+        fprintf(stderr, "HackAssembler: can't include %s\n", joined);
+        free(joined);
+        return false;
+    }
+    free(joined);
+
+    for (const include_frame_t *p = parent; p; p = p->parent) {
+        if (!strcmp(p->path, entry->path)) {
+            fprintf(stderr, "HackAssembler: include cycle: %s", entry->path);
+            for (const include_frame_t *q = parent; q != p; q = q->parent) {
+                fprintf(stderr, " <- %s", q->path);
+            }
+            fprintf(stderr, " <- %s\n", p->path);
+            return false;
+        }
+    }
+
+    frame.path = entry->path;
+    frame.parent = parent;
+
+    for (size_t i = 0; i < entry->n; i++) {
+        if (entry->commands[i]->type != I_COMMAND) {
+            append_command(list, command_copy(entry->commands[i]));
+        } else if (!expand_include(list, entry->path,
+                    entry->commands[i]->symbol, &frame)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Function: read_commands
+ * -----------------------
+ *  reads all commands of the source into memory, replacing include
+ *  directives with commands of included files
+ *
+ *  input_stream: assembler language source file stream
+ *  options: assembling options (includes are relative to the source)
+ *  commands_ptr: list of parsed commands (read so far on error)
+ *  n_ptr: amount of read commands
+ *
+ *  returns: false if any include can't be expanded
+ */
+static bool read_commands(FILE *input_stream, const asm_options_t *options,
+        asm_command_t ***commands_ptr, size_t *n_ptr)
+{
+    command_list_t list = { NULL, 0, 0 };
+    asm_command_t *command;
+    size_t line = 1;
+    char real[PATH_MAX];
+    include_frame_t root = { real, NULL };
+    bool ok = true;
+
+    /* source itself takes part in cycle detection */
+    bool has_root = options->source && realpath(options->source, real);
+
+    while (ok && (command = get_command(input_stream, &line))) {
+        if (command->type == I_COMMAND) {
+            ok = expand_include(&list, options->source, command->symbol,
+                    has_root ? &root : NULL);
+            command_del(command);
+        } else {
+            append_command(&list, command);
+        }
+    }
+
+    *commands_ptr = list.items;
+    *n_ptr = list.n;
+    return ok;
+}
+
+/*
+ * Function: command_file
+ * ----------------------
+ *  names source file of the command for diagnostics
+ *
+ *  command: assembler command structure
+ *  options: assembling options
+ *
+ *  returns: path of included file or of the source itself
+ */
+static const char *command_file(const asm_command_t *command,
+        const asm_options_t *options)
+{
+    if (command->file) {
+        return command->file;
+    }
+    return options->source ? options->source : "source";
+}
+
+/*
+ * Function: max_address
+ * ---------------------
+ *  finds largest value A command can load
+ *
+ *  options: assembling options
+ *
+ *  returns: HACK_EXTENDED_MAX_ADDRESS in extended ROM mode
+ *           HACK_MAX_ADDRESS otherwise
+ */
+static int32_t max_address(const asm_options_t *options)
+{
+    return options->extended ? HACK_EXTENDED_MAX_ADDRESS : HACK_MAX_ADDRESS;
+}
+
+/*
+ * Function: check_labels_unique
+ * -----------------------------
+ *  checks that every label is defined once per program (included files
+ *  count as its part), the rule HackLinker applies across objects
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  options: assembling options
+ *
+ *  returns: false if any label is defined twice (reported)
+ */
+static bool check_labels_unique(asm_command_t **commands, size_t n,
+        const asm_options_t *options)
+{
+    ctable_t *defined = ctable_new(n); /* label -> index of its command */
+    int32_t def;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < n; i++) {
+        if (commands[i]->type != L_COMMAND) {
+            continue;
+        }
+        def = ctable_put(defined, commands[i]->symbol, i, CTABLE_KEEP);
+        if (def != (int32_t) i) {
+            fprintf(stderr, "HackAssembler: %s:%zu: label %s is already "
+                    "defined at %s:%zu\n", command_file(commands[i], options),
+                    commands[i]->line, commands[i]->symbol,
+                    command_file(commands[def], options), commands[def]->line);
+            ok = false;
+        }
+    }
+
+    ctable_del(defined);
+    return ok;
+}
 
 /*
  * Function: resolve_label_symbols
  * -------------------------------
- *  goes through source code line by line and builts symbol table
+ *  goes through commands one by one and builts symbol table
  *
- *  input_stream: assembler language source file stream
+ *  commands: list of parsed commands
+ *  n: amount of commands
  *  table: table to populate with labels
+ *  limit: largest valid ROM address
+ *  options: assembling options
+ *
+ *  returns: false if any label is defined twice or any word or label
+ *           lands past the given limit
  */
-static void resolve_label_symbols(FILE *input_stream, table_t *table)
+static bool resolve_label_symbols(asm_command_t **commands,
+        size_t n, table_t *table, int32_t limit, const asm_options_t *options)
 {
-    asm_command_t *command;
-    short ln = -1; /* current instruction line */
+    int64_t words = 0; /* address of the next instruction */
 
-    while ((command = get_command(input_stream))) {
-        switch (command->type) {
+    for (size_t i = 0; i < n; i++) {
+        switch (commands[i]->type) {
             case A_COMMAND:
             case C_COMMAND:
-                ln++;
+                if (words > limit) {
+                    fprintf(stderr, "HackAssembler: %s:%zu: program doesn't "
+                            "fit into ROM of %lld words%s\n",
+                            command_file(commands[i], options),
+                            commands[i]->line, (long long) limit + 1,
+                            options->extended ? "" : " (see -X)");
+                    return false;
+                }
+                words++;
                 break;
             case L_COMMAND:
-                table_add(table, command->symbol, ln + 1);
+                if (words > limit) {
+                    fprintf(stderr, "HackAssembler: %s:%zu: label %s at ROM "
+                            "address %lld is out of range\n",
+                            command_file(commands[i], options),
+                            commands[i]->line, commands[i]->symbol,
+                            (long long) words);
+                    return false;
+                }
+                table_add(table, commands[i]->symbol, words);
+                break;
+            case I_COMMAND:
                 break;
         }
+    }
+
+    /* the pass above binds the last of duplicate labels, reject them */
+    return check_labels_unique(commands, n, options);
+}
 
-        command_del(command);
+/*
+ * Function: constant_value
+ * ------------------------
+ *  converts numeric A command operand (thread safe)
+ *
+ *  symbol: numeric symbol
+ *  max: largest value A command can load
+ *
+ *  returns: value of the number
+ *           -1 if the number is larger than max
+ */
+static int32_t constant_value(const char *symbol, int32_t max)
+{
+    int64_t value = 0;
+
+    for (const char *p = symbol; *p; p++) {
+        value = 10 * value + (*p - '0');
+        if (value > max) {
+            return -1;
+        }
     }
+    return value;
+}
+
+/*
+ * Function: parse_constant
+ * ------------------------
+ *  converts numeric A command operand checking its range
+ *
+ *  command: A command with numeric symbol
+ *  options: assembling options
+ *
+ *  returns: value of the number
+ *           -1 if the number doesn't fit into A command (reported)
+ */
+static int32_t parse_constant(const asm_command_t *command,
+        const asm_options_t *options)
+{
+    int32_t value = constant_value(command->symbol, max_address(options));
+
+    if (value < 0) {
+        fprintf(stderr, "HackAssembler: %s:%zu: constant %s is out of "
+                "range (max %d)\n", command_file(command, options),
+                command->line, command->symbol, max_address(options));
+    }
+    return value;
+}
+
+/*
+ * Function: fold_lookup
+ * ---------------------
+ *  finds value of symbol in A command expression: labels shadow
+ *  predefined symbols as in the symbol table, variables aren't allowed
+ *
+ *  symbol: symbol of the expression
+ *  position: offset of the symbol in the expression
+ *  arg: fold context
+ *
+ *  returns: value of the symbol
+ *           -1 if symbol is neither label nor predefined
+ */
+static int32_t fold_lookup(const char *symbol, size_t position, void *arg)
+{
+    fold_context_t *context = arg;
+    int32_t value = table_get(context->labels, symbol);
+
+    if (value >= 0) {
+        context->label = true;
+        return value;
+    }
+    return table_get(context->builtins, symbol);
+}
+
+/*
+ * Function: fold_expressions
+ * --------------------------
+ *  replaces every A command expression with its value, so later passes
+ *  see plain numbers; labels are bound by a pass of its own, so they may
+ *  be used before they are defined
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  builtins: table of predefined symbols
+ *  options: assembling options
+ *
+ *  returns: false if any expression can't be evaluated, its value doesn't
+ *           fit into A command, or it names a label while optimizer may
+ *           move code or object is relocated
+ */
+static bool fold_expressions(asm_command_t **commands, size_t n,
+        table_t *builtins, const asm_options_t *options)
+{
+    fold_context_t context = { NULL, builtins, false };
+    asm_command_t *command;
+    expr_status_t status;
+    char buffer[16];
+    size_t position;
+    int64_t value;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < n; i++) {
+        command = commands[i];
+        if (command->type != A_COMMAND
+                || !expr_is_expression(command->symbol)) {
+            continue;
+        }
+
+        /* programs without expressions don't pay for the label pass */
+        if (!context.labels) {
+            context.labels = table_new();
+            if (!resolve_label_symbols(commands, n, context.labels,
+                        INT32_MAX, options)) {
+                ok = false;
+                break;
+            }
+        }
+
+        context.label = false;
+        status = expr_eval(command->symbol, fold_lookup, &context, &value,
+                &position);
+        if (status != EXPR_OK && command->symbol[position]) {
+            fprintf(stderr, "HackAssembler: %s:%zu: %s in %s at '%s'\n",
+                    command_file(command, options), command->line,
+                    expr_message(status), command->symbol,
+                    command->symbol + position);
+            ok = false;
+            break;
+        } else if (status != EXPR_OK) {
+            fprintf(stderr, "HackAssembler: %s:%zu: %s in %s at its end\n",
+                    command_file(command, options), command->line,
+                    expr_message(status), command->symbol);
+            ok = false;
+            break;
+        }
+
+        /* label plus offset means nothing once code is moved */
+        if (context.label && (options->optimize || options->layout
+                    || options->prune || options->rewrites
+                    || options->object)) {
+            fprintf(stderr, "HackAssembler: %s:%zu: label arithmetic in %s "
+                    "can't be combined with -O, -B, -U, -R or -c\n",
+                    command_file(command, options), command->line,
+                    command->symbol);
+            ok = false;
+            break;
+        }
+        if (value < 0 || value > max_address(options)) {
+            fprintf(stderr, "HackAssembler: %s:%zu: value %lld of %s is out "
+                    "of range (max %d)\n", command_file(command, options),
+                    command->line, (long long) value, command->symbol,
+                    max_address(options));
+            ok = false;
+            break;
+        }
+
+        snprintf(buffer, sizeof(buffer), "%d", (int) value);
+        free(command->symbol);
+        command->symbol = strdup(buffer);
+    }
+
+    if (context.labels) {
+        table_del(context.labels);
+    }
+    return ok;
+}
+
+/*
+ * Function: apply_rewrites
+ * ------------------------
+ *  replaces C command sequences found in rewrite database
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n_ptr: amount of commands, updated
+ *  options: assembling options
+ *
+ *  returns: false if database can't be loaded (commands are untouched)
+ */
+static bool apply_rewrites(asm_command_t **commands, size_t *n_ptr,
+        const asm_options_t *options)
+{
+    rewrite_db_t *db = rewrite_load(options->rewrites);
+    size_t rewritten;
+
+    if (!db) {
+        fprintf(stderr, "HackAssembler: %s is not a valid rewrite "
+                "database\n", options->rewrites);
+        return false;
+    }
+    *n_ptr = rewrite_apply(commands, *n_ptr, db, &rewritten);
+    rewrite_del(db);
+
+    fprintf(stderr, "HackAssembler: %s: rewrote %zu sequences\n",
+            options->source ? options->source : "source", rewritten);
+    return true;
+}
+
+/*
+ * Function: first_variable
+ * ------------------------
+ *  RAM address of the first variable, variables of loaded snapshot keep
+ *  theirs, so new ones go past them
+ *
+ *  table: symbol table with builtins
+ *
+ *  returns: address of the first variable
+ */
+static int32_t first_variable(const table_t *table)
+{
+    return table->free_address > FIRST_FREE_ADDRESS
+        ? table->free_address : FIRST_FREE_ADDRESS;
 }
 
 /*
@@ -48,23 +534,371 @@ static void resolve_label_symbols(FILE *input_stream, table_t *table)
  * ----------------------------
  *  resolves symbol in an A command
  *
- *  symbol: variable or numeric symbol
+ *  command: A command with variable or numeric symbol
  *  table: symbol table
- *  address: next available address
+ *  address_ptr: next available address
+ *  options: assembling options
  *
  *  returns: integer value of the symbol
+ *           -1 if constant is out of range or variables run past
+ *           addressable memory (reported)
  */
-static short resolve_var_symbol(const char *symbol,
-        table_t *table, short *address_ptr)
+static int32_t resolve_var_symbol(const asm_command_t *command,
+        table_t *table, int32_t *address_ptr, const asm_options_t *options)
 {
-    if (str_isnum(symbol)) {
-        return atoi(symbol);
+    if (str_isnum(command->symbol)) {
+        return parse_constant(command, options);
     }
-    if (!table_contains(table, symbol)) {
-        table_add(table, symbol, *address_ptr);
+    if (!table_contains(table, command->symbol)) {
+        if (*address_ptr > max_address(options)) {
+            fprintf(stderr, "HackAssembler: %s:%zu: variable %s doesn't fit "
+                    "into memory\n", command_file(command, options),
+                    command->line, command->symbol);
+            return -1;
+        }
+        table_add(table, command->symbol, *address_ptr);
         *address_ptr += 1;
     }
-    return table_get(table, symbol);
+    return table_get(table, command->symbol);
+}
+
+/*
+ * Function: intern_symbols
+ * ------------------------
+ *  gives every A command operand dense integer ID and resolves it once:
+ *  equal symbols share ID, variables are allocated in order of first use
+ *  and every number gets an ID of its own, so encoding pass only indexes
+ *  flat list of addresses
+ *
+ *  commands: list of parsed commands (IDs are stored in them)
+ *  n: amount of commands
+ *  table: symbol table with labels (variables are added to it and its
+ *         free address moves past them)
+ *  options: assembling options
+ *
+ *  returns: list of addresses indexed by symbol ID
+ *           NULL if any operand can't be resolved or there are more
+ *           symbols than IDs fit in the table
+ */
+static uint32_t *intern_symbols(asm_command_t **commands, size_t n,
+        table_t *table, const asm_options_t *options)
+{
+    table_t *indices = table_new(); /* symbol name -> symbol index */
+    int *ids = NULL;                /* symbol index -> ID */
+    /* program without A commands still resolves, so never NULL */
+    uint32_t *addresses = malloc(sizeof(uint32_t));
+    int32_t address = first_variable(table);
+    size_t ids_n = 0, symbols_n = 0;
+    asm_command_t *command;
+    int32_t index, value;
+    bool number, ok = true;
+
+    for (size_t i = 0; ok && i < n; i++) {
+        command = commands[i];
+        if (command->type != A_COMMAND) {
+            continue;
+        }
+
+        number = str_isnum(command->symbol);
+        if (!number && (index = table_get(indices, command->symbol)) >= 0) {
+            command->id = ids[index];
+            continue;
+        }
+
+        /* capacity is implied by amount: it is doubled at powers of 2 */
+        if (ids_n == 0 || (ids_n & (ids_n - 1)) == 0) {
+            addresses = realloc(addresses,
+                    (ids_n ? 2 * ids_n : 1) * sizeof(uint32_t));
+        }
+        if (ids_n == INT_MAX) {
+            fprintf(stderr, "HackAssembler: too many symbols\n");
+            ok = false;
+            break;
+        }
+        if ((value = resolve_var_symbol(command, table, &address,
+                        options)) < 0) {
+            ok = false;
+            break;
+        }
+        command->id = ids_n++;
+        addresses[command->id] = value;
+
+        if (number) {
+            continue;
+        }
+        if (symbols_n == 0 || (symbols_n & (symbols_n - 1)) == 0) {
+            ids = realloc(ids, (symbols_n ? 2 * symbols_n : 1) * sizeof(int));
+        }
+        ids[symbols_n] = command->id;
+        table_add(indices, command->symbol, symbols_n++);
+    }
+
+    table_del(indices);
+    free(ids);
+    if (!ok) {
+        free(addresses);
+        return NULL;
+    }
+    table->free_address = address;
+    return addresses;
+}
+
+/*
+ * Function: symbol_threads
+ * ------------------------
+ *  finds amount of threads resolving symbols of the program
+ *
+ *  n: amount of commands
+ *  options: assembling options (thread count)
+ *
+ *  returns: amount of threads (1 means symbols are resolved serially)
+ */
+static size_t symbol_threads(size_t n, const asm_options_t *options)
+{
+    size_t threads_n = options->threads > 0 ? options->threads : 1;
+
+    /* command indices are stored as 32 bit values */
+    if (n > INT32_MAX) {
+        return 1;
+    }
+    if (threads_n > n / ASM_SYMBOLS_PER_THREAD) {
+        threads_n = n / ASM_SYMBOLS_PER_THREAD;
+    }
+    return threads_n > 1 ? threads_n : 1;
+}
+
+/*
+ * Function: symbols_thread
+ * ------------------------
+ *  thread routine running current stage of symbol resolution over its
+ *  range of commands
+ *
+ *  arg: symbols job
+ *
+ *  returns: NULL
+ */
+static void *symbols_thread(void *arg)
+{
+    symbols_job_t *job = arg;
+    asm_command_t *command;
+    int32_t address;
+    size_t id = job->ids;
+    int64_t words = job->words;
+
+    for (size_t i = job->begin; i < job->end; i++) {
+        command = job->commands[i];
+
+        switch (job->stage) {
+            case SYMBOLS_COUNT:
+                if (command->type == A_COMMAND) {
+                    job->ids++;
+                }
+                if (command->type == A_COMMAND
+                        || command->type == C_COMMAND) {
+                    job->words++;
+                } else if (command->type == L_COMMAND) {
+                    job->labels_n++;
+                }
+                break;
+            case SYMBOLS_LABELS:
+                if (command->type == A_COMMAND
+                        || command->type == C_COMMAND) {
+                    words++;
+                } else if (command->type == L_COMMAND) {
+                    /* duplicates fail the program once labels are
+                     * counted, so the kept value doesn't matter */
+                    ctable_put(job->labels, command->symbol, words,
+                            CTABLE_KEEP);
+                }
+                break;
+            case SYMBOLS_VARIABLES:
+                if (command->type != A_COMMAND) {
+                    break;
+                }
+                if (str_isnum(command->symbol)) {
+                    job->failed = job->failed
+                        || constant_value(command->symbol, job->max) < 0;
+                } else if (ctable_get(job->labels, command->symbol) < 0
+                        && !table_contains(job->table, command->symbol)) {
+                    /* the earliest use wins whichever thread gets first */
+                    ctable_put(job->variables, command->symbol, i,
+                            CTABLE_MIN);
+                }
+                break;
+            case SYMBOLS_ADDRESSES:
+                if (command->type != A_COMMAND) {
+                    break;
+                }
+                if (str_isnum(command->symbol)) {
+                    address = constant_value(command->symbol, job->max);
+                } else if ((address = ctable_get(job->labels,
+                                command->symbol)) < 0
+                        && (address = table_get(job->table,
+                                command->symbol)) < 0) {
+                    address = ctable_get(job->variables, command->symbol);
+                }
+                command->id = id;
+                job->addresses[id++] = address;
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Function: run_symbols_stage
+ * ---------------------------
+ *  runs stage of symbol resolution on every job, each in its own thread
+ *
+ *  jobs: jobs covering all commands
+ *  threads_n: amount of jobs
+ *  stage: stage to run
+ */
+static void run_symbols_stage(symbols_job_t *jobs, size_t threads_n,
+        symbols_stage_t stage)
+{
+    pthread_t threads[ASM_MAX_THREADS];
+
+    for (size_t t = 0; t < threads_n; t++) {
+        jobs[t].stage = stage;
+        if (t > 0) {
+            pthread_create(&threads[t], NULL, symbols_thread, &jobs[t]);
+        }
+    }
+
+    /* calling thread takes the first range itself */
+    symbols_thread(&jobs[0]);
+    for (size_t t = 1; t < threads_n; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+/*
+ * Function: compare_first_use
+ * ---------------------------
+ *  orders variables by their first use
+ */
+static int compare_first_use(const void *a, const void *b)
+{
+    const ctable_entry_t *x = a, *y = b;
+
+    return (x->val > y->val) - (x->val < y->val);
+}
+
+/*
+ * Function: resolve_symbols_threaded
+ * ----------------------------------
+ *  resolves labels and A command operands of large program on several
+ *  threads sharing lock free tables; labels are bound as in serial label
+ *  pass and variables get addresses in order of first use, so output
+ *  matches serial interning byte for byte (A commands get IDs of their
+ *  own instead of shared ones)
+ *
+ *  labels and variables are added to the table only if it is saved
+ *
+ *  commands: list of parsed commands without bound labels
+ *  n: amount of commands
+ *  table: symbol table with builtins
+ *  options: assembling options (thread count)
+ *
+ *  returns: list of addresses indexed by symbol ID
+ *           NULL if program has any error (table is untouched then, so
+ *           serial passes can report it)
+ */
+static uint32_t *resolve_symbols_threaded(asm_command_t **commands,
+        size_t n, table_t *table, const asm_options_t *options)
+{
+    size_t threads_n = symbol_threads(n, options);
+    size_t ids_n = 0, labels_n = 0, variables_n = 0, count;
+    symbols_job_t jobs[ASM_MAX_THREADS];
+    ctable_t *labels, *variables;
+    ctable_entry_t *entries = NULL;
+    uint32_t *addresses = NULL;
+    int64_t words = 0;
+    int32_t first = first_variable(table);
+    bool failed = false;
+
+    memset(jobs, 0, sizeof(jobs));
+    for (size_t t = 0; t < threads_n; t++) {
+        jobs[t].commands = commands;
+        jobs[t].begin = n * t / threads_n;
+        jobs[t].end = n * (t + 1) / threads_n;
+        jobs[t].table = table;
+        jobs[t].max = max_address(options);
+    }
+    run_symbols_stage(jobs, threads_n, SYMBOLS_COUNT);
+
+    /* every range starts where the previous one ends */
+    for (size_t t = 0; t < threads_n; t++) {
+        count = jobs[t].words;
+        jobs[t].words = words;
+        words += count;
+        count = jobs[t].ids;
+        jobs[t].ids = ids_n;
+        ids_n += count;
+        labels_n += jobs[t].labels_n;
+    }
+    if (words > max_address(options)) {
+        return NULL;
+    }
+
+    labels = ctable_new(labels_n);
+    variables = ctable_new(ids_n / ASM_USES_PER_VARIABLE);
+    for (size_t t = 0; t < threads_n; t++) {
+        jobs[t].labels = labels;
+        jobs[t].variables = variables;
+    }
+    run_symbols_stage(jobs, threads_n, SYMBOLS_LABELS);
+    run_symbols_stage(jobs, threads_n, SYMBOLS_VARIABLES);
+
+    /* fewer keys than definitions means some label is defined twice */
+    failed = atomic_load(&labels->size) != labels_n;
+    for (size_t t = 0; t < threads_n; t++) {
+        failed = failed || jobs[t].failed;
+    }
+    if (!failed) {
+        entries = ctable_entries(variables, &variables_n);
+        failed = (int64_t) variables_n
+            > (int64_t) max_address(options) + 1 - first;
+    }
+
+    if (!failed) {
+        /* allocate variables in order of their first use */
+        qsort(entries, variables_n, sizeof(ctable_entry_t),
+                compare_first_use);
+        for (size_t i = 0; i < variables_n; i++) {
+            ctable_put(variables, entries[i].key, first + i,
+                    CTABLE_REPLACE);
+        }
+
+        addresses = malloc((ids_n ? ids_n : 1) * sizeof(uint32_t));
+        for (size_t t = 0; t < threads_n; t++) {
+            jobs[t].addresses = addresses;
+        }
+        run_symbols_stage(jobs, threads_n, SYMBOLS_ADDRESSES);
+    }
+
+    if (!failed && options->symbols_out) {
+        /* same insertion order as serial passes, so snapshots match */
+        words = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (commands[i]->type == L_COMMAND) {
+                table_add(table, commands[i]->symbol, words);
+            } else if (commands[i]->type != I_COMMAND) {
+                words++;
+            }
+        }
+        for (size_t i = 0; i < variables_n; i++) {
+            table_add(table, entries[i].key, first + i);
+        }
+        table->free_address = first + variables_n;
+    }
+
+    free(entries);
+    ctable_del(labels);
+    ctable_del(variables);
+    return addresses;
 }
 
 /*
@@ -73,50 +907,54 @@ static short resolve_var_symbol(const char *symbol,
  *  writes 'code' to the stream as sequence of 0's and 1's
  *
  *  stream: writable stream
- *  code: hack command code represented as short int
+ *  code: hack command code
  */
-static void write_hack_command(FILE *stream, short code)
+void write_hack_command(FILE *stream, uint16_t code)
 {
-    int i;
-    char binary[HACK_WORD_SIZE + 1]; /* add 1 for string terminator '\0' */
-
-    for (i = 0; i < HACK_WORD_SIZE; i++) {
-        /* extracts i-th most significat binary digit and
-         * coverts it to ASCII char */
-        binary[i] = ((code >> (HACK_WORD_SIZE - i - 1)) & 1) + '0';
-    }
+    char line[HACK_LINE_SIZE];
 
-    binary[i] = '\0';
-    fprintf(stream, "%s\n", binary);
+    emit_hack_line(line, code, HACK_WORD_SIZE);
+    fwrite(line, 1, HACK_LINE_SIZE, stream);
 }
 
 /*
- * Function: write_a_command
- * -------------------------
- *  writes binary encoding of A command to stream
+ * Function: command_encoding
+ * --------------------------
+ *  encodes C command unless the parser already knows its encoding
  *
- *  stream: writable stream
- *  command: assembler command structure
+ *  command: C command
+ *
+ *  returns: C command encoded as 16 bit word
  */
-static void write_a_command(FILE *stream,
-        asm_command_t *command, table_t *table, short *address_ptr)
+static uint16_t command_encoding(const asm_command_t *command)
 {
-    short code = resolve_var_symbol(command->symbol, table, address_ptr);
-    write_hack_command(stream, code);
+    if (command->code != COMMAND_NOT_ENCODED) {
+        return command->code;
+    }
+    return encode_command(command->dest, command->comp, command->jump);
 }
 
 /*
- * Function: write_c_command
- * -------------------------
- *  writes binary encoding of C command to stream
+ * Function: command_word
+ * ----------------------
+ *  finds ROM word of A or C command
  *
- *  stream: writable stream
- *  command: assembler command structure
+ *  command: A or C command (A command operand interned)
+ *  addresses: list of addresses indexed by symbol ID
+ *  extended: true if words are 32 bits wide
+ *
+ *  returns: word of the command
  */
-static void write_c_command(FILE *stream, asm_command_t *command)
+static uint32_t command_word(const asm_command_t *command,
+        const uint32_t *addresses, bool extended)
 {
-    short code = encode_command(command->dest, command->comp, command->jump);
-    write_hack_command(stream, code);
+    if (command->type == A_COMMAND) {
+        return addresses[command->id];
+    }
+    if (extended) {
+        return HACK_EXTENDED_C_PREFIX | command_encoding(command);
+    }
+    return command_encoding(command);
 }
 
 /*
@@ -126,23 +964,86 @@ static void write_c_command(FILE *stream, asm_command_t *command)
  */
 static void write_help_msg(void)
 {
-    printf("\nUsage: HackAssembler source\n\n"
-           "Assemble ASM source file.\n\n"
+    printf("\nUsage: HackAssembler [-O] [-B] [-U] [-R rewrites] [-m | -c] [-X]\n"
+           "                     [-s symbols] [-S symbols] [-j threads]\n"
+           "                     [-M | [--check] -o output...]\n"
+           "                     [-p patch] [--apply] source...\n"
+           "       HackAssembler --syntax-only [-X] [-s symbols] source...\n\n"
+           "Assemble ASM source files.\n\n"
            "Arguments:\n"
-           "source(required)\tsource file path (must have .asm suffix)\n\n");
+           "source(required)\tsource file path (must have .asm or .vm\n"
+           "\t\t\tsuffix, optionally followed by .gz or .zst)\n"
+           "\t\t\tor directory of .vm files\n"
+           "-O\t\t\tremove redundant commands\n"
+           "-B\t\t\tlay out basic blocks for fall through: thread\n"
+           "\t\t\tjumps to jumps and drop jumps to the next block\n"
+           "-U\t\t\tremove code unreachable from address 0 (labels\n"
+           "\t\t\tloaded as data count as reached), report removed\n"
+           "\t\t\twords; not with -c\n"
+           "-R rewrites\t\treplace C command sequences with shorter ones\n"
+           "\t\t\tof rewrite database written by HackSuperopt\n"
+           "-m\t\t\twrite source map next to the output\n"
+           "-c\t\t\twrite relocatable object (.obj) for HackLinker\n"
+           "-X\t\t\textended ROM: 32 bit words with 31 bit operands,\n"
+           "\t\t\tfor programs past 32K words (not runnable by\n"
+           "\t\t\tHackSimulator)\n"
+           "-s symbols\t\tmap symbol snapshot as predefined symbols\n"
+           "-S symbols\t\tsave final symbol table as snapshot\n"
+           "-M\t\t\twrite output through presized memory map\n"
+           "-j threads\t\tthreads resolving symbols of large programs and\n"
+           "\t\t\tfilling mapped output (default: cores)\n"
+           "-o output\t\twrite output of format given by its suffix\n"
+           "\t\t\tinstead of default .hack file: .hack, .bin (raw\n"
+           "\t\t\twords), .hex (Intel HEX) or .mem ($readmemb image),\n"
+           "\t\t\tmay be repeated to write several outputs at once\n"
+           "--check\t\t\tverify existing outputs instead of writing them,\n"
+           "\t\t\tfail at first word that differs\n"
+           "-p patch\t\twrite runs of words that differ from previous\n"
+           "\t\t\tbuild (default output or single -o output)\n"
+           "--apply\t\t\tupdate previous build in place, rewriting only\n"
+           "\t\t\tchanged words (.hack, .bin and .mem images)\n"
+           "--syntax-only\t\treport every error of assembler sources as\n"
+           "\t\t\tpath:line:column (operands, mnemonics, includes,\n"
+           "\t\t\tduplicate labels and undefined jump targets),\n"
+           "\t\t\twrite nothing\n\n"
+           "Sources may pull in other files with '#include \"path\"' or\n"
+           "'.include \"path\"'. Set HACK_ASM_CACHE to a directory to keep\n"
+           "lexed includes across runs. Label may be defined only once\n"
+           "in the program, included files count as its part.\n\n"
+           "A command operand may be an expression over numbers, labels\n"
+           "and predefined symbols ('@SCREEN+32*5', operators + - * / %%\n"
+           "& | and parentheses), folded into one constant; arithmetic on\n"
+           "labels doesn't combine with -O, -B, -U, -R or -c.\n\n"
+           "Several sources are assembled in one batch, each into its\n"
+           "default output; -m, -S, -M, -o and --check take single source.\n\n"
+           "VM code is translated straight into the program, -O, -B, -U,\n"
+           "-R and -c take assembler sources only. Directory is translated as one\n"
+           "program into dir/dir.hack, starting with a call of Sys.init\n"
+           "if it has Sys.vm.\n\n");
 }
 
 /*
  * Function: init_builtins
  * -----------------------
  *  creates new table and populates it with hack assembler builtin symbols
+ *  on top of the symbol snapshot (if any)
+ *
+ *  options: assembling options
  *
  *  returns: brand new table
+ *           NULL if symbol snapshot isn't valid
  */
-static table_t *init_builtins(void)
+static table_t *init_builtins(const asm_options_t *options)
 {
     table_t *table = table_new();
 
+    if (options->symbols_in && !table_load(table, options->symbols_in)) {
+        fprintf(stderr, "HackAssembler: %s is not a valid symbol snapshot\n",
+                options->symbols_in);
+        table_del(table);
+        return NULL;
+    }
+
     table_add(table, "R0", 0);
     table_add(table, "R1", 1);
     table_add(table, "R2", 2);
@@ -172,109 +1073,907 @@ static table_t *init_builtins(void)
     return table;
 }
 
+/*
+ * Function: write_map_entry
+ * -------------------------
+ *  writes source map entry 'address line [label]' of the command
+ *
+ *  stream: writable source map stream
+ *  address: ROM address of the command
+ *  command: assembler command structure
+ *  label: label placed right before the command (can be NULL)
+ */
+static void write_map_entry(FILE *stream, size_t address,
+        asm_command_t *command, const char *label)
+{
+    if (label) {
+        fprintf(stream, "%zu %zu %s\n", address, command->line, label);
+    } else {
+        fprintf(stream, "%zu %zu\n", address, command->line);
+    }
+}
+
+/*
+ * Function: write_source_map
+ * --------------------------
+ *  writes source map entry of every command that takes ROM word
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  options: assembling options with source map stream
+ */
+static void write_source_map(asm_command_t **commands, size_t n,
+        const asm_options_t *options)
+{
+    size_t rom_address = 0;
+    const char *label = NULL; /* label waiting for its command */
+    const char *file = options->source; /* file of the last map entry */
+
+    fprintf(options->map_stream, "file %s\n", options->source);
+
+    for (size_t i = 0; i < n; i++) {
+        if (commands[i]->type == L_COMMAND) {
+            if (!label) {
+                label = commands[i]->symbol;
+            }
+            continue;
+        }
+
+        /* included commands are mapped to their own files */
+        if ((commands[i]->file ? commands[i]->file : options->source)
+                != file) {
+            file = commands[i]->file ? commands[i]->file : options->source;
+            fprintf(options->map_stream, "file %s\n", file);
+        }
+        write_map_entry(options->map_stream, rom_address++,
+                commands[i], label);
+        label = NULL;
+    }
+}
+
 /*
  * Function: generate_hack_commands
  * --------------------------------
- *  parses source code line by line, resolves symbols and writes hack commands
+ *  goes through commands one by one, encodes every word once and hands
+ *  it to all emitters
  *
- *  input_stream: readable assembler commands stream
- *  output_stream: writable hack commands stream
- *  table: symbol table
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  emitters: list of output emitters
+ *  emitters_n: amount of emitters
+ *  addresses: list of addresses indexed by symbol ID
+ *  extended: true if words are 32 bits wide
+ */
+static void generate_hack_commands(asm_command_t **commands, size_t n,
+        emitter_t *const *emitters, size_t emitters_n,
+        const uint32_t *addresses, bool extended)
+{
+    uint32_t code;
+    size_t live;
+
+    for (size_t i = 0; i < n; i++) {
+        switch (commands[i]->type) {
+            case A_COMMAND:
+            case C_COMMAND:
+                code = command_word(commands[i], addresses, extended);
+                break;
+            case L_COMMAND:
+            case I_COMMAND:
+                /* labels take no word, includes are expanded while reading */
+                continue;
+        }
+
+        /* failed (or mismatched) output ignores later words, others still
+           need all of them, so the pass ends only once every one failed */
+        live = 0;
+        for (size_t j = 0; j < emitters_n; j++) {
+            live += emitter_word(emitters[j], code);
+        }
+        if (live == 0) {
+            return;
+        }
+    }
+}
+
+/*
+ * Function: check_outputs
+ * -----------------------
+ *  finishes checking emitters and reports the first word of every
+ *  existing output that differs from the program
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  options: assembling options with checking emitters
+ *
+ *  returns: false if any output is out of date
  */
-static void generate_hack_commands(FILE *input_stream,
-        FILE *output_stream, table_t *table)
+static bool check_outputs(asm_command_t **commands, size_t n,
+        const asm_options_t *options)
 {
+    emitter_t *emitter;
+    size_t address;
+    bool ok = true;
+
+    for (size_t i = 0; i < options->outputs_n; i++) {
+        emitter = options->emitters[i];
+        if (emitter_finish(emitter)) {
+            continue;
+        }
+        ok = false;
+        if (!emitter->mismatched) {
+            fprintf(stderr, "HackAssembler: can't read %s\n",
+                    options->outputs[i]);
+            continue;
+        }
+
+        /* find command of the word, slow but done once per output */
+        address = 0;
+        for (size_t j = 0; j < n; j++) {
+            if (commands[j]->type != A_COMMAND
+                    && commands[j]->type != C_COMMAND) {
+                continue;
+            }
+            if (address++ == emitter->mismatch) {
+                fprintf(stderr, "HackAssembler: %s differs at ROM address "
+                        "%zu (%s:%zu)\n", options->outputs[i],
+                        emitter->mismatch, command_file(commands[j], options),
+                        commands[j]->line);
+                break;
+            }
+        }
+        if (address == emitter->mismatch) {
+            fprintf(stderr, "HackAssembler: %s differs at ROM address %zu "
+                    "(past the end of program)\n", options->outputs[i],
+                    emitter->mismatch);
+        }
+    }
+
+    return ok;
+}
+
+/*
+ * Function: encode_words
+ * ----------------------
+ *  encodes every word of the program into memory
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  addresses: list of addresses indexed by symbol ID
+ *  extended: true if words are 32 bits wide
+ *  words_n_ptr: amount of words
+ *
+ *  returns: allocated list of words
+ */
+static uint32_t *encode_words(asm_command_t **commands, size_t n,
+        const uint32_t *addresses, bool extended, size_t *words_n_ptr)
+{
+    uint32_t *words = malloc((n ? n : 1) * sizeof(uint32_t));
+    size_t words_n = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (commands[i]->type == A_COMMAND || commands[i]->type == C_COMMAND) {
+            words[words_n++] = command_word(commands[i], addresses, extended);
+        }
+    }
+
+    *words_n_ptr = words_n;
+    return words;
+}
+
+/*
+ * Function: patch_output
+ * ----------------------
+ *  diffs the program against image of previous build, writes the patch
+ *  and updates the image in place if asked to
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  addresses: list of addresses indexed by symbol ID
+ *  options: assembling options with previous build set
+ *
+ *  returns: false if the image can't be read or patched
+ */
+static bool patch_output(asm_command_t **commands, size_t n,
+        const uint32_t *addresses, const asm_options_t *options)
+{
+    int width = options->extended ? HACK_EXTENDED_WORD_SIZE : HACK_WORD_SIZE;
+    const char *base = options->patch_base;
+    FILE *patch_stream = NULL;
+    patch_image_t image;
+    patch_t *patch;
+    uint32_t *words;
+    size_t words_n;
+    FILE *stream;
+    bool ok = true;
+
+    if (!(stream = fopen(base, options->apply ? "r+b" : "rb"))) {
+        fprintf(stderr, "HackAssembler: can't open %s\n", base);
+        return false;
+    }
+    if (!patch_image_read(stream, base, width, &image)) {
+        fprintf(stderr, "HackAssembler: %s isn't %d bit image that can be "
+                "patched\n", base, width);
+        fclose(stream);
+        return false;
+    }
+
+    words = encode_words(commands, n, addresses, options->extended,
+            &words_n);
+    patch = patch_diff(&image, words, words_n);
+
+    if (options->patch) {
+        patch_stream = fopen(options->patch, "wb");
+        ok = patch_stream && patch_write(patch_stream, patch, width);
+        if (patch_stream && fclose(patch_stream)) {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "HackAssembler: can't write %s\n",
+                    options->patch);
+        }
+    }
+    /* only changed words are written, image stays otherwise untouched */
+    if (ok && options->apply && !patch_apply(fileno(stream), &image, patch)) {
+        fprintf(stderr, "HackAssembler: can't write %s\n", base);
+        ok = false;
+    }
+
+    fclose(stream);
+    patch_del(patch);
+    free(words);
+    free(image.words);
+    return ok;
+}
+
+/*
+ * Function: fill_thread
+ * ---------------------
+ *  thread routine formatting its range of words straight into mapped
+ *  output, every word has fixed offset so ranges never overlap
+ *
+ *  arg: fill job
+ *
+ *  returns: NULL
+ */
+static void *fill_thread(void *arg)
+{
+    fill_job_t *job = arg;
+
+    for (size_t i = job->begin; i < job->end; i++) {
+        emit_hack_line(job->output + i * (job->width + 1),
+                command_word(job->words[i], job->addresses, job->extended),
+                job->width);
+    }
+
+    return NULL;
+}
+
+/*
+ * Function: generate_hack_mapped
+ * ------------------------------
+ *  sizes output file for all words up front, maps it and lets several
+ *  threads format disjoint ranges of words in place
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  output_stream: hack commands stream opened for reading and writing
+ *  addresses: list of addresses indexed by symbol ID
+ *  options: assembling options (thread count)
+ *
+ *  returns: true if output is written
+ *           false if stream can't be mapped (nothing is written then)
+ */
+static bool generate_hack_mapped(asm_command_t **commands, size_t n,
+        FILE *output_stream, const uint32_t *addresses,
+        const asm_options_t *options)
+{
+    asm_command_t **words = malloc((n ? n : 1) * sizeof(asm_command_t *));
+    int width = options->extended ? HACK_EXTENDED_WORD_SIZE : HACK_WORD_SIZE;
+    size_t words_n = 0, size, threads_n;
+    int fd = fileno(output_stream);
+    pthread_t threads[ASM_MAX_THREADS];
+    fill_job_t jobs[ASM_MAX_THREADS];
+    char *output;
+
+    for (size_t i = 0; i < n; i++) {
+        if (commands[i]->type == A_COMMAND || commands[i]->type == C_COMMAND) {
+            words[words_n++] = commands[i];
+        }
+    }
+    size = words_n * (width + 1);
+
+    fflush(output_stream);
+    if (fd < 0 || ftruncate(fd, size)) {
+        free(words);
+        return false;
+    }
+    if (size == 0) {
+        free(words);
+        return true;
+    }
+    output = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (output == MAP_FAILED) {
+        free(words);
+        return false;
+    }
+
+    /* small outputs aren't worth starting threads for */
+    threads_n = options->threads > 0 ? options->threads : 1;
+    if (threads_n > words_n / ASM_WORDS_PER_THREAD + 1) {
+        threads_n = words_n / ASM_WORDS_PER_THREAD + 1;
+    }
+
+    for (size_t t = 0; t < threads_n; t++) {
+        jobs[t].words = words;
+        jobs[t].addresses = addresses;
+        jobs[t].output = output;
+        jobs[t].width = width;
+        jobs[t].extended = options->extended;
+        jobs[t].begin = words_n * t / threads_n;
+        jobs[t].end = words_n * (t + 1) / threads_n;
+        if (t > 0) {
+            pthread_create(&threads[t], NULL, fill_thread, &jobs[t]);
+        }
+    }
+
+    /* calling thread fills the first range itself */
+    fill_thread(&jobs[0]);
+    for (size_t t = 1; t < threads_n; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    munmap(output, size);
+    free(words);
+    return true;
+}
+
+/*
+ * Function: generate_object
+ * -------------------------
+ *  goes through commands one by one and encodes them into relocatable
+ *  object; labels are exported, operands naming neither label nor
+ *  predefined symbol are left to the linker together with relocation
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  labels: table of labels defined by the commands
+ *  builtins: table of predefined symbols
+ *  options: assembling options
+ *
+ *  returns: pointer to allocated object
+ *           NULL if any constant doesn't fit into A command
+ */
+static object_t *generate_object(asm_command_t **commands, size_t n,
+        table_t *labels, table_t *builtins, const asm_options_t *options)
+{
+    object_t *object = object_new();
+    table_t *indices = table_new(); /* symbol name -> object symbol index */
     asm_command_t *command;
-    short address = FIRST_FREE_ADDRESS;
+    size_t word;
+    int32_t index, value;
+
+    /* exports go first, so the linker learns every definition up front */
+    for (size_t i = 0; i < n; i++) {
+        if (commands[i]->type == L_COMMAND) {
+            index = object_add_symbol(object, commands[i]->symbol,
+                    OBJECT_LABEL, table_get(labels, commands[i]->symbol));
+            table_add(indices, commands[i]->symbol, index);
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        command = commands[i];
 
-    while ((command = get_command(input_stream))) {
         switch (command->type) {
             case A_COMMAND:
-                write_a_command(output_stream, command, table, &address);
+                if (str_isnum(command->symbol)) {
+                    if ((value = parse_constant(command, options)) < 0) {
+                        table_del(indices);
+                        object_del(object);
+                        return NULL;
+                    }
+                    object_add_word(object, value);
+                    break;
+                }
+                if (!table_contains(labels, command->symbol)
+                        && table_contains(builtins, command->symbol)) {
+                    object_add_word(object,
+                            table_get(builtins, command->symbol));
+                    break;
+                }
+
+                if (!table_contains(indices, command->symbol)) {
+                    index = object_add_symbol(object, command->symbol,
+                            OBJECT_EXTERN, 0);
+                    table_add(indices, command->symbol, index);
+                }
+                word = object_add_word(object, 0);
+                object_add_reloc(object, word,
+                        table_get(indices, command->symbol));
                 break;
             case C_COMMAND:
-                write_c_command(output_stream, command);
+                object_add_word(object, command_encoding(command));
                 break;
             case L_COMMAND:
+            case I_COMMAND:
                 break;
         }
+    }
+
+    /* cleanup */
+    table_del(indices);
 
-        command_del(command);
+    return object;
+}
+
+/*
+ * Function: optimize_commands
+ * ---------------------------
+ *  runs every optimization pass asked for, labels have to be resolved
+ *  again afterwards
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n_ptr: amount of commands, updated
+ *  options: assembling options
+ *
+ *  returns: false if any pass fails
+ */
+static bool optimize_commands(asm_command_t **commands, size_t *n_ptr,
+        const asm_options_t *options)
+{
+    table_t *builtins = init_builtins(options);
+    size_t n = *n_ptr, removed;
+    bool ok = true;
+
+    if (!builtins) {
+        return false;
+    }
+    if (options->prune) {
+        n = optimize_unreachable(commands, n, builtins, &removed);
+        fprintf(stderr, "HackAssembler: %s: removed %zu unreachable "
+                "words\n", options->source ? options->source : "source",
+                removed);
+    }
+    if (options->layout) {
+        n = optimize_layout(commands, n, builtins);
+    }
+    if (options->rewrites) {
+        ok = apply_rewrites(commands, &n, options);
+    }
+    if (ok && options->optimize) {
+        n = optimize_peephole(commands, n, builtins);
+    }
+    table_del(builtins);
+
+    *n_ptr = n;
+    return ok;
+}
+
+/*
+ * Function: write_object
+ * ----------------------
+ *  binds labels and writes program as relocatable object
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  output_stream: data writer stream
+ *  options: assembling options
+ *
+ *  returns: false if program doesn't fit ROM or has constant out of range
+ */
+static bool write_object(asm_command_t **commands, size_t n,
+        FILE *output_stream, const asm_options_t *options)
+{
+    table_t *labels = table_new();
+    table_t *builtins = init_builtins(options);
+    object_t *object = NULL;
+
+    if (builtins && resolve_label_symbols(commands, n, labels,
+                max_address(options), options)) {
+        object = generate_object(commands, n, labels, builtins, options);
+    }
+    if (object) {
+        object_write(output_stream, object);
+        object_del(object);
     }
+    if (builtins) {
+        table_del(builtins);
+    }
+    table_del(labels);
+    return object != NULL;
+}
+
+/*
+ * Function: write_program
+ * -----------------------
+ *  resolves A command operands and writes every output asked for: source
+ *  map, patch, emitters or the default output
+ *
+ *  commands: list of parsed commands
+ *  n: amount of commands
+ *  table: symbol table with builtins (and labels unless threaded)
+ *  threaded: symbols are resolved by several threads
+ *  output_stream: data writer stream (unused if options carry emitters)
+ *  options: assembling options
+ *
+ *  returns: false if any operand can't be resolved or any output can't be
+ *           written or is out of date
+ */
+static bool write_program(asm_command_t **commands, size_t n, table_t *table,
+        bool threaded, FILE *output_stream, const asm_options_t *options)
+{
+    int width = options->extended ? HACK_EXTENDED_WORD_SIZE : HACK_WORD_SIZE;
+    uint32_t *addresses;
+    emitter_t *emitter;
+    bool ok = true;
+
+    addresses = threaded
+        ? resolve_symbols_threaded(commands, n, table, options) : NULL;
+    /* serial passes report errors of the program in its order */
+    if (!addresses && (!threaded || resolve_label_symbols(commands, n, table,
+                    max_address(options), options))) {
+        addresses = intern_symbols(commands, n, table, options);
+    }
+    if (!addresses) {
+        return false;
+    }
+
+    if (options->map_stream) {
+        write_source_map(commands, n, options);
+    }
+    if (options->patch_base) {
+        ok = patch_output(commands, n, addresses, options);
+    } else if (options->outputs_n > 0) {
+        generate_hack_commands(commands, n, options->emitters,
+                options->outputs_n, addresses, options->extended);
+        if (options->check) {
+            ok = check_outputs(commands, n, options);
+        }
+    } else if (!options->mapped || !generate_hack_mapped(commands, n,
+                output_stream, addresses, options)) {
+        emitter = emitter_new(output_stream, emit_format(OUTPUT_SUFFIX),
+                width);
+        generate_hack_commands(commands, n, &emitter, 1, addresses,
+                options->extended);
+        if (!emitter_close(emitter)) {
+            fprintf(stderr, "HackAssembler: can't write output\n");
+            ok = false;
+        }
+    }
+
+    free(addresses);
+    return ok;
 }
 
 /*
  * Function: assemble
  * ------------------
  *  reads assembler commands for input stream and writes binary encodings
- *  to output stream
+ *  to output stream; errors are reported to stderr and assembling stops
+ *  at the first one, so the caller decides what to do with its outputs
  *
  *  input_stream: data reader stream
- *  output_stream: data writer stream
+ *  output_stream: data writer stream (unused if options carry emitters)
+ *  options: assembling options
+ *
+ *  returns: true if program is assembled
+ *           false if source has any error or output can't be written
  */
-void assemble(FILE *input_stream, FILE *output_stream)
+bool assemble(FILE *input_stream, FILE *output_stream,
+        const asm_options_t *options)
 {
+    size_t n;
+    asm_command_t **commands;
+    table_t *table;
+    vm_translator_t *vm = NULL;
+    bool threaded = false; /* symbols are resolved by several threads */
+    bool ok = true;
+
     /* initialize symbol table */
-    table_t *table = init_builtins();
+    if (!(table = init_builtins(options))) {
+        return false;
+    }
 
-    /* first pass: build symbol table */
-    resolve_label_symbols(input_stream, table);
+    if (options->source && vm_is_source(options->source)) {
+        /* translator binds labels itself, so there is no label pass */
+        vm = vm_translator_new(table, max_address(options));
+        if (vm_is_project(options->source)) {
+            vm_translate_project(vm, options->source);
+        } else {
+            vm_translate(vm, input_stream, options->source, NULL);
+        }
+        commands = vm_commands(vm, &n);
+        ok = !vm->failed;
+    } else {
+        /* read whole source once, then fold expressions so every pass
+         * after this one sees numbers */
+        ok = read_commands(input_stream, options, &commands, &n)
+            && fold_expressions(commands, n, table, options);
 
-    /* restore stream */
-    rewind(input_stream);
+        /* first pass: build symbol table (the optimizer may still shrink
+         * the program, so ROM size is checked on the final layout only),
+         * threads bind labels of large program together with variables */
+        threaded = !options->object && symbol_threads(n, options) > 1;
+        if (ok && !threaded) {
+            ok = resolve_label_symbols(commands, n, table,
+                    options->optimize || options->layout || options->prune
+                    || options->rewrites ? INT32_MAX : max_address(options),
+                    options);
+        }
+    }
+
+    if (ok && (options->optimize || options->layout || options->prune
+                || options->rewrites)) {
+        ok = optimize_commands(commands, &n, options);
+
+        /* moved and removed commands shifted labels, so resolve them
+         * again */
+        table_del(table);
+        table = ok ? init_builtins(options) : NULL;
+        ok = table != NULL;
+        threaded = !options->object && symbol_threads(n, options) > 1;
+        if (ok && !threaded) {
+            ok = resolve_label_symbols(commands, n, table,
+                    max_address(options), options);
+        }
+    }
 
     /* second pass: write actual code */
-    generate_hack_commands(input_stream, output_stream, table);
+    if (ok && options->object) {
+        ok = write_object(commands, n, output_stream, options);
+    } else if (ok) {
+        ok = write_program(commands, n, table, threaded, output_stream,
+                options);
+    }
+
+    if (ok && options->symbols_out
+            && !table_save(table, options->symbols_out)) {
+        fprintf(stderr, "HackAssembler: can't write %s\n",
+                options->symbols_out);
+        ok = false;
+    }
 
     /* cleanup */
-    table_del(table);
+    for (size_t i = 0; i < n; i++) {
+        command_del(commands[i]);
+    }
+    free(commands);
+    if (table) {
+        table_del(table);
+    }
+    if (vm) {
+        vm_translator_del(vm);
+    }
+    return ok;
+}
+
+/*
+ * Function: check_syntax
+ * ----------------------
+ *  checks syntax of every source without assembling it, reporting every
+ *  error with its line and column
+ *
+ *  options: assembling options
+ *
+ *  returns: true if no source has errors
+ *           false otherwise
+ */
+bool check_syntax(const asm_options_t *options)
+{
+    table_t *builtins = init_builtins(options);
+    decompress_t *decompressor;
+    size_t errors = 0;
+    FILE *stream;
+
+    if (!builtins) {
+        return false;
+    }
+
+    for (size_t i = 0; i < options->sources_n; i++) {
+        decompressor = NULL;
+        if (decompress_suffix_len(options->sources[i])) {
+            decompressor = decompress_open(options->sources[i]);
+            stream = decompressor ? decompressor->stream : NULL;
+        } else {
+            stream = fopen(options->sources[i], "r");
+        }
+        if (!stream) {
+            fprintf(stderr, "HackAssembler: can't open %s\n",
+                    options->sources[i]);
+            errors++;
+            continue;
+        }
+
+        errors += syntax_check(stream, options->sources[i], builtins,
+                max_address(options));
+
+        if (decompressor) {
+            if (!decompress_close(decompressor)) {
+                fprintf(stderr, "HackAssembler: %s is corrupted\n",
+                        options->sources[i]);
+                errors++;
+            }
+        } else {
+            fclose(stream);
+        }
+    }
+
+    table_del(builtins);
+    return errors == 0;
+}
+
+/*
+ * Function: is_source
+ * -------------------
+ *  checks wether the path names assembler source, either plain or
+ *  compressed with format supported by this build
+ *
+ *  path: file path
+ *
+ *  returns: true if path has '.asm', '.asm.gz' or '.asm.zst' suffix or
+ *           names VM code
+ *           false otherwise
+ */
+static bool is_source(const char *path)
+{
+    size_t len = strlen(path);
+    char *plain;
+    bool ok;
+
+    if (str_ends_with(path, INPUT_SUFFIX) || vm_is_source(path)) {
+        return true;
+    }
+    if (!decompress_supported(path)) {
+        return false;
+    }
+
+    plain = strndup(path, len - decompress_suffix_len(path));
+    ok = str_ends_with(plain, INPUT_SUFFIX);
+    free(plain);
+    return ok;
 }
 
 /*
  * Function: parse_args
  * --------------------
- *  parses CLI arguments and stores valid argument in source
+ *  parses CLI arguments, stores valid source arguments and fills options
  *  terminates program and writes help message if invalid arguments are passed
  *
  *  !!! user in charge of freeing stored arguments
  *
  *  argc: argument count
  *  argv: argument vector (list of arguments)
+ *  options: options to fill
  *
- *  returns: parsed source argument
+ *  returns: first parsed source argument (all of them are in options)
  */
-char *parse_args(int argc, char **argv)
+char *parse_args(int argc, char **argv, asm_options_t *options)
 {
-    if (argc != 2 || !str_ends_with(argv[1], INPUT_SUFFIX)) {
+    char *source;
+    bool vm = false;
+
+    memset(options, 0, sizeof(asm_options_t));
+    options->sources = malloc(argc * sizeof(char *));
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-O")) {
+            options->optimize = true;
+        } else if (!strcmp(argv[i], "-B")) {
+            options->layout = true;
+        } else if (!strcmp(argv[i], "-U")) {
+            options->prune = true;
+        } else if (!strcmp(argv[i], "-R") && i + 1 < argc) {
+            options->rewrites = argv[++i];
+        } else if (!strcmp(argv[i], "-m")) {
+            options->source_map = true;
+        } else if (!strcmp(argv[i], "-c")) {
+            options->object = true;
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            options->symbols_in = argv[++i];
+        } else if (!strcmp(argv[i], "-S") && i + 1 < argc) {
+            options->symbols_out = argv[++i];
+        } else if (!strcmp(argv[i], "-M")) {
+            options->mapped = true;
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc
+                && options->outputs_n < ASM_MAX_OUTPUTS
+                && emit_format(argv[i + 1])) {
+            options->outputs[options->outputs_n++] = argv[++i];
+        } else if (!strcmp(argv[i], "-X")) {
+            options->extended = true;
+        } else if (!strcmp(argv[i], "--check")) {
+            options->check = true;
+        } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            options->patch = argv[++i];
+        } else if (!strcmp(argv[i], "--apply")) {
+            options->apply = true;
+        } else if (!strcmp(argv[i], "--syntax-only")) {
+            options->syntax_only = true;
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc
+                && atoi(argv[i + 1]) > 0
+                && atoi(argv[i + 1]) <= ASM_MAX_THREADS) {
+            options->threads = atoi(argv[++i]);
+        } else if (is_source(argv[i])) {
+            options->sources[options->sources_n++] = argv[i];
+            vm = vm || vm_is_source(argv[i]);
+        } else {
+            write_help_msg();
+            exit(1);
+        }
+    }
+
+    /* batch writes default output of every source and nothing else */
+    source = options->sources_n > 0 ? options->sources[0] : NULL;
+    if (!source || (options->object && (options->source_map
+                    || options->symbols_out || options->mapped
+                    || options->extended))
+            || ((options->outputs_n > 0 || options->check)
+                && (options->object || options->mapped))
+            || (options->sources_n > 1 && (options->source_map
+                    || options->symbols_out || options->mapped
+                    || options->outputs_n > 0 || options->check))
+            || (vm && (options->optimize || options->layout
+                    || options->prune || options->rewrites
+                    || options->object))
+            || (options->prune && options->object)
+            || (options->syntax_only && (vm || options->optimize
+                    || options->layout || options->prune || options->rewrites
+                    || options->source_map || options->object
+                    || options->symbols_out || options->mapped
+                    || options->outputs_n > 0 || options->check
+                    || options->patch || options->apply))
+            || ((options->patch || options->apply) && (options->object
+                    || options->mapped || options->check
+                    || options->outputs_n > 1 || options->sources_n > 1))) {
         write_help_msg();
         exit(1);
     }
 
-    return strdup(argv[1]);
+    if (options->threads == 0) {
+        options->threads = sysconf(_SC_NPROCESSORS_ONLN);
+        if (options->threads < 1 || options->threads > ASM_MAX_THREADS) {
+            options->threads = options->threads < 1 ? 1 : ASM_MAX_THREADS;
+        }
+    }
+
+    options->source = source;
+    return strdup(source);
 }
 
 /*
  * Function: get_output
  * --------------------
- *  replaces input file extension with output file extension
+ *  replaces input file extension (including compression suffix) with
+ *  output file extension, VM project directory 'dir' gets 'dir/dir.hack'
  *
  *  source: input file path
+ *  suffix: output file extension
  *
  *  returns: output file path
  */
-char *get_output(const char *source)
+char *get_output(const char *source, const char *suffix)
 {
     size_t prefix_len, suffix_len;
-    char *source_suffix, *output;
+    char *plain, *output;
+    const char *name;
+
+    /* project output is named after its directory and placed inside */
+    if (vm_is_project(source) && (plain = realpath(source, NULL))) {
+        name = strrchr(plain, '/') + 1;
+        output = malloc(strlen(plain) + 1 + strlen(name) + strlen(suffix) + 1);
+        sprintf(output, "%s/%s%s", plain, name, suffix);
+        free(plain);
+        return output;
+    }
 
-    source_suffix = strrchr(source, '.');
-    prefix_len = source_suffix - source;
-    suffix_len = strlen(OUTPUT_SUFFIX);
+    plain = strndup(source, strlen(source) - decompress_suffix_len(source));
+    prefix_len = strrchr(plain, '.') - plain;
+    free(plain);
+    suffix_len = strlen(suffix);
     output = malloc(prefix_len + suffix_len + 1);
 
     strncpy(output, source, prefix_len);
     output[prefix_len] = '\0'; /* 'strncpy' doesn't put '\0', but it's needed
                                   for later usage of 'strcat' */
-    strcat(output, OUTPUT_SUFFIX);
+    strcat(output, suffix);
     return output;
 }
@@ -10,36 +10,114 @@
 #ifndef HACK_ASSEMBLER_H
 #define HACK_ASSEMBLER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "emit.h"
+
 #define HACK_WORD_SIZE 16
+#define HACK_LINE_SIZE (HACK_WORD_SIZE + 1) /* word and new line */
+#define HACK_MAX_ADDRESS 32767 /* largest A command operand (15 bits) */
+#define HACK_ROM_SIZE (HACK_MAX_ADDRESS + 1)
+/* extended ROM: 32 bit words, A command operand takes 31 bits and C
+ * command is its 16 bit encoding sign extended */
+#define HACK_EXTENDED_WORD_SIZE 32
+#define HACK_EXTENDED_MAX_ADDRESS INT32_MAX
+#define HACK_EXTENDED_C_PREFIX 0xFFFF0000u
 #define FIRST_FREE_ADDRESS 16
 #define INPUT_SUFFIX ".asm"
 #define OUTPUT_SUFFIX ".hack"
+#define MAP_SUFFIX ".map"
+#define OBJECT_SUFFIX ".obj"
+#define COMMANDS_INIT_CAPACITY 256
+#define ASM_MAX_THREADS 64
+#define ASM_WORDS_PER_THREAD 65536 /* smallest range worth a thread */
+#define ASM_SYMBOLS_PER_THREAD 65536 /* smallest command range worth one */
+#define ASM_USES_PER_VARIABLE 4 /* A commands per variable sizing its table */
+#define ASM_MAX_OUTPUTS 8
+
+typedef struct {
+    bool optimize;      /* run peephole optimizer before encoding */
+    bool layout;        /* lay out basic blocks for fall through */
+    bool prune;         /* drop code unreachable from address 0 */
+    const char *rewrites; /* rewrite database applied to C commands */
+    bool source_map;    /* write source map */
+    bool object;        /* write relocatable object instead of hack code */
+    const char *source; /* source path written to source map */
+    FILE *map_stream;   /* source map stream, NULL if not written */
+    const char *symbols_in;  /* symbol snapshot mapped below builtins */
+    const char *symbols_out; /* path to save final symbol table to */
+    bool mapped;  /* fill presized mapped output instead of stdio */
+    int threads;  /* threads resolving symbols and filling mapped output */
+    const char *outputs[ASM_MAX_OUTPUTS]; /* '-o' paths, suffix is format */
+    size_t outputs_n;
+    emitter_t *emitters[ASM_MAX_OUTPUTS]; /* emitters of outputs */
+    bool check;   /* compare outputs with existing files, write nothing */
+    bool extended; /* 32 bit words for programs past HACK_ROM_SIZE */
+    char **sources;    /* every source given (more than one means batch) */
+    size_t sources_n;
+    const char *patch; /* path of patch against previous build (or NULL) */
+    bool apply;        /* update previous build in place */
+    const char *patch_base; /* image of previous build (set by caller) */
+    bool syntax_only;  /* only report errors of sources, write nothing */
+} asm_options_t;
 
 /*
  * Function: assemble
  * ------------------
  *  reads assembler commands for input stream and writes binary encodings
- *  to output stream
+ *  to output stream; errors are reported to stderr and assembling stops
+ *  at the first one, so the caller decides what to do with its outputs
  *
  *  input_stream: data reader stream
- *  output_stream: data writer stream
+ *  output_stream: data writer stream (unused if options carry emitters)
+ *  options: assembling options
+ *
+ *  returns: true if program is assembled
+ *           false if source has any error or output can't be written
+ */
+bool assemble(FILE *input_stream, FILE *output_stream,
+        const asm_options_t *options);
+
+/*
+ * Function: check_syntax
+ * ----------------------
+ *  checks syntax of every source without assembling it, reporting every
+ *  error with its line and column
+ *
+ *  options: assembling options
+ *
+ *  returns: true if no source has errors
+ *           false otherwise
+ */
+bool check_syntax(const asm_options_t *options);
+
+/*
+ * Function: write_hack_command
+ * ----------------------------
+ *  writes 'code' to the stream as sequence of 0's and 1's
+ *
+ *  stream: writable stream
+ *  code: hack command code
  */
-void assemble(FILE *input_stream, FILE *output_stream);
+void write_hack_command(FILE *stream, uint16_t code);
 
 /*
  * Function: parse_args
  * --------------------
- *  parses CLI arguments and stores valid argument in source
+ *  parses CLI arguments, stores valid source arguments and fills options
  *  terminates program and writes help message if invalid arguments are passed
  *
  *  !!! user in charge of freeing stored arguments
  *
  *  argc: argument count
  *  argv: argument vector (list of arguments)
+ *  options: options to fill
  *
- *  returns: parsed source argument
+ *  returns: first parsed source argument (all of them are in options)
  */
-char *parse_args(int argc, char **argv);
+char *parse_args(int argc, char **argv, asm_options_t *options);
 
 /*
  * Function: get_output_name
@@ -47,9 +125,10 @@ char *parse_args(int argc, char **argv);
  *  replaces input file extension with output file extension
  *
  *  source: input file path
+ *  suffix: output file extension
  *
  *  returns: output file path
  */
-char *get_output(const char *source);
+char *get_output(const char *source, const char *suffix);
 
 #endif // !HACK_ASSEMBLER_H
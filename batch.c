@@ -0,0 +1,447 @@
+/*
+ * File: batch.c
+ * -------------
+ *  assembles many sources in one run, batching their file I/O on io_uring
+ *  when liburing is available
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HACK_ASM_URING
+#include <liburing.h>
+#endif
+
+#include "assembler.h"
+#include "batch.h"
+#include "decompress.h"
+#include "helpers.h"
+#include "vm.h"
+
+/*
+ * Function: output_suffix
+ * -----------------------
+ *  finds suffix of outputs written with given options
+ *
+ *  options: assembling options
+ *
+ *  returns: '.obj' for relocatable objects, '.hack' otherwise
+ */
+static const char *output_suffix(const asm_options_t *options)
+{
+    return options->object ? OBJECT_SUFFIX : OUTPUT_SUFFIX;
+}
+
+/*
+ * Function: assemble_file
+ * -----------------------
+ *  assembles single source through stdio streams; output is written
+ *  aside and replaces the previous one only once the source assembles
+ *  and turns out intact, so failed source leaves it alone
+ *
+ *  source: source path (plain or compressed) or VM project directory
+ *  options: assembling options
+ *
+ *  returns: false if the source can't be read or assembled, or output
+ *           can't be written (reported)
+ */
+static bool assemble_file(const char *source, const asm_options_t *options)
+{
+    asm_options_t file_options = *options;
+    char *output = get_output(source, output_suffix(options));
+    char *staged;
+    decompress_t *decompressor = NULL;
+    FILE *input_stream, *output_stream;
+    bool ok;
+
+    if (decompress_suffix_len(source)) {
+        decompressor = decompress_open(source);
+        input_stream = decompressor ? decompressor->stream : NULL;
+    } else if (vm_is_project(source)) {
+        input_stream = NULL;
+    } else {
+        input_stream = fopen(source, "r");
+    }
+    if (!input_stream && !vm_is_project(source)) {
+        fprintf(stderr, "HackAssembler: can't open %s\n", source);
+        if (decompressor) {
+            decompress_close(decompressor);
+        }
+        free(output);
+        return false;
+    }
+    /* small source is inflated already, broken one writes nothing */
+    if (decompressor && !decompressor->threaded && !decompressor->ok) {
+        fprintf(stderr, "HackAssembler: %s is corrupted\n", source);
+        decompress_close(decompressor);
+        free(output);
+        return false;
+    }
+    staged = staged_path(output);
+    if (!(output_stream = fopen(staged,
+                    options->object ? "wb" : "w"))) {
+        fprintf(stderr, "HackAssembler: can't open %s\n", output);
+        if (decompressor) {
+            decompress_close(decompressor);
+        } else if (input_stream) {
+            fclose(input_stream);
+        }
+        free(staged);
+        free(output);
+        return false;
+    }
+
+    file_options.source = source;
+    ok = assemble(input_stream, output_stream, &file_options);
+
+    if (decompressor) {
+        if (!decompress_close(decompressor)) {
+            fprintf(stderr, "HackAssembler: %s is corrupted\n", source);
+            ok = false;
+        }
+    } else if (input_stream) {
+        fclose(input_stream);
+    }
+    if (fclose(output_stream) || (ok && rename(staged, output))) {
+        fprintf(stderr, "HackAssembler: can't write %s\n", output);
+        ok = false;
+    }
+    if (!ok) {
+        remove(staged);
+    }
+    free(staged);
+    free(output);
+    return ok;
+}
+
+#ifdef HACK_ASM_URING
+typedef enum {
+    BATCH_OPEN_IN,
+    BATCH_READ,
+    BATCH_CLOSE_IN,
+    BATCH_OPEN_OUT,
+    BATCH_WRITE,
+    BATCH_CLOSE_OUT
+} batch_stage_t;
+
+/* every file has at most one operation in flight, its stage tells which */
+typedef struct {
+    const char *source;
+    char *output;
+    char *staged;       /* output is written here, renamed once closed */
+    batch_stage_t stage;
+    int fd;
+    char *text;         /* source text read so far */
+    size_t text_len;
+    size_t capacity;
+    char *code;         /* assembled output */
+    size_t code_len;
+    size_t written;
+    bool failed;        /* source or its output had an error (reported) */
+    bool done;          /* job has no operation left */
+} batch_job_t;
+
+/*
+ * Function: encode_job
+ * --------------------
+ *  assembles source text of the job into memory, failed job never opens
+ *  its output
+ *
+ *  job: job with whole source read
+ *  options: assembling options
+ */
+static void encode_job(batch_job_t *job, const asm_options_t *options)
+{
+    asm_options_t file_options = *options;
+    FILE *input_stream = fmemopen(job->text, job->text_len, "r");
+    FILE *output_stream = open_memstream(&job->code, &job->code_len);
+
+    file_options.source = job->source;
+    job->failed = !assemble(input_stream, output_stream, &file_options);
+
+    fclose(input_stream);
+    fclose(output_stream);
+    free(job->text);
+    job->text = NULL;
+}
+
+/*
+ * Function: queue_job
+ * -------------------
+ *  queues operation of the current stage of the job
+ *
+ *  ring: ring to queue on (has room, jobs in flight never exceed its depth)
+ *  job: job to advance
+ */
+static void queue_job(struct io_uring *ring, batch_job_t *job)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+
+    switch (job->stage) {
+        case BATCH_OPEN_IN:
+            io_uring_prep_openat(sqe, AT_FDCWD, job->source, O_RDONLY, 0);
+            break;
+        case BATCH_READ:
+            if (job->text_len == job->capacity) {
+                job->capacity = job->capacity
+                    ? 2 * job->capacity : BATCH_READ_SIZE;
+                job->text = realloc(job->text, job->capacity);
+            }
+            io_uring_prep_read(sqe, job->fd, job->text + job->text_len,
+                    job->capacity - job->text_len, job->text_len);
+            break;
+        case BATCH_CLOSE_IN:
+        case BATCH_CLOSE_OUT:
+            io_uring_prep_close(sqe, job->fd);
+            break;
+        case BATCH_OPEN_OUT:
+            io_uring_prep_openat(sqe, AT_FDCWD, job->staged,
+                    O_WRONLY | O_CREAT | O_TRUNC, 0666);
+            break;
+        case BATCH_WRITE:
+            io_uring_prep_write(sqe, job->fd, job->code + job->written,
+                    job->code_len - job->written, job->written);
+            break;
+    }
+
+    io_uring_sqe_set_data(sqe, job);
+}
+
+/*
+ * Function: finish_job
+ * --------------------
+ *  frees buffers of the job that has no operation left, staged output
+ *  that wasn't renamed over the output is removed
+ *
+ *  job: finished job
+ *
+ *  returns: true
+ */
+static bool finish_job(batch_job_t *job)
+{
+    free(job->text);
+    free(job->code);
+    /* staged output exists once its open succeeded */
+    if (job->staged && job->stage >= BATCH_WRITE) {
+        remove(job->staged);
+    }
+    free(job->output);
+    free(job->staged);
+    job->text = job->code = job->output = job->staged = NULL;
+    job->done = true;
+    return true;
+}
+
+/*
+ * Function: complete_job
+ * ----------------------
+ *  moves job to its next stage after an operation completed, failed
+ *  operation fails the job: its open file is still closed, the rest of
+ *  its stages is skipped; staged output replaces the output only once it
+ *  is closed intact
+ *
+ *  job: job whose operation completed
+ *  res: result of the operation
+ *  options: assembling options
+ *
+ *  returns: true if the job is finished
+ *           false if it has next operation to queue
+ */
+static bool complete_job(batch_job_t *job, int res,
+        const asm_options_t *options)
+{
+    static const char *verbs[] = {
+        "open", "read", "close", "open", "write", "close"
+    };
+
+    if (res < 0 || (job->stage == BATCH_WRITE && res == 0)) {
+        fprintf(stderr, "HackAssembler: can't %s %s\n", verbs[job->stage],
+                job->stage <= BATCH_CLOSE_IN ? job->source : job->output);
+        job->failed = true;
+        if (job->stage == BATCH_READ || job->stage == BATCH_WRITE) {
+            job->stage++;
+            return false;
+        }
+        return finish_job(job);
+    }
+
+    switch (job->stage) {
+        case BATCH_OPEN_IN:
+            job->fd = res;
+            job->stage = BATCH_READ;
+            break;
+        case BATCH_READ:
+            job->text_len += res;
+            /* reads may come back short, only empty one ends the file:
+             * assemble it while its close is in flight */
+            if (res == 0) {
+                encode_job(job, options);
+                job->stage = BATCH_CLOSE_IN;
+            }
+            break;
+        case BATCH_CLOSE_IN:
+            /* failed source leaves its previous output alone */
+            if (job->failed) {
+                return finish_job(job);
+            }
+            job->stage = BATCH_OPEN_OUT;
+            break;
+        case BATCH_OPEN_OUT:
+            job->fd = res;
+            job->stage = job->code_len ? BATCH_WRITE : BATCH_CLOSE_OUT;
+            break;
+        case BATCH_WRITE:
+            job->written += res;
+            if (job->written == job->code_len) {
+                job->stage = BATCH_CLOSE_OUT;
+            }
+            break;
+        case BATCH_CLOSE_OUT:
+            /* failed write leaves its previous output alone */
+            if (!job->failed && rename(job->staged, job->output)) {
+                fprintf(stderr, "HackAssembler: can't write %s\n",
+                        job->output);
+                job->failed = true;
+            } else if (!job->failed) {
+                free(job->staged);
+                job->staged = NULL;
+            }
+            return finish_job(job);
+    }
+
+    return false;
+}
+
+/*
+ * Function: batch_uring
+ * ---------------------
+ *  assembles sources with their file operations batched on io_uring,
+ *  compressed sources and VM projects are assembled through stdio
+ *
+ *  failed source doesn't stop the others; if the ring itself fails,
+ *  operations in flight are cancelled and every unfinished source is
+ *  assembled through stdio instead
+ *
+ *  sources: list of source paths
+ *  n: amount of sources
+ *  options: assembling options
+ *  ok_ptr: false if any source failed
+ *
+ *  returns: true if sources are assembled
+ *           false if io_uring isn't available (nothing is done then)
+ */
+static bool batch_uring(char **sources, size_t n,
+        const asm_options_t *options, bool *ok_ptr)
+{
+    struct io_uring ring;
+    struct io_uring_cqe *cqe;
+    batch_job_t *jobs, *job;
+    size_t next = 0, active = 0;
+    bool ok = true, broken = false;
+    int res;
+
+    if (io_uring_queue_init(BATCH_QUEUE_DEPTH, &ring, 0) < 0) {
+        return false;
+    }
+    jobs = calloc(n, sizeof(batch_job_t));
+
+    while (!broken && (next < n || active > 0)) {
+        /* keep queue full of files */
+        while (next < n && active < BATCH_QUEUE_DEPTH) {
+            job = &jobs[next];
+            job->source = sources[next++];
+            if (decompress_suffix_len(job->source)
+                    || vm_is_project(job->source)) {
+                job->failed = !assemble_file(job->source, options);
+                job->done = true;
+                continue;
+            }
+            job->output = get_output(job->source, output_suffix(options));
+            job->staged = staged_path(job->output);
+            job->stage = BATCH_OPEN_IN;
+            queue_job(&ring, job);
+            active++;
+        }
+        if (active == 0) {
+            break;
+        }
+
+        /* single system call submits operations of every file in flight,
+         * busy ring is retried once its completions are reaped */
+        res = io_uring_submit_and_wait(&ring, 1);
+        if (res < 0 && res != -EINTR && res != -EAGAIN && res != -EBUSY) {
+            fprintf(stderr, "HackAssembler: io_uring: %s\n", strerror(-res));
+            broken = true;
+        }
+
+        while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+            job = io_uring_cqe_get_data(cqe);
+            res = cqe->res;
+            io_uring_cqe_seen(&ring, cqe);
+
+            if (complete_job(job, res, options)) {
+                active--;
+            } else {
+                queue_job(&ring, job);
+            }
+        }
+    }
+
+    /* tearing the ring down cancels and waits for operations in flight */
+    io_uring_queue_exit(&ring);
+    for (size_t i = 0; i < n; i++) {
+        job = &jobs[i];
+        if (i < next && !job->done) {
+            /* descriptors are only known open between their open and
+             * close operations */
+            if (job->stage == BATCH_READ || job->stage == BATCH_WRITE) {
+                close(job->fd);
+            }
+            finish_job(job);
+            job->failed = !assemble_file(job->source, options);
+        } else if (i >= next) {
+            job->failed = !assemble_file(sources[i], options);
+        }
+        ok = ok && !job->failed;
+    }
+
+    free(jobs);
+    *ok_ptr = ok;
+    return true;
+}
+#endif
+
+/*
+ * Function: batch_assemble
+ * ------------------------
+ *  assembles every source into output next to it, source that fails
+ *  leaves its previous output alone and doesn't stop the others
+ *
+ *  sources: list of source paths
+ *  n: amount of sources
+ *  options: assembling options shared by all sources
+ *
+ *  returns: true if every source is assembled
+ *           false if any source can't be read, assembled or written
+ */
+bool batch_assemble(char **sources, size_t n, const asm_options_t *options)
+{
+    bool ok = true;
+
+#ifdef HACK_ASM_URING
+    if (batch_uring(sources, n, options, &ok)) {
+        return ok;
+    }
+#endif
+    for (size_t i = 0; i < n; i++) {
+        if (!assemble_file(sources[i], options)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
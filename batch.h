@@ -0,0 +1,39 @@
+/*
+ * File: batch.h
+ * -------------
+ *  constants and function declarations for batch module
+ *
+ *  assembles many sources in one run; with liburing (HACK_ASM_URING)
+ *  opens, reads, writes and closes of all files are queued on single
+ *  io_uring, so every submission carries operations of many files and
+ *  each source is assembled as soon as its read completes, otherwise
+ *  (or if the kernel refuses io_uring) files go one by one through stdio
+ */
+
+#ifndef HACK_ASM_BATCH_H
+#define HACK_ASM_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "assembler.h"
+
+#define BATCH_QUEUE_DEPTH 64         /* files in flight at once */
+#define BATCH_READ_SIZE (64 * 1024)  /* first read, doubled for larger files */
+
+/*
+ * Function: batch_assemble
+ * ------------------------
+ *  assembles every source into output next to it, source that fails
+ *  leaves its previous output alone and doesn't stop the others
+ *
+ *  sources: list of source paths
+ *  n: amount of sources
+ *  options: assembling options shared by all sources
+ *
+ *  returns: true if every source is assembled
+ *           false if any source can't be read, assembled or written
+ */
+bool batch_assemble(char **sources, size_t n, const asm_options_t *options);
+
+#endif // !HACK_ASM_BATCH_H
@@ -0,0 +1,291 @@
+/*
+ * File: benchmark.c
+ * -----------------
+ *  entry point for hack symbol table benchmark program
+ *
+ *  measures insert and lookup throughput of the single threaded symbol
+ *  table and of the concurrent one with growing amount of threads, then
+ *  checks that threads racing on equal keys leave the same values as a
+ *  single thread would
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ctable.h"
+#include "table.h"
+
+#define BENCHMARK_SYMBOLS 50000
+#define BENCHMARK_LOOKUPS 8 /* lookups of every symbol per insert */
+#define BENCHMARK_MAX_THREADS 64
+
+typedef struct {
+    ctable_t *table;
+    char **symbols;
+    size_t begin;    /* first symbol of the range */
+    size_t end;      /* symbol after the range */
+    size_t n;        /* amount of all symbols */
+    int lookups;
+    bool contended;  /* insert every symbol, not just the range */
+    uint64_t found;  /* lookups that found their symbol */
+} benchmark_job_t;
+
+/*
+ * Function: write_help_msg
+ * ------------------------
+ *  writes help message for HackBenchmark user
+ */
+static void write_help_msg(void)
+{
+    printf("\nUsage: HackBenchmark [-n symbols] [-l lookups] [-j threads]\n\n"
+           "Measure symbol table throughput on 1, 2, 4... threads.\n\n"
+           "Arguments:\n"
+           "-n symbols\t\tdistinct symbols inserted (default: %d)\n"
+           "-l lookups\t\tlookups of every symbol (default: %d)\n"
+           "-j threads\t\tlargest amount of threads (default: 8)\n\n",
+           BENCHMARK_SYMBOLS, BENCHMARK_LOOKUPS);
+}
+
+/*
+ * Function: now
+ * -------------
+ *  reads monotonic clock
+ *
+ *  returns: seconds since unspecified point
+ */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Function: insert_thread
+ * -----------------------
+ *  thread routine inserting its range of symbols (or all of them when
+ *  contended) with their index as value, smaller index winning
+ *
+ *  arg: benchmark job
+ *
+ *  returns: NULL
+ */
+static void *insert_thread(void *arg)
+{
+    benchmark_job_t *job = arg;
+    size_t begin = job->contended ? 0 : job->begin;
+    size_t end = job->contended ? job->n : job->end;
+
+    for (size_t i = begin; i < end; i++) {
+        /* contended threads walk the symbols from different starts */
+        size_t k = job->contended ? (i + job->begin) % job->n : i;
+        ctable_put(job->table, job->symbols[k], k, CTABLE_MIN);
+    }
+
+    return NULL;
+}
+
+/*
+ * Function: lookup_thread
+ * -----------------------
+ *  thread routine looking up its range of symbols
+ *
+ *  arg: benchmark job
+ *
+ *  returns: NULL
+ */
+static void *lookup_thread(void *arg)
+{
+    benchmark_job_t *job = arg;
+
+    for (int r = 0; r < job->lookups; r++) {
+        for (size_t i = job->begin; i < job->end; i++) {
+            job->found += ctable_get(job->table, job->symbols[i]) >= 0;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Function: run_threads
+ * ---------------------
+ *  runs routine on every job, each in its own thread
+ *
+ *  jobs: list of jobs
+ *  threads_n: amount of jobs
+ *  routine: thread routine
+ *
+ *  returns: seconds it took
+ */
+static double run_threads(benchmark_job_t *jobs, size_t threads_n,
+        void *(*routine)(void *))
+{
+    pthread_t threads[BENCHMARK_MAX_THREADS];
+    double start = now();
+
+    for (size_t t = 0; t < threads_n; t++) {
+        pthread_create(&threads[t], NULL, routine, &jobs[t]);
+    }
+    for (size_t t = 0; t < threads_n; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    return now() - start;
+}
+
+/*
+ * Function: bench_table
+ * ---------------------
+ *  measures single threaded symbol table
+ *
+ *  symbols: list of distinct symbols
+ *  n: amount of symbols
+ *  lookups: lookups of every symbol
+ */
+static void bench_table(char **symbols, size_t n, int lookups)
+{
+    table_t *table = table_new();
+    uint64_t found = 0;
+    double start, insert, lookup;
+
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+        table_add(table, symbols[i], i);
+    }
+    insert = now() - start;
+
+    start = now();
+    for (int r = 0; r < lookups; r++) {
+        for (size_t i = 0; i < n; i++) {
+            found += table_get(table, symbols[i]) >= 0;
+        }
+    }
+    lookup = now() - start;
+
+    printf("%-8s %7d %14.2f %14.2f %14s %s\n", "table", 1,
+            n / insert / 1e6, (double) n * lookups / lookup / 1e6, "-",
+            found == (uint64_t) n * lookups ? "ok" : "MISSING");
+    table_del(table);
+}
+
+/*
+ * Function: bench_ctable
+ * ----------------------
+ *  measures concurrent symbol table on given amount of threads: disjoint
+ *  inserts, lookups and contended inserts of every symbol by every thread
+ *
+ *  symbols: list of distinct symbols
+ *  n: amount of symbols
+ *  lookups: lookups of every symbol
+ *  threads_n: amount of threads
+ *
+ *  returns: true if every thread found every symbol and contended inserts
+ *           left the smallest index of every symbol
+ *           false otherwise
+ */
+static bool bench_ctable(char **symbols, size_t n, int lookups,
+        size_t threads_n)
+{
+    benchmark_job_t jobs[BENCHMARK_MAX_THREADS];
+    ctable_t *table = ctable_new(n);
+    double insert, lookup, contended;
+    uint64_t found = 0;
+    bool ok = true;
+
+    for (size_t t = 0; t < threads_n; t++) {
+        jobs[t].table = table;
+        jobs[t].symbols = symbols;
+        jobs[t].begin = n * t / threads_n;
+        jobs[t].end = n * (t + 1) / threads_n;
+        jobs[t].n = n;
+        jobs[t].lookups = lookups;
+        jobs[t].contended = false;
+        jobs[t].found = 0;
+    }
+    insert = run_threads(jobs, threads_n, insert_thread);
+    lookup = run_threads(jobs, threads_n, lookup_thread);
+    for (size_t t = 0; t < threads_n; t++) {
+        found += jobs[t].found;
+    }
+    ok = found == (uint64_t) n * lookups && table->size == n;
+    ctable_del(table);
+
+    /* every thread inserts every symbol, only the smallest index stays */
+    table = ctable_new(n);
+    for (size_t t = 0; t < threads_n; t++) {
+        jobs[t].table = table;
+        jobs[t].contended = true;
+    }
+    contended = run_threads(jobs, threads_n, insert_thread);
+    for (size_t i = 0; ok && i < n; i++) {
+        ok = ctable_get(table, symbols[i]) == (int32_t) i;
+    }
+    ok = ok && table->size == n;
+    ctable_del(table);
+
+    printf("%-8s %7zu %14.2f %14.2f %14.2f %s\n", "ctable", threads_n,
+            n / insert / 1e6, (double) n * lookups / lookup / 1e6,
+            (double) n * threads_n / contended / 1e6, ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+/*
+ * Function: main
+ * --------------
+ *  runs the benchmark
+ *
+ *  returns: 0 if every table kept its entries, 1 otherwise
+ */
+int main(int argc, char **argv)
+{
+    size_t n = BENCHMARK_SYMBOLS, max_threads = 8;
+    int lookups = BENCHMARK_LOOKUPS;
+    char buffer[48];
+    char **symbols;
+    bool ok = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc
+                && atol(argv[i + 1]) > 0 && atol(argv[i + 1]) <= INT32_MAX) {
+            n = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "-l") && i + 1 < argc
+                && atoi(argv[i + 1]) > 0) {
+            lookups = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc
+                && atoi(argv[i + 1]) > 0
+                && atoi(argv[i + 1]) <= BENCHMARK_MAX_THREADS) {
+            max_threads = atoi(argv[++i]);
+        } else {
+            write_help_msg();
+            exit(1);
+        }
+    }
+
+    /* label-like names sharing long prefixes */
+    symbols = malloc(n * sizeof(char *));
+    for (size_t i = 0; i < n; i++) {
+        snprintf(buffer, sizeof(buffer), "Main.loop$label.%zu", i);
+        symbols[i] = strdup(buffer);
+    }
+
+    printf("%zu symbols, %d lookups each, Mops/s\n", n, lookups);
+    printf("%-8s %7s %14s %14s %14s\n", "table", "threads", "insert",
+            "lookup", "contended");
+    bench_table(symbols, n, lookups);
+    for (size_t t = 1; t <= max_threads; t *= 2) {
+        ok = bench_ctable(symbols, n, lookups, t) && ok;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        free(symbols[i]);
+    }
+    free(symbols);
+    return ok ? 0 : 1;
+}
@@ -4,8 +4,40 @@
  *  translates Hack Assembly language mnemonics into binary codes
  */
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "code.h"
+
+/* most frequent commands of compiled programs */
+static const char *seeds[] = {
+    "D=M", "M=D", "D=A", "A=M", "0;JMP", "AM=M-1", "M=M+1", "M=M-1",
+    "D=D+A", "D=D-A", "A=A+1", "A=A-1", "D;JEQ", "D;JNE", "D;JGT", "D;JLT",
+    "D;JGE", "D;JLE", "M=D+M", "M=M-D", "D=D-M", "D=D+M", "M=-1", "M=0",
+    "M=!M", "M=-M", "D=-1", "D=0", "D=D+1", "D=D-1", "A=D", "MD=M+1"
+};
+
+/* every mnemonic encode_comp and encode_jump know, anything else is
+ * silently encoded as their last row */
+static const char *comps[] = {
+    "0", "1", "-1", "D", "A", "M", "!D", "!A", "!M", "-D", "-A", "-M",
+    "D+1", "A+1", "M+1", "D-1", "A-1", "M-1", "D+A", "D+M", "D-A", "D-M",
+    "A-D", "M-D", "D&A", "D&M", "D|A", "D|M"
+};
+static const char *jumps[] = {
+    "JGT", "JEQ", "JGE", "JLT", "JNE", "JLE", "JMP"
+};
+/* 'dest' mnemonics in canonical order, indexed by their encoding */
+static const char *dests[] = {
+    NULL, "M", "D", "MD", "A", "AM", "AD", "AMD"
+};
+
+static _Thread_local code_cache_entry_t cache[CODE_CACHE_SIZE];
+static _Thread_local size_t cache_n = 0;
+static _Thread_local bool cache_seeded = false;
+
 /*
  * Function: encode_dest
  * ---------------------
@@ -24,11 +56,11 @@
  *
  *  dest: symbolic 'dest' part of C command
  *
- *  returns: dest encoded as short int
+ *  returns: dest encoded as 16 bit word
  */
-short encode_dest(const char *dest)
+uint16_t encode_dest(const char *dest)
 {
-    short code = 0;
+    uint16_t code = 0;
 
     if (!dest) {
         return code;
@@ -73,9 +105,9 @@ short encode_dest(const char *dest)
  *
  *  comp: symbolic 'comp' part of C command
  *
- *  returns: comp encoded as short int
+ *  returns: comp encoded as 16 bit word
  */
-short encode_comp(const char *comp)
+uint16_t encode_comp(const char *comp)
 {
     if (!strcmp(comp, "0")) {
         return 0x2A; /* 0010 1010 */
@@ -153,9 +185,9 @@ short encode_comp(const char *comp)
  *
  *  jump: symbolic 'jump' part of C command
  *
- *  returns: jump encoded as short int
+ *  returns: jump encoded as 16 bit word
  */
-short encode_jump(const char *jump)
+uint16_t encode_jump(const char *jump)
 {
     if (!jump) {
         return 0; /* 000 */
@@ -193,13 +225,13 @@ short encode_jump(const char *jump)
  *  comp: symbolic 'comp' part of C command
  *  jump: symbolic 'jump' part of C command
  *
- *  returns: C command encoded as short int
+ *  returns: C command encoded as 16 bit word
  */
-short encode_command(const char *dest, const char *comp, const char *jump)
+uint16_t encode_command(const char *dest, const char *comp, const char *jump)
 {
     /* C command always has its 3 most significant bits set to '1'
      * so initial value should be 1110 0000 0000 0000 in binary */
-    short code = 0xE000;
+    uint16_t code = 0xE000;
 
     /* bits representic 'comp' mnemonic have offset of 6
      * according to specification */
@@ -214,3 +246,223 @@ short encode_command(const char *dest, const char *comp, const char *jump)
 
     return code;
 }
+
+/*
+ * Function: find_mnemonic
+ * -----------------------
+ *  searches list of mnemonics
+ *
+ *  mnemonics: list of mnemonics
+ *  n: amount of mnemonics
+ *  s: mnemonic to find
+ *
+ *  returns: true if the list has the mnemonic
+ *           false otherwise
+ */
+static bool find_mnemonic(const char **mnemonics, size_t n, const char *s)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!strcmp(mnemonics[i], s)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Function: valid_dest
+ * --------------------
+ *  checks 'dest' mnemonic: any non empty combination of A, D and M, each
+ *  register at most once
+ *
+ *  dest: symbolic 'dest' part of C command
+ *
+ *  returns: true if encode_dest encodes the mnemonic as written
+ *           false otherwise
+ */
+bool valid_dest(const char *dest)
+{
+    int seen = 0, bit;
+
+    for (const char *p = dest; *p; p++) {
+        bit = *p == 'A' ? 4 : *p == 'D' ? 2 : *p == 'M' ? 1 : 0;
+        if (!bit || (seen & bit)) {
+            return false;
+        }
+        seen |= bit;
+    }
+
+    return seen != 0;
+}
+
+/*
+ * Function: valid_comp
+ * --------------------
+ *  checks 'comp' mnemonic against the table of encode_comp
+ *
+ *  comp: symbolic 'comp' part of C command
+ *
+ *  returns: true if encode_comp knows the mnemonic
+ *           false otherwise
+ */
+bool valid_comp(const char *comp)
+{
+    return find_mnemonic(comps, sizeof(comps) / sizeof(comps[0]), comp);
+}
+
+/*
+ * Function: valid_jump
+ * --------------------
+ *  checks 'jump' mnemonic against the table of encode_jump
+ *
+ *  jump: symbolic 'jump' part of C command
+ *
+ *  returns: true if encode_jump knows the mnemonic
+ *           false otherwise
+ */
+bool valid_jump(const char *jump)
+{
+    return find_mnemonic(jumps, sizeof(jumps) / sizeof(jumps[0]), jump);
+}
+
+/*
+ * Function: comp_mnemonic
+ * -----------------------
+ *  lists 'comp' mnemonics encode_comp knows
+ *
+ *  i: index of the mnemonic
+ *
+ *  returns: i-th mnemonic
+ *           NULL if there are no more mnemonics
+ */
+const char *comp_mnemonic(size_t i)
+{
+    return i < sizeof(comps) / sizeof(comps[0]) ? comps[i] : NULL;
+}
+
+/*
+ * Function: dest_mnemonic
+ * -----------------------
+ *  spells 'dest' encoding as canonical mnemonic
+ *
+ *  code: 3 bit 'dest' encoding
+ *
+ *  returns: mnemonic
+ *           NULL for null 'dest'
+ */
+const char *dest_mnemonic(uint16_t code)
+{
+    return dests[code & 7];
+}
+
+/*
+ * Function: hash_text
+ * -------------------
+ *  hashing function for cached command texts
+ *
+ *  text: text to hash
+ *
+ *  returns: slot index of the text
+ */
+static size_t hash_text(const char *text)
+{
+    uint32_t h = 2166136261u; /* FNV-1a */
+
+    for (const char *p = text; *p; p++) {
+        h = (h ^ (unsigned char) *p) * 16777619u;
+    }
+
+    return h & (CODE_CACHE_SIZE - 1);
+}
+
+/*
+ * Function: encode_text
+ * ---------------------
+ *  splits C command text into fields the same way the parser does and
+ *  encodes it into entry
+ *
+ *  entry: entry with text set
+ *
+ *  returns: true if text has '=' or ';'
+ *           false otherwise
+ */
+static bool encode_text(code_cache_entry_t *entry)
+{
+    char dest[CODE_CACHE_TEXT_MAX], comp[CODE_CACHE_TEXT_MAX];
+    char *eq = strchr(entry->text, '=');
+    char *semi = strchr(entry->text, ';');
+
+    if (!eq && !semi) {
+        return false;
+    }
+
+    entry->eq = eq ? eq - entry->text : CODE_CACHE_NONE;
+    entry->semi = semi ? semi - entry->text : CODE_CACHE_NONE;
+
+    /* 'dest=comp' takes whole rest as comp, 'comp;jump' cuts at ';' */
+    if (eq) {
+        memcpy(dest, entry->text, eq - entry->text);
+        dest[eq - entry->text] = '\0';
+        strcpy(comp, eq + 1);
+    } else {
+        memcpy(comp, entry->text, semi - entry->text);
+        comp[semi - entry->text] = '\0';
+    }
+
+    entry->code = encode_command(eq ? dest : NULL, comp,
+            semi ? semi + 1 : NULL);
+    return true;
+}
+
+/*
+ * Function: encode_cached
+ * -----------------------
+ *  finds encoding of C command by its raw text, splitting and encoding
+ *  it only the first time the text is seen by the calling thread
+ *
+ *  cache is per thread and pre-seeded with the most common commands
+ *
+ *  text: whitespace stripped C command
+ *
+ *  returns: pointer to cache entry (valid until next call)
+ *           NULL if text can't be cached
+ */
+const code_cache_entry_t *encode_cached(const char *text)
+{
+    static _Thread_local code_cache_entry_t scratch;
+    size_t h;
+
+    if (!cache_seeded) {
+        cache_seeded = true;
+        for (size_t i = 0; i < sizeof(seeds) / sizeof(seeds[0]); i++) {
+            encode_cached(seeds[i]);
+        }
+    }
+
+    if (strlen(text) >= CODE_CACHE_TEXT_MAX) {
+        return NULL;
+    }
+
+    /* linear probing, empty slot has empty text */
+    h = hash_text(text);
+    for (; cache[h].text[0]; h = (h + 1) & (CODE_CACHE_SIZE - 1)) {
+        if (!strcmp(cache[h].text, text)) {
+            return &cache[h];
+        }
+    }
+
+    /* keep table sparse, overflowing texts are encoded but not kept */
+    if (4 * (cache_n + 1) > 3 * CODE_CACHE_SIZE) {
+        strcpy(scratch.text, text);
+        return encode_text(&scratch) ? &scratch : NULL;
+    }
+
+    strcpy(cache[h].text, text);
+    if (!encode_text(&cache[h])) {
+        cache[h].text[0] = '\0';
+        return NULL;
+    }
+    cache_n++;
+    return &cache[h];
+}
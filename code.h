@@ -9,6 +9,21 @@
 #ifndef HACK_ASM_CODE_H
 #define HACK_ASM_CODE_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CODE_CACHE_SIZE 512    /* slots, power of 2 */
+#define CODE_CACHE_TEXT_MAX 16 /* longest valid command is 'AMD=D|M;JMP' */
+#define CODE_CACHE_NONE -1     /* position of missing '=' or ';' */
+
+typedef struct {
+    char text[CODE_CACHE_TEXT_MAX]; /* whitespace stripped C command */
+    int8_t eq;                      /* position of '=' */
+    int8_t semi;                    /* position of ';' */
+    uint16_t code;                  /* encoded command */
+} code_cache_entry_t;
+
 /*
  * Function: encode_dest
  * ---------------------
@@ -16,9 +31,9 @@
  *
  *  dest: symbolic 'dest' part of C command
  *
- *  returns: dest encoded as short int
+ *  returns: dest encoded as 16 bit word
  */
-short encode_dest(const char *dest);
+uint16_t encode_dest(const char *dest);
 
 /* Function: encode_comp
  * ---------------------
@@ -26,9 +41,9 @@ short encode_dest(const char *dest);
  *
  *  comp: symbolic 'comp' part of C command
  *
- *  returns: comp encoded as short int
+ *  returns: comp encoded as 16 bit word
  */
-short encode_comp(const char *comp);
+uint16_t encode_comp(const char *comp);
 
 /*
  * Function: encode_jump
@@ -37,9 +52,9 @@ short encode_comp(const char *comp);
  *
  *  jump: symbolic 'jump' part of C command
  *
- *  returns: jump encoded as short int
+ *  returns: jump encoded as 16 bit word
  */
-short encode_jump(const char *jump);
+uint16_t encode_jump(const char *jump);
 
 /*
  * Function: encode_command
@@ -50,8 +65,84 @@ short encode_jump(const char *jump);
  *  comp: symbolic 'comp' part of C command
  *  jump: symbolic 'jump' part of C command
  *
- *  returns: C command encoded as short int
+ *  returns: C command encoded as 16 bit word
+ */
+uint16_t encode_command(const char *dest, const char *comp, const char *jump);
+
+/*
+ * Function: valid_dest
+ * --------------------
+ *  checks 'dest' mnemonic: any non empty combination of A, D and M, each
+ *  register at most once
+ *
+ *  dest: symbolic 'dest' part of C command
+ *
+ *  returns: true if encode_dest encodes the mnemonic as written
+ *           false otherwise
+ */
+bool valid_dest(const char *dest);
+
+/*
+ * Function: valid_comp
+ * --------------------
+ *  checks 'comp' mnemonic against the table of encode_comp
+ *
+ *  comp: symbolic 'comp' part of C command
+ *
+ *  returns: true if encode_comp knows the mnemonic
+ *           false otherwise
+ */
+bool valid_comp(const char *comp);
+
+/*
+ * Function: valid_jump
+ * --------------------
+ *  checks 'jump' mnemonic against the table of encode_jump
+ *
+ *  jump: symbolic 'jump' part of C command
+ *
+ *  returns: true if encode_jump knows the mnemonic
+ *           false otherwise
+ */
+bool valid_jump(const char *jump);
+
+/*
+ * Function: comp_mnemonic
+ * -----------------------
+ *  lists 'comp' mnemonics encode_comp knows
+ *
+ *  i: index of the mnemonic
+ *
+ *  returns: i-th mnemonic
+ *           NULL if there are no more mnemonics
+ */
+const char *comp_mnemonic(size_t i);
+
+/*
+ * Function: dest_mnemonic
+ * -----------------------
+ *  spells 'dest' encoding as canonical mnemonic
+ *
+ *  code: 3 bit 'dest' encoding
+ *
+ *  returns: mnemonic
+ *           NULL for null 'dest'
+ */
+const char *dest_mnemonic(uint16_t code);
+
+/*
+ * Function: encode_cached
+ * -----------------------
+ *  finds encoding of C command by its raw text, splitting and encoding
+ *  it only the first time the text is seen by the calling thread
+ *
+ *  cache is per thread and pre-seeded with the most common commands
+ *
+ *  text: whitespace stripped C command
+ *
+ *  returns: pointer to cache entry (valid until next call)
+ *           NULL if text can't be cached
  */
-short encode_command(const char *dest, const char *comp, const char *jump);
+const code_cache_entry_t *encode_cached(const char *text);
 
 #endif // !HACK_ASM_CODE_H
@@ -0,0 +1,29 @@
+// Blackens the screen while a key is pressed, clears it otherwise.
+(LOOP)
+    @KBD
+    D=M
+    @color
+    M=0
+    @FILL
+    D;JEQ
+    @color
+    M=-1
+(FILL)
+    @SCREEN
+    D=A
+    @pixel
+    M=D
+(NEXT)
+    @color
+    D=M
+    @pixel
+    A=M
+    M=D
+    @pixel
+    MD=M+1
+    @KBD
+    D=D-A
+    @NEXT
+    D;JLT
+    @LOOP
+    0;JMP
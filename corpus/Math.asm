@@ -0,0 +1,25 @@
+// Multiplication subroutine shared through #include.
+// R13 * R14 is stored in R15, the return address is expected in R12.
+    @MATH_END
+    0;JMP
+(MULTIPLY)
+    @R15
+    M=0
+(MULTIPLY_LOOP)
+    @R14
+    D=M
+    @MULTIPLY_RETURN
+    D;JEQ
+    @R13
+    D=M
+    @R15
+    M=D+M
+    @R14
+    M=M-1
+    @MULTIPLY_LOOP
+    0;JMP
+(MULTIPLY_RETURN)
+    @R12
+    A=M
+    0;JMP
+(MATH_END)
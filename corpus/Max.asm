@@ -0,0 +1,28 @@
+// Computes R2 = max(R0, R1).
+   @R0
+   // D = first number
+   D=M
+   @R1
+   // D = first number - second number
+   D=D-M
+   @OUTPUT_FIRST
+   // if D>0 (first is greater) goto output_first
+   D;JGT
+   @R1
+   // D = second number
+   D=M
+   @OUTPUT_D
+   // goto output_d
+   0;JMP
+(OUTPUT_FIRST)
+   @R0
+   // D = first number
+   D=M
+(OUTPUT_D)
+   @R2
+   // M[2] = D (greatest number)
+   M=D
+(INFINITE_LOOP)
+   @INFINITE_LOOP
+   // infinite loop
+   0;JMP
@@ -0,0 +1,2010 @@
+// generated mix of every dest, comp and jump form, labels, variables
+// and builtin symbols (stresses encoder and symbol table)
+    A=D&A
+    M=-M
+    MD=1
+    D=D+A
+@L34
+    A-D;JGE
+    MD=D-1
+    AMD=D+A
+@L78
+    -1;JNE
+    A=A-1
+@v23
+    AD=D|M
+    AM=A-1
+(L0)
+    MD=D
+    A=-1
+@v21
+@R13
+    AD=!M
+@v22
+@v7
+    AM=!A
+@L3
+    A;JMP
+    D=D&M
+@L8
+    0;JLE
+    AMD=M-D
+    MD=D|M
+    M=!A
+@L56
+    D-M;JGT
+@LCL
+@L0
+    A;JLT
+@ARG
+    AD=!M
+@v8
+    M=D&A
+@SCREEN
+    MD=!M
+@v16
+@L30
+    D+1;JGT
+@R2
+    A=D+M
+@L0
+    D&A;JLT
+@THAT
+    MD=M
+@R3
+    MD=D+M
+@v21
+    D=!D
+    M=M
+    M=-M
+@SP
+@L29
+    D-A;JEQ
+@v3
+@17047
+@L13
+    D-M;JGT
+@R12
+@L47
+    !M;JLE
+    A=D
+@L56
+    D-M;JMP
+    D=M
+    AD=-M
+    D=D|A
+    AD=!M
+@v13
+    M=D&M
+@L62
+    D+M;JGE
+    AM=M
+    M=1
+(L1)
+    MD=D&A
+    AMD=D
+@v26
+@v21
+@27372
+    AD=D-M
+    D=A+1
+@10592
+@L53
+    D+M;JEQ
+    D=-D
+    A=1
+    AM=D-A
+    AD=A-1
+(L2)
+    AD=!M
+@v15
+(L3)
+    D=D+M
+    M=!M
+@3480
+(L4)
+@L10
+    -1;JMP
+    A=D+1
+@R9
+@ARG
+@v18
+    AMD=-1
+    M=-1
+    MD=-A
+@L20
+    M;JLE
+@20172
+    M=-A
+    AMD=!M
+    AMD=D&M
+@L31
+    D;JGT
+    MD=A
+@v29
+    M=A
+    AD=A
+    AMD=D+A
+    AM=1
+@L32
+    0;JGT
+    AMD=D|M
+@27792
+    A=D&A
+    D=D-1
+    A=M
+    M=A+1
+    AMD=D-A
+@R10
+    AM=M-1
+@v0
+    M=M
+    AM=!A
+    MD=M+1
+    A=D|A
+    AD=D|A
+    A=!A
+    AD=D+A
+    M=A-D
+@v7
+    A=A-1
+@LCL
+@L33
+    M+1;JGT
+@11808
+@L46
+    -M;JGT
+    MD=D-M
+@L69
+    A-D;JLT
+    M=M-D
+    AMD=D&A
+@v21
+@R9
+@L20
+    !D;JLE
+    AD=D+1
+    MD=-M
+    AD=D-A
+    D=D+A
+@v5
+    AM=D
+    D=-D
+    D=D-1
+@L29
+    -M;JMP
+@KBD
+(L5)
+    D=D|A
+@v3
+    M=D&A
+    A=M+1
+@v25
+    AMD=D-M
+    AMD=M-D
+    AMD=M+1
+    AMD=D|A
+    D=D|A
+    AM=A-1
+    AM=D|A
+@L72
+    -M;JGT
+@L27
+    M+1;JLE
+    A=D-M
+@LCL
+    M=D+M
+    A=M
+    M=1
+    AMD=!M
+    AD=!D
+@L58
+    D-A;JNE
+@L35
+    D+M;JLE
+@L75
+    A-1;JMP
+    M=-D
+    D=-A
+    AMD=-D
+@v17
+@v14
+    AM=D|A
+@32508
+@L36
+    A-D;JEQ
+    MD=-1
+    A=A-1
+@v5
+@L72
+    A;JLT
+    MD=D&A
+    AMD=M-1
+(L6)
+    AMD=A
+    AMD=M+1
+    MD=-D
+    AD=M+1
+    AMD=-A
+(L7)
+@v9
+    M=M
+    AMD=1
+    D=!A
+    AM=D&A
+    AD=D-A
+@L42
+    D-A;JLT
+@L47
+    0;JGT
+    A=D+1
+@v12
+@v11
+    AM=A+1
+@L57
+    M;JMP
+@12113
+    AM=!D
+    M=-1
+    D=-D
+    M=A-D
+    A=0
+@L40
+    D&A;JMP
+@R9
+    MD=M-D
+@L19
+    A+1;JGE
+    AMD=D-A
+    AMD=!D
+    AMD=D&A
+    AMD=D|M
+    AMD=-D
+@v22
+    A=0
+    MD=M-1
+@R13
+@L22
+    M+1;JLT
+@L48
+    D&M;JLE
+@v17
+@2375
+    MD=-1
+@R7
+    AD=A
+    M=D|A
+@L7
+    A-D;JMP
+    M=D|M
+    M=0
+@v6
+@v3
+    D=!D
+    AD=-M
+    M=M-1
+    AM=D&A
+@L53
+    -M;JEQ
+@v23
+    D=!M
+    AD=-D
+    AMD=D|A
+@L35
+    D+1;JMP
+(L8)
+@L39
+    1;JMP
+@SP
+    AD=D-A
+@22558
+    AM=M-D
+@v18
+    AD=D+A
+    A=D-1
+@15627
+    AMD=D|A
+    A=-A
+@L51
+    M;JLE
+    AM=0
+@R10
+    AMD=M-1
+    M=D|A
+    A=-M
+@19295
+    D=!M
+@R4
+    D=-1
+    AD=D-1
+@L7
+    -D;JMP
+    AM=-1
+    AD=M-D
+@21755
+    A=A-1
+    MD=-D
+@ARG
+    A=-M
+@L46
+    1;JLT
+    AM=D+M
+    AMD=A+1
+@26947
+@L64
+    M-1;JLE
+    AD=D-M
+@R6
+    AD=D+1
+    AD=M
+    M=-D
+    AMD=-A
+    AMD=1
+    MD=!D
+    D=-A
+@R7
+    A=M+1
+    M=M+1
+    AMD=M-1
+    MD=D-1
+    A=D|A
+@v14
+    AM=A-D
+@L66
+    M-1;JGT
+    M=D-1
+@32457
+@3084
+    MD=M-1
+@v27
+@L10
+    D&M;JLE
+    AM=D+A
+@v9
+@R3
+@L58
+    M+1;JMP
+@R0
+    D=A-1
+    M=D+1
+@L67
+    D;JNE
+@R13
+    AMD=D-A
+    MD=0
+@v26
+@v15
+    M=A
+    M=D
+    D=M+1
+    AM=M
+    M=M+1
+    AD=D+1
+    MD=D-1
+@22034
+    AM=D-1
+    AMD=A-1
+    AMD=A
+@7630
+    A=A+1
+    D=M-D
+    AMD=D|M
+    AM=-A
+@L18
+    1;JEQ
+    A=M-D
+    D=D|A
+    AMD=D|A
+    AD=!D
+@L64
+    D;JGT
+    AM=0
+@1637
+    AMD=A-1
+    MD=D-M
+@L74
+    D-M;JMP
+@L42
+    -D;JLE
+    MD=D
+    AMD=!A
+    AM=D-A
+@L19
+    D-A;JMP
+@R2
+    AMD=1
+    AD=M-1
+    A=D-A
+    MD=A-1
+    M=D-1
+@L5
+    D+M;JEQ
+    AM=!M
+    MD=M+1
+    AD=A
+    M=!M
+    D=D&A
+@v0
+    A=M
+@KBD
+@L18
+    A;JNE
+    AD=!A
+@L57
+    0;JLT
+    AM=D+1
+    D=D
+    AM=M-1
+@L56
+    D;JGE
+@SCREEN
+@v7
+@v7
+    A=!D
+    A=D
+    M=D+A
+    D=D+1
+    AM=D&M
+@L40
+    M+1;JGT
+@L2
+    A-D;JLT
+    MD=D
+    MD=A+1
+@L9
+    D;JNE
+    AM=D+A
+    MD=D|M
+@12008
+@v8
+    AMD=0
+    D=D
+@v20
+@v10
+(L9)
+    MD=D-A
+    M=-A
+    A=-1
+    D=M-1
+    AD=D-1
+(L10)
+    A=D&A
+    AM=D-1
+    MD=D
+    D=D+A
+    A=M-1
+    D=D&M
+    M=-D
+@28610
+    D=D+M
+@SCREEN
+    A=M-D
+    MD=D+A
+    MD=1
+    AM=D|M
+    M=!M
+@L62
+    A;JEQ
+@ARG
+    A=M-D
+    MD=D+A
+@L72
+    D+A;JLE
+    AMD=!M
+(L11)
+    MD=D-M
+    A=M+1
+@L77
+    D|A;JLT
+    A=1
+@31003
+    AM=D|M
+@v0
+@R12
+    AMD=D|M
+    AMD=A
+    D=!D
+@L53
+    -1;JMP
+    D=A-1
+(L12)
+@L3
+    -A;JNE
+    AM=M
+    AD=!D
+    D=0
+    AD=A-D
+    MD=D+1
+    AM=D-1
+    AMD=-D
+    AM=D-M
+@L46
+    A-1;JLE
+(L13)
+    M=D
+    D=-M
+    AM=D-M
+    A=M-D
+@R1
+@v16
+    D=-D
+@v13
+@L0
+    A;JEQ
+    M=-D
+    AM=M-1
+    D=A-1
+    M=M+1
+    AMD=-1
+    M=D
+    MD=M-D
+@SP
+(L14)
+    M=D|M
+@R11
+    AM=M-1
+    MD=D&M
+@11826
+    D=D&A
+    MD=-D
+    AMD=D+M
+@7980
+@L0
+    D|A;JLT
+@v6
+    A=-D
+    D=A+1
+    M=D-M
+    AM=D+A
+    AMD=D-A
+    AD=M-1
+@L30
+    M;JNE
+@v9
+@v27
+@21855
+    M=-D
+    AD=!M
+    AD=D+1
+    M=-A
+    A=0
+(L15)
+    AMD=1
+@v4
+    M=D-M
+    A=D-1
+@ARG
+@L9
+    !A;JMP
+(L16)
+    MD=-D
+    MD=A-D
+    AD=M-D
+@24833
+    M=D+A
+    AD=M+1
+    AM=0
+@11285
+    M=M
+    AMD=-D
+    D=D+1
+    AD=D+M
+    AM=D+1
+@L65
+    D+M;JGE
+(L17)
+@L9
+    D-A;JGE
+@30507
+    AM=D+M
+    D=A-D
+    AMD=M-D
+@L51
+    D-M;JGT
+    A=A-D
+@L55
+    !D;JLT
+    AM=D-M
+    AM=-D
+    AD=M-D
+    A=M-D
+    A=D-M
+    A=A-D
+    AM=A-1
+@L22
+    D-A;JLE
+@L22
+    D|M;JMP
+@27297
+@L71
+    A;JNE
+@L45
+    -1;JEQ
+@L43
+    -A;JGE
+@v26
+    AD=M-1
+@v19
+    A=D+1
+    M=D|A
+    AMD=1
+@L31
+    0;JNE
+    AD=A-D
+    D=M
+    D=D|A
+    AM=D-M
+@26899
+    A=M+1
+@L46
+    D-1;JNE
+    AMD=A
+    A=A+1
+    MD=A-D
+    M=A+1
+@R14
+@18259
+    A=-A
+    AD=-D
+    AMD=A+1
+    M=D
+    A=!D
+    AMD=!D
+    AMD=1
+@R15
+    AD=M+1
+@L33
+    D&A;JLE
+@15880
+    D=D|M
+    AMD=M
+    AM=D-A
+@L57
+    !D;JNE
+    A=!A
+@v26
+    AM=-D
+    AD=A-D
+@L0
+    -1;JLT
+@v7
+@L2
+    -A;JLT
+    AD=D-A
+@10510
+    D=M+1
+    AM=A+1
+@L67
+    D+A;JGE
+    M=D+A
+@L18
+    -A;JGE
+    M=D-1
+@v20
+    AM=D-M
+@R8
+    A=D-A
+@v8
+    AD=-M
+    AM=D+A
+@L39
+    A-1;JLT
+    AD=A-1
+@v14
+    A=M-1
+    M=!M
+@24609
+@28559
+    AM=D-A
+    AMD=-D
+@v6
+@v24
+    AM=0
+    AD=-1
+@v17
+    D=D|A
+    AMD=-M
+@v11
+@3714
+    M=D-1
+@v27
+@L20
+    A;JGE
+@13227
+    D=-1
+    AD=D|M
+    M=M+1
+    MD=M+1
+    D=D&M
+    A=D+1
+    MD=-A
+    A=A+1
+@v27
+@10270
+    A=D+M
+    D=D+M
+    AMD=!D
+@L41
+    -D;JGT
+@R8
+@v25
+(L18)
+@v2
+    M=A-1
+    A=M-D
+@L34
+    !A;JEQ
+    MD=D&M
+    AMD=D-A
+    D=!D
+    A=M+1
+@2263
+@L42
+    A-D;JMP
+    D=A
+    AM=D+M
+@L50
+    D-A;JMP
+@L56
+    A+1;JEQ
+@L42
+    0;JGT
+    AM=!M
+    M=!D
+@v9
+    A=D-1
+    AM=A+1
+    D=M+1
+    AM=!A
+    A=D&A
+    AM=D&M
+    AD=D+M
+    D=D-A
+@v27
+    AM=!M
+    MD=D+A
+@14714
+    AD=D|M
+@20966
+    A=D&A
+@R4
+@3893
+@v22
+    MD=A
+@v20
+    A=M-1
+@L66
+    D-A;JGE
+@v10
+@v24
+@v13
+    A=A-D
+@L56
+    D&A;JNE
+    AMD=0
+@v3
+    D=D|A
+(L19)
+    AM=M
+@L29
+    D+1;JNE
+@L26
+    D+A;JLT
+@L21
+    -D;JEQ
+@L46
+    -M;JEQ
+    AD=!D
+@L62
+    D;JGT
+@L8
+    0;JLT
+@18849
+    A=D&M
+@20162
+(L20)
+    AMD=D&M
+(L21)
+(L22)
+@v6
+    M=D+A
+    D=D+1
+    AD=D+A
+    D=M
+@L19
+    D+1;JLT
+    AMD=D&A
+    AM=D+A
+@L62
+    A-D;JGE
+    A=D|M
+    AD=1
+@L58
+    -1;JEQ
+    MD=M+1
+@SP
+@v29
+    D=D+1
+    D=M-1
+@L33
+    D|A;JGE
+    D=!D
+    AD=D&A
+    AM=D&M
+    MD=A-D
+    AD=M-1
+    AMD=D|A
+    A=0
+    M=A-1
+@L25
+    1;JGT
+(L23)
+    D=A
+    MD=D-A
+(L24)
+    A=A-1
+    AMD=A+1
+@v22
+    MD=A+1
+@L59
+    M+1;JMP
+    AMD=-D
+@L14
+    1;JNE
+(L25)
+@v7
+    D=D-A
+    AM=D|M
+@L69
+    -1;JEQ
+@L54
+    A-D;JLE
+    AMD=M-1
+    AMD=D-A
+@R9
+    MD=0
+@L52
+    D+M;JLE
+@v28
+    MD=A+1
+(L26)
+    AM=D&A
+    AM=D|A
+    AD=D+1
+@THAT
+@R13
+@L73
+    A-D;JGE
+    AMD=D-M
+    AMD=!A
+@ARG
+@8328
+    MD=M
+@R0
+@L44
+    M-1;JGT
+    AM=D|A
+@16743
+@v4
+@16772
+@SCREEN
+    AD=0
+    AMD=!M
+    MD=A-D
+(L27)
+@v3
+    M=D-M
+    D=!D
+@v0
+    AMD=A+1
+    AMD=!A
+@16212
+@L63
+    0;JMP
+    MD=A+1
+    A=!D
+    D=M
+@R14
+    AD=D
+    AMD=D&A
+@L36
+    D+1;JEQ
+@v4
+    M=D-M
+    D=D|M
+    A=D+M
+(L28)
+@v2
+    M=D
+@LCL
+    A=M
+    A=A-1
+    MD=D&M
+    A=M
+    AD=D+M
+    MD=M+1
+@21104
+@L52
+    -D;JLE
+@L5
+    !A;JEQ
+    A=D-M
+@L67
+    1;JNE
+(L29)
+@SP
+    AMD=D-1
+@v1
+    AD=D|A
+@v2
+@L52
+    D&A;JEQ
+@28841
+(L30)
+    A=M-1
+@14956
+@L63
+    D-M;JLT
+@v8
+    AD=1
+@v21
+    AD=-D
+@v13
+@v27
+    AD=-M
+@R2
+@4392
+    M=A
+@R12
+@L78
+    D-M;JEQ
+(L31)
+@v1
+    M=A-D
+    AMD=D+1
+    M=D-A
+@L72
+    D+A;JMP
+    AMD=D-A
+    AMD=A-1
+(L32)
+@L4
+    D&M;JMP
+    D=-D
+    M=-M
+    AMD=-1
+    AMD=-M
+@L16
+    D-A;JEQ
+(L33)
+    MD=D&A
+@L35
+    !A;JEQ
+@KBD
+    A=M-D
+    MD=A-D
+    AD=!M
+    D=A
+    AMD=D&A
+    M=A-D
+@8716
+@L11
+    M+1;JNE
+    AM=A-1
+    AMD=D-M
+    AMD=M
+    A=D
+@L33
+    D-A;JLE
+    MD=D
+    D=D-A
+    AMD=M-D
+@v15
+    A=D|A
+    AD=A-D
+    MD=-D
+(L34)
+(L35)
+@L47
+    1;JLE
+(L36)
+    A=D+A
+@v1
+@L79
+    M;JEQ
+(L37)
+    AD=D-M
+    D=0
+    AD=-1
+@L51
+    !D;JNE
+    AMD=D-A
+    AM=A-1
+@L49
+    D-1;JGT
+@5044
+    D=D-1
+    MD=-1
+@v10
+    D=D+A
+@L77
+    D+A;JLE
+    A=D
+(L38)
+@L51
+    D|A;JGT
+@L15
+    D&A;JEQ
+    AM=-1
+    AMD=M
+@v26
+    AMD=D|A
+    AD=D
+@v0
+    D=!D
+@v26
+    AM=D&M
+@10620
+@R15
+@L54
+    D+M;JGE
+    D=D-1
+@v8
+    AM=D-A
+@32605
+@v22
+    AMD=!A
+@v20
+@v23
+    A=!A
+@v7
+@L38
+    M;JEQ
+@L46
+    D+M;JNE
+    M=-D
+    AD=!D
+    AMD=M-D
+    AD=-1
+@1534
+    A=D-A
+@9626
+@v20
+    AMD=M-D
+    M=A
+@27130
+    AM=-1
+    A=D+1
+    MD=D-1
+    AD=M-D
+    M=1
+    AM=D|A
+    A=M
+    A=M+1
+    AM=-D
+@v0
+@23975
+@L50
+    D|A;JEQ
+    AM=-M
+    AMD=-D
+@v8
+    AD=D+A
+@16093
+    M=-1
+    M=-M
+@L63
+    M;JNE
+@SP
+@L62
+    D&A;JGT
+@L14
+    !A;JGE
+    A=0
+    AD=M-D
+@R2
+    MD=!A
+@L76
+    -A;JLE
+    MD=-M
+    D=A
+@5367
+(L39)
+    AD=-M
+@L56
+    M-D;JLE
+    AMD=D+A
+    A=M+1
+    AD=D|M
+    AM=D+A
+@R7
+@25787
+    D=A
+    AM=D
+    A=-1
+@31135
+    AD=D|M
+@18363
+@L0
+    !D;JGE
+    A=!D
+    AMD=-A
+    A=D&A
+@L6
+    1;JEQ
+    A=D-1
+    A=D+1
+    AMD=M-1
+@L24
+    !A;JLT
+@v5
+    D=M+1
+    D=D-1
+@L22
+    M-1;JGT
+    D=-M
+    M=D&A
+@R4
+@v6
+    MD=A
+    AD=A+1
+    MD=D|A
+    AM=-A
+    AMD=A-D
+    AM=D|M
+(L40)
+@L54
+    D;JNE
+    MD=M-1
+    M=M-D
+@v18
+@L10
+    D|M;JLE
+@R0
+    MD=D+M
+@25629
+    M=A+1
+@v22
+    MD=!A
+    AMD=!D
+    M=D+1
+@R12
+(L41)
+@v22
+    AM=-D
+@8443
+    MD=D+A
+    AM=D-1
+    AM=1
+@v19
+@v25
+    M=!M
+@v28
+    A=D|M
+    D=D+A
+    A=!M
+@R4
+    MD=0
+    AMD=!A
+    AMD=1
+@17970
+    AMD=M
+@R12
+(L42)
+@v11
+    M=D&M
+    A=-1
+    AD=D-M
+@L78
+    A+1;JGE
+(L43)
+@L4
+    M;JNE
+@24286
+    M=D-A
+    A=1
+@14726
+    A=D+M
+@L11
+    -A;JLT
+    AM=D+A
+    D=D&A
+    AD=D
+    A=-1
+    AMD=-1
+@v11
+    AD=D+1
+    D=A-D
+(L44)
+@v20
+    A=1
+    M=D&A
+    M=-1
+    A=D+1
+@4895
+    AD=!A
+    MD=A-D
+@R10
+(L45)
+    D=D&M
+    AM=D-A
+    MD=D+A
+    AD=A-D
+    A=D-M
+@v6
+    AD=D|A
+    A=M
+    AMD=!D
+    D=D+M
+@17673
+    D=!M
+@R9
+    AD=!D
+@v11
+    D=D|M
+@R13
+    MD=D
+@v25
+@R10
+    MD=M-1
+    AD=!A
+@L75
+    !D;JGT
+@v5
+    AD=D
+@v1
+    MD=A
+@v2
+    AD=!D
+    AM=M-D
+    M=-1
+@L1
+    1;JNE
+    D=D&M
+@v27
+@L72
+    M-1;JNE
+    D=!D
+@L27
+    !M;JNE
+    M=0
+@L69
+    D&A;JMP
+    AM=D-M
+@v6
+    AD=D-1
+@R15
+@R10
+    M=A-1
+    AMD=M-1
+@L44
+    D+A;JLT
+@L33
+    D|A;JEQ
+@L1
+    A+1;JEQ
+(L46)
+@L39
+    -M;JEQ
+    AD=D|A
+    AMD=D&M
+@v3
+    AD=D-M
+    MD=M+1
+    A=D+1
+@v6
+    A=-M
+@v21
+    MD=D|A
+@26430
+@v7
+@9130
+@14461
+    AD=M-D
+    MD=!M
+    D=D-1
+    A=-M
+    MD=D&A
+@L68
+    -A;JEQ
+    AMD=A+1
+@v13
+    D=!A
+    MD=!A
+@v11
+    D=D+1
+    D=M-1
+@L77
+    -M;JLT
+    AD=D+M
+@17131
+    MD=D
+    AMD=M-D
+@v19
+@L4
+    -D;JNE
+(L47)
+(L48)
+@27158
+@v9
+    MD=-A
+    AM=D-A
+@L54
+    D&A;JGE
+    D=D
+    A=A+1
+@L55
+    A;JMP
+    AD=!M
+    MD=D+1
+    D=D|M
+    MD=-A
+    AD=D+1
+@L50
+    M;JNE
+    AD=A-D
+@30518
+@29224
+    A=D
+    A=D+1
+@7856
+    M=D|M
+    A=M-1
+    M=!A
+    AD=D-M
+    D=D-A
+    AD=D+A
+    A=A+1
+@L39
+    D|M;JGT
+    MD=M+1
+@217
+    A=D|M
+@L39
+    M-1;JMP
+    D=D|A
+@v17
+@R11
+@THAT
+    AM=M
+    AM=M
+    D=!D
+@L21
+    M-D;JLT
+@L16
+    !D;JEQ
+    AD=D-1
+    MD=M+1
+    AM=D+M
+@v7
+@L58
+    D|M;JGT
+    M=D|A
+    D=D+M
+@SCREEN
+@v20
+@v17
+    A=A+1
+@v18
+    AMD=D-M
+@L11
+    -D;JGT
+@L32
+    D|A;JMP
+    MD=D+1
+    A=-M
+(L49)
+(L50)
+    MD=D-A
+@L3
+    M+1;JLE
+@v5
+    D=D&M
+    A=M-1
+    AM=-M
+    MD=D+M
+    M=D
+@L22
+    D&M;JGT
+    D=0
+    A=0
+@31926
+    M=-D
+    A=M-1
+    AM=D+M
+@L27
+    -D;JLE
+    AM=D+1
+@31585
+(L51)
+    MD=D+A
+@R11
+    AD=-D
+@v18
+    MD=!A
+    AD=A
+    A=!D
+@ARG
+    AD=-A
+@9978
+    AD=D|M
+    AD=0
+@L24
+    A;JMP
+    MD=A-1
+@v8
+    AM=!M
+    D=A-D
+@R0
+    M=M+1
+    D=-A
+@L65
+    D+A;JEQ
+    AM=M-D
+    M=A-D
+    MD=1
+@3160
+    MD=-M
+    D=-D
+@LCL
+@L0
+    D-1;JGT
+    AMD=D|A
+    D=D+A
+    A=M
+    MD=!D
+@18186
+    D=A-D
+@v1
+    AMD=D+A
+    AMD=M
+@R11
+    MD=D-A
+    A=1
+@L40
+    -1;JMP
+    A=M-1
+    AMD=!M
+@THIS
+@R11
+@L73
+    M-1;JNE
+    M=D
+@R13
+@6128
+@5854
+    M=M
+    M=M
+    A=A
+    AM=M
+@L39
+    D&A;JNE
+    AD=1
+(L52)
+    M=D&A
+@R2
+    MD=!D
+    M=D&M
+    AMD=!M
+    AD=D&M
+@L66
+    D-M;JLT
+@SCREEN
+    AMD=D-1
+@L74
+    D&A;JGT
+    AD=-1
+(L53)
+    AD=0
+@L70
+    M;JGT
+    AMD=!D
+@L61
+    !M;JNE
+@ARG
+    MD=A
+    MD=D+M
+    M=-D
+    AM=D&M
+    AMD=M-1
+@L59
+    D&M;JGE
+@R2
+    M=A
+@21148
+@L43
+    M;JNE
+    A=M+1
+    M=A+1
+@SP
+@v26
+    AMD=!M
+@v9
+@L40
+    -A;JGE
+@31909
+    D=M+1
+    A=M-1
+    MD=D-M
+    A=A
+@L1
+    -A;JLT
+    AD=D&M
+@L32
+    D-A;JLT
+@v22
+    AMD=-A
+@v26
+@10315
+    A=0
+    MD=D+M
+@L35
+    A-D;JNE
+@R2
+    D=!D
+@L21
+    M+1;JNE
+    AMD=1
+    AMD=-M
+    AD=D-M
+@THAT
+@6341
+    D=!D
+@L22
+    M;JLT
+    MD=A-D
+@L61
+    !M;JLE
+    D=D-M
+    MD=M+1
+    AMD=-1
+@v28
+    M=A+1
+@L76
+    1;JEQ
+    D=!D
+    A=D
+@L40
+    D|A;JLE
+    M=M-D
+    A=!D
+    AM=D+M
+    M=D+1
+@L28
+    D-M;JGT
+    A=D+A
+@28455
+    M=0
+    MD=D-A
+    AM=D-1
+    D=A
+    AM=1
+    AMD=D+M
+    MD=M-D
+    MD=!M
+    MD=A-1
+    AMD=!M
+    A=D|M
+    A=D-M
+    AD=D-1
+    M=0
+@v28
+@R8
+    AM=D+M
+    MD=1
+@2848
+@v29
+    AD=D&A
+    M=D|A
+@14866
+@KBD
+@v9
+(L54)
+@L11
+    D+A;JMP
+    AMD=-D
+    A=A-1
+    AM=D+1
+    M=A
+@L51
+    D-A;JGE
+    MD=-M
+@L42
+    -A;JGE
+@L44
+    A+1;JEQ
+    AM=A
+    AMD=A-D
+    AD=D|A
+@L8
+    !M;JNE
+@L5
+    D-1;JLE
+@L71
+    1;JLE
+    AD=D+M
+    AM=D-1
+    A=A+1
+    D=!M
+    M=M-D
+@v10
+    AMD=-M
+@L54
+    !A;JGE
+@L51
+    M;JLE
+@31750
+    MD=-A
+@L7
+    -M;JNE
+    D=0
+@L57
+    D;JEQ
+    D=D+M
+@L55
+    D&M;JGE
+@v20
+@v25
+@L51
+    D&A;JGT
+@v5
+    MD=M
+@R6
+    AD=D-A
+@L27
+    A-D;JNE
+@98
+    MD=M-D
+    AM=D&M
+(L55)
+    M=-M
+    M=M
+(L56)
+    A=D+M
+@L46
+    A-1;JLE
+    M=D&M
+    AD=-A
+    A=A-D
+    MD=D|M
+@17282
+(L57)
+    AD=A-1
+    D=D&M
+    AMD=-A
+@v6
+@7591
+    AD=D+1
+    MD=D+A
+    AD=!D
+    AM=M+1
+    AMD=D+1
+    AD=A-1
+@L42
+    A;JEQ
+    MD=D+1
+    A=-D
+@L20
+    !A;JLE
+    AM=1
+    AD=M-1
+    MD=D|M
+    AMD=D|M
+@L64
+    D|A;JGT
+@24906
+@v24
+@R4
+    AM=1
+    AD=D-A
+    M=D&A
+    AM=D+A
+    M=M
+    AM=A
+@v11
+    AD=0
+    A=D|A
+    AM=!A
+@v8
+@v2
+    M=D-M
+    AMD=!A
+@22761
+@v26
+    M=D&M
+    A=M-1
+    AM=A+1
+    M=A-D
+@L30
+    -1;JNE
+@R13
+    M=D-M
+    MD=D&A
+    MD=D+M
+    MD=A-1
+    AD=D+M
+    A=D
+    AMD=M-1
+@v24
+    D=D+1
+@L24
+    D+M;JLT
+    AD=M-1
+    M=D+A
+@R11
+    MD=-M
+    D=D+M
+    M=M-1
+(L58)
+@L20
+    -M;JEQ
+    A=D&M
+@3492
+    A=D&A
+@THIS
+    AM=A-1
+    M=M-D
+    M=-1
+@17237
+@L18
+    A-D;JGT
+    AMD=M-D
+@v18
+@v19
+@15997
+@L42
+    A;JLT
+@L52
+    0;JEQ
+@25954
+@L53
+    A;JLT
+    AM=D-M
+@v5
+    AD=D-A
+@L31
+    -M;JGT
+    AMD=!M
+@L4
+    -D;JGT
+    MD=1
+@8579
+    D=0
+@v3
+@L2
+    -A;JMP
+@L19
+    D;JNE
+    AMD=-M
+    MD=M
+@v14
+@L27
+    1;JLT
+    D=D-M
+    MD=D+M
+@v6
+    M=M-1
+    D=A-D
+@v0
+    AMD=-M
+@R6
+    AMD=D|M
+    AMD=D|M
+    M=D-1
+    D=A-1
+@28984
+    D=D+A
+@26960
+    MD=D+M
+@L7
+    !D;JGT
+    MD=M+1
+    D=M-D
+    MD=D&A
+    AD=-A
+@L79
+    M-D;JMP
+@L69
+    !D;JGE
+    A=M-1
+@L79
+    !D;JEQ
+    MD=D-A
+@L33
+    A+1;JLT
+@25757
+    AD=D+A
+    AD=A-D
+@2077
+@L29
+    !A;JEQ
+    D=A
+@L61
+    M+1;JGT
+    AD=A+1
+    AMD=!M
+(L59)
+    AM=-D
+    A=!D
+    M=A
+    D=D+A
+@L53
+    D-A;JGT
+@L15
+    D|A;JMP
+    MD=0
+@v13
+@v9
+    AMD=M-D
+    AM=-A
+@L72
+    D;JLE
+    AM=D
+@L7
+    D;JGT
+    MD=A-1
+@L21
+    !A;JLE
+    MD=0
+@SP
+    MD=-M
+@R2
+@v25
+    D=!A
+    D=D+A
+@L36
+    D+A;JEQ
+@L9
+    M-D;JGE
+    A=A-D
+    AM=D|M
+@L69
+    D|A;JGT
+@L26
+    M;JGT
+    D=D-M
+@888
+@v8
+    A=-1
+    D=D|M
+    AM=-1
+@v9
+@L58
+    D&A;JLE
+(L60)
+    AD=A-D
+@32008
+    M=D-1
+@L54
+    D-M;JLE
+(L61)
+@R13
+@R0
+@3936
+    AD=D&A
+(L62)
+    M=D-A
+@v8
+@24968
+    AM=A-D
+    A=1
+    AMD=D-1
+@LCL
+(L63)
+@L43
+    M+1;JNE
+    AMD=A-1
+    MD=!D
+    A=-1
+@v22
+    A=D-1
+    MD=A
+@L67
+    D+A;JGE
+@7108
+    AMD=-A
+    AD=M-1
+    A=A-D
+    M=M-1
+    AM=D
+    AD=D&A
+@L24
+    1;JMP
+    A=M+1
+@L50
+    D&A;JNE
+    M=M-D
+    D=D
+@R5
+    AD=0
+    AMD=D-M
+@L60
+    -A;JEQ
+    AM=D
+@R4
+    AD=A
+@L68
+    D+A;JLT
+    MD=A-D
+@L46
+    !D;JGE
+@29261
+@9671
+@v18
+@R2
+@L27
+    M;JLT
+    A=-M
+@15815
+@v5
+    AMD=!A
+@R1
+@3667
+@21537
+    MD=D|M
+    AM=D-1
+    A=-A
+    A=D&A
+    AD=-D
+    MD=D-A
+@v22
+@29291
+@THIS
+    AD=A+1
+@L76
+    A+1;JGT
+@v2
+    AD=M-D
+    D=D-1
+    D=A+1
+    AMD=A-D
+    MD=D+M
+@ARG
+    MD=D|A
+    MD=D+1
+    MD=A
+    AMD=D-A
+    AM=D+M
+@L35
+    D|A;JNE
+@R3
+(L64)
+    MD=-A
+@R5
+    AMD=A-D
+    A=!A
+@25042
+@v17
+@R10
+    AD=1
+    M=M+1
+    M=0
+@KBD
+@30458
+    MD=M
+    AMD=D-M
+@v16
+    AM=D-A
+@16668
+    M=!A
+@L26
+    -M;JLT
+@SP
+(L65)
+(L66)
+(L67)
+(L68)
+(L69)
+(L70)
+(L71)
+(L72)
+(L73)
+(L74)
+(L75)
+(L76)
+(L77)
+(L78)
+(L79)
+(END)
+@END
+    0;JMP
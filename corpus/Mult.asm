@@ -0,0 +1,21 @@
+// Multiplies R0 and R1 and stores the result in R2.
+    @R2
+    M=0
+    @R0
+    D=M
+    @END
+    D;JEQ
+    @i
+    M=D
+(LOOP)
+    @R1
+    D=M
+    @R2
+    M=D+M
+    @i
+    MD=M-1
+    @LOOP
+    D;JGT
+(END)
+    @END
+    0;JMP
@@ -0,0 +1,39 @@
+// Computes R2 = R0 ^ R1 with the subroutine from Math.asm.
+#include "Math.asm"
+    @R2
+    M=1
+    @R1
+    D=M
+    @exponent
+    M=D
+(POW_LOOP)
+    @exponent
+    D=M
+    @END
+    D;JEQ
+    @R2
+    D=M
+    @R13
+    M=D
+    @R0
+    D=M
+    @R14
+    M=D
+    @POW_NEXT
+    D=A
+    @R12
+    M=D
+    @MULTIPLY
+    0;JMP
+(POW_NEXT)
+    @R15
+    D=M
+    @R2
+    M=D
+    @exponent
+    M=M-1
+    @POW_LOOP
+    0;JMP
+(END)
+    @END
+    0;JMP
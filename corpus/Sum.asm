@@ -0,0 +1,27 @@
+// sums 1..R0 (mod 2^16) into R1, repeated R2 times
+    @R1
+    M=0
+(OUTER)
+    @R0
+    D=M
+    @n
+    M=D
+(LOOP)
+    @n
+    D=M
+    @NEXT
+    D;JEQ
+    @R1
+    M=D+M
+    @n
+    M=M-1
+    @LOOP
+    0;JMP
+(NEXT)
+    @R2
+    MD=M-1
+    @OUTER
+    D;JGT
+(END)
+    @END
+    0;JMP
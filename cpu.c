@@ -0,0 +1,396 @@
+/*
+ * File: cpu.c
+ * -----------
+ *  simulates Hack computer running binary hack encodings
+ *
+ *  every ROM word is predecoded once into a handler plus its operands and
+ *  then executed with threaded dispatch (computed goto) over flat RAM
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler.h"
+#include "cpu.h"
+
+/* memory cell currently addressed by A register */
+#define M ram[a & CPU_ADDRESS_MASK]
+
+#define CPU_OP_ENUM(name, code, expr) CPU_OP_##name,
+#define CPU_OP_ENUM_J(name, code, expr) CPU_OP_##name##_J,
+
+/* handler indices, every comp has plain and jumping variant */
+enum {
+    CPU_OP_HALT,
+    CPU_OP_LOAD,
+    CPU_OP_ALU,
+    CPU_OP_ALU_J,
+    CPU_COMPS(CPU_OP_ENUM)
+    CPU_COMPS(CPU_OP_ENUM_J)
+    CPU_OPS_N
+};
+
+/*
+ * Function: comp_opcode
+ * ---------------------
+ *  finds specialized handler for 7 bit 'comp' code
+ *
+ *  comp: 'comp' bits of C command
+ *  jump: 'jump' bits of C command
+ *
+ *  returns: handler index (generic ALU for non standard codes)
+ */
+static uint8_t comp_opcode(uint8_t comp, uint8_t jump)
+{
+#define CPU_OP_MATCH(name, code, expr)                          \
+    if (comp == (code)) {                                       \
+        return jump ? CPU_OP_##name##_J : CPU_OP_##name;        \
+    }
+    CPU_COMPS(CPU_OP_MATCH)
+#undef CPU_OP_MATCH
+
+    return jump ? CPU_OP_ALU_J : CPU_OP_ALU;
+}
+
+/*
+ * Function: alu
+ * -------------
+ *  computes Hack ALU output for any combination of control bits
+ *
+ *  x: first operand (D register)
+ *  y: second operand (A register or M)
+ *  c: control bits zx nx zy ny f no
+ *
+ *  returns: ALU output
+ */
+static uint16_t alu(uint16_t x, uint16_t y, uint8_t c)
+{
+    uint16_t out;
+
+    if (c & 0x20) {
+        x = 0;
+    }
+    if (c & 0x10) {
+        x = ~x;
+    }
+    if (c & 0x08) {
+        y = 0;
+    }
+    if (c & 0x04) {
+        y = ~y;
+    }
+
+    out = (c & 0x02) ? x + y : x & y;
+
+    if (c & 0x01) {
+        out = ~out;
+    }
+
+    return out;
+}
+
+/*
+ * Function: jump_mask
+ * -------------------
+ *  maps ALU output to the 'jump' bit that accepts it
+ *
+ *  v: ALU output
+ *
+ *  returns: 4 (j1) if negative, 2 (j2) if zero, 1 (j3) if positive
+ */
+static inline uint8_t jump_mask(uint16_t v)
+{
+    int16_t s = (int16_t) v;
+    return s < 0 ? 4 : (s == 0 ? 2 : 1);
+}
+
+/*
+ * Function: cpu_new
+ * -----------------
+ *  creates new Hack computer with empty ROM and zeroed RAM
+ *
+ *  returns: pointer to allocated cpu
+ */
+cpu_t *cpu_new(void)
+{
+    cpu_t *cpu = calloc(1, sizeof(cpu_t));
+    cpu_load(cpu, NULL, 0);
+    return cpu;
+}
+
+/*
+ * Function: cpu_del
+ * -----------------
+ *  destroys Hack computer
+ *
+ *  cpu: cpu to be deleted
+ */
+void cpu_del(cpu_t *cpu)
+{
+    free(cpu);
+}
+
+/*
+ * Function: cpu_reset
+ * -------------------
+ *  clears registers and program counter (RAM is left untouched)
+ *
+ *  cpu: cpu to reset
+ */
+void cpu_reset(cpu_t *cpu)
+{
+    cpu->a = 0;
+    cpu->d = 0;
+    cpu->pc = 0;
+    cpu->cycles = 0;
+    cpu->halted = false;
+}
+
+/*
+ * Function: cpu_load
+ * ------------------
+ *  predecodes binary hack encodings into ROM and resets the cpu
+ *
+ *  cpu: cpu to load program into
+ *  words: hack commands encoded by code module
+ *  n: amount of words (at most CPU_ROM_SIZE)
+ */
+void cpu_load(cpu_t *cpu, const uint16_t *words, size_t n)
+{
+    size_t i;
+    cpu_op_t *op;
+
+    memset(cpu->rom, 0, sizeof(cpu->rom));
+
+    for (i = 0; i < n; i++) {
+        op = &cpu->rom[i];
+
+        if (!(words[i] & 0x8000)) {
+            /* A command: 0 v v v v v v v v v v v v v v v */
+            op->opcode = CPU_OP_LOAD;
+            op->operand = words[i];
+        } else {
+            /* C command: 1 1 1 a c1 c2 c3 c4 c5 c6 d1 d2 d3 j1 j2 j3 */
+            op->comp = (words[i] >> 6) & 0x7F;
+            op->dest = (words[i] >> 3) & 0x07;
+            op->jump = words[i] & 0x07;
+            op->opcode = comp_opcode(op->comp, op->jump);
+        }
+    }
+
+    for (i = 0; i < n; i++) {
+        if (cpu_is_halt(words, n, i)) {
+            cpu->rom[i].opcode = CPU_OP_HALT;
+        }
+    }
+
+    /* everything past the program (zeroed, opcode 0) is halt as well */
+    cpu->rom_size = n;
+    cpu->threaded = false;
+    cpu_reset(cpu);
+}
+
+/*
+ * Function: cpu_is_halt
+ * ---------------------
+ *  checks whether the program halts at given address, that is whether it
+ *  holds '@X 0;JMP' self loop at address X which spins forever without
+ *  side effects
+ *
+ *  words: hack commands encoded by code module
+ *  n: amount of words
+ *  address: ROM address to test
+ *
+ *  returns: true if program halts at address
+ *           false otherwise
+ */
+bool cpu_is_halt(const uint16_t *words, size_t n, size_t address)
+{
+    /* 0;JMP and any other non-writing unconditional jump */
+    return address + 1 < n && words[address] == address
+        && (words[address + 1] & 0x8000)
+        && (words[address + 1] & 0x3F) == 0x07;
+}
+
+/*
+ * Function: cpu_read_hack
+ * -----------------------
+ *  reads .hack text (one 16 char binary word per line) from the stream
+ *
+ *  stream: readable hack commands stream
+ *  words: buffer for at least CPU_ROM_SIZE words
+ *
+ *  returns: amount of words read
+ *           -1 if stream has malformed line or too many words
+ */
+long cpu_read_hack(FILE *stream, uint16_t *words)
+{
+    char line[CPU_LINE_MAX];
+    long n = 0;
+    size_t len;
+    int i;
+
+    while (fgets(line, sizeof(line), stream)) {
+        len = strcspn(line, "\r\n");
+
+        if (len == 0) {
+            continue;
+        }
+        if (len != HACK_WORD_SIZE || n == CPU_ROM_SIZE) {
+            return -1;
+        }
+
+        words[n] = 0;
+        for (i = 0; i < HACK_WORD_SIZE; i++) {
+            if (line[i] != '0' && line[i] != '1') {
+                return -1;
+            }
+            words[n] = (words[n] << 1) | (line[i] - '0');
+        }
+        n++;
+    }
+
+    return n;
+}
+
+/*
+ * Function: cpu_run
+ * -----------------
+ *  executes loaded program until it halts or cycle budget is spent
+ *
+ *  program halts when it runs past the end of ROM or enters the
+ *  conventional '@X 0;JMP' self loop at address X
+ *
+ *  cpu: cpu with loaded program
+ *  max_cycles: upper bound of instructions to execute
+ *
+ *  returns: amount of executed instructions
+ */
+uint64_t cpu_run(cpu_t *cpu, uint64_t max_cycles)
+{
+#define CPU_OP_LABEL(name, code, expr) [CPU_OP_##name] = &&op_##name,
+#define CPU_OP_LABEL_J(name, code, expr) [CPU_OP_##name##_J] = &&op_##name##_J,
+    static const void *handlers[CPU_OPS_N] = {
+        [CPU_OP_HALT] = &&op_halt,
+        [CPU_OP_LOAD] = &&op_load,
+        [CPU_OP_ALU] = &&op_alu,
+        [CPU_OP_ALU_J] = &&op_alu_j,
+        CPU_COMPS(CPU_OP_LABEL)
+        CPU_COMPS(CPU_OP_LABEL_J)
+    };
+#undef CPU_OP_LABEL
+#undef CPU_OP_LABEL_J
+
+    cpu_op_t *rom = cpu->rom;
+    cpu_op_t *op;
+    uint16_t *ram = cpu->ram;
+    uint16_t a = cpu->a;
+    uint16_t d = cpu->d;
+    uint16_t v, target;
+    uint64_t budget = max_cycles;
+
+    /* second half of predecoding: opcodes become label addresses */
+    if (!cpu->threaded) {
+        for (size_t i = 0; i <= CPU_ROM_SIZE; i++) {
+            rom[i].handler = handlers[rom[i].opcode];
+        }
+        cpu->threaded = true;
+    }
+
+    if (cpu->halted) {
+        return 0;
+    }
+
+    op = rom + cpu->pc;
+
+/* jumps straight into the handler of the next instruction */
+#define DISPATCH()                 \
+    do {                           \
+        if (budget == 0) {         \
+            goto out_of_budget;    \
+        }                          \
+        budget--;                  \
+        goto *op->handler;         \
+    } while (0)
+
+/* M is written with the address held in A before the command */
+#define STORE(v)                   \
+    do {                           \
+        if (op->dest & 1) {        \
+            M = (v);               \
+        }                          \
+        if (op->dest & 2) {        \
+            d = (v);               \
+        }                          \
+        if (op->dest & 4) {        \
+            a = (v);               \
+        }                          \
+    } while (0)
+
+/* jump target is likewise the A value before the command */
+#define STORE_AND_JUMP(v)                                   \
+    do {                                                    \
+        target = a;                                         \
+        STORE(v);                                           \
+        if (op->jump & jump_mask(v)) {                      \
+            op = rom + (target & CPU_ADDRESS_MASK);         \
+        } else {                                            \
+            op++;                                           \
+        }                                                   \
+    } while (0)
+
+#define CPU_OP_BODY(name, code, expr)      \
+    op_##name:                             \
+        v = (uint16_t) (expr);             \
+        STORE(v);                          \
+        op++;                              \
+        DISPATCH();
+
+#define CPU_OP_BODY_J(name, code, expr)    \
+    op_##name##_J:                         \
+        v = (uint16_t) (expr);             \
+        STORE_AND_JUMP(v);                 \
+        DISPATCH();
+
+    DISPATCH();
+
+op_load:
+    a = op->operand;
+    op++;
+    DISPATCH();
+
+op_alu:
+    v = alu(d, (op->comp & 0x40) ? M : a, op->comp & 0x3F);
+    STORE(v);
+    op++;
+    DISPATCH();
+
+op_alu_j:
+    v = alu(d, (op->comp & 0x40) ? M : a, op->comp & 0x3F);
+    STORE_AND_JUMP(v);
+    DISPATCH();
+
+    CPU_COMPS(CPU_OP_BODY)
+    CPU_COMPS(CPU_OP_BODY_J)
+
+op_halt:
+    /* halt itself is not an executed instruction */
+    budget++;
+    cpu->halted = true;
+
+out_of_budget:
+    cpu->a = a;
+    cpu->d = d;
+    cpu->pc = op - rom;
+    cpu->cycles += max_cycles - budget;
+    return max_cycles - budget;
+
+#undef DISPATCH
+#undef STORE
+#undef STORE_AND_JUMP
+#undef CPU_OP_BODY
+#undef CPU_OP_BODY_J
+}
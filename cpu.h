@@ -0,0 +1,163 @@
+/*
+ * File: cpu.h
+ * -----------
+ *  types, constants and function declarations for cpu module
+ *
+ *  simulates Hack computer running binary hack encodings
+ *
+ *  every ROM word is predecoded once into a handler plus its operands and
+ *  then executed with threaded dispatch (computed goto) over flat RAM
+ */
+
+#ifndef HACK_ASM_CPU_H
+#define HACK_ASM_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CPU_ROM_SIZE 32768
+#define CPU_RAM_SIZE 32768
+#define CPU_ADDRESS_MASK 0x7FFF
+#define CPU_SCREEN 16384
+#define CPU_KBD 24576
+#define CPU_LINE_MAX 64
+
+/*
+ * every standard 'comp' mnemonic listed in code module
+ * X(name, 7 bit comp code, value expression over 'a', 'd' and 'M')
+ */
+#define CPU_COMPS(X)                          \
+    X(ZERO,      0x2A, 0)                     \
+    X(ONE,       0x3F, 1)                     \
+    X(NEG_ONE,   0x3A, -1)                    \
+    X(D,         0x0C, d)                     \
+    X(A,         0x30, a)                     \
+    X(M,         0x70, M)                     \
+    X(NOT_D,     0x0D, ~d)                    \
+    X(NOT_A,     0x31, ~a)                    \
+    X(NOT_M,     0x71, ~M)                    \
+    X(NEG_D,     0x0F, -d)                    \
+    X(NEG_A,     0x33, -a)                    \
+    X(NEG_M,     0x73, -M)                    \
+    X(D_INC,     0x1F, d + 1)                 \
+    X(A_INC,     0x37, a + 1)                 \
+    X(M_INC,     0x77, M + 1)                 \
+    X(D_DEC,     0x0E, d - 1)                 \
+    X(A_DEC,     0x32, a - 1)                 \
+    X(M_DEC,     0x72, M - 1)                 \
+    X(D_ADD_A,   0x02, d + a)                 \
+    X(D_ADD_M,   0x42, d + M)                 \
+    X(D_SUB_A,   0x13, d - a)                 \
+    X(D_SUB_M,   0x53, d - M)                 \
+    X(A_SUB_D,   0x07, a - d)                 \
+    X(M_SUB_D,   0x47, M - d)                 \
+    X(D_AND_A,   0x00, d & a)                 \
+    X(D_AND_M,   0x40, d & M)                 \
+    X(D_OR_A,    0x15, d | a)                 \
+    X(D_OR_M,    0x55, d | M)
+
+typedef struct {
+    const void *handler; /* threaded code entry, resolved by 'cpu_run' */
+    uint16_t operand;    /* value loaded by A command */
+    uint8_t opcode;      /* predecoded handler index */
+    uint8_t comp;        /* raw 'comp' bits (used by generic ALU handler) */
+    uint8_t dest;        /* raw 'dest' bits */
+    uint8_t jump;        /* raw 'jump' bits */
+} cpu_op_t;
+
+typedef struct {
+    cpu_op_t rom[CPU_ROM_SIZE + 1]; /* extra slot is halt sentinel */
+    uint16_t ram[CPU_RAM_SIZE];     /* SCREEN and KBD are mapped here */
+    uint16_t a;
+    uint16_t d;
+    uint16_t pc;
+    uint64_t cycles;                /* total executed instructions */
+    size_t rom_size;
+    bool halted;
+    bool threaded;                  /* handlers are resolved */
+} cpu_t;
+
+/*
+ * Function: cpu_new
+ * -----------------
+ *  creates new Hack computer with empty ROM and zeroed RAM
+ *
+ *  returns: pointer to allocated cpu
+ */
+cpu_t *cpu_new(void);
+
+/*
+ * Function: cpu_del
+ * -----------------
+ *  destroys Hack computer
+ *
+ *  cpu: cpu to be deleted
+ */
+void cpu_del(cpu_t *cpu);
+
+/*
+ * Function: cpu_reset
+ * -------------------
+ *  clears registers and program counter (RAM is left untouched)
+ *
+ *  cpu: cpu to reset
+ */
+void cpu_reset(cpu_t *cpu);
+
+/*
+ * Function: cpu_load
+ * ------------------
+ *  predecodes binary hack encodings into ROM and resets the cpu
+ *
+ *  cpu: cpu to load program into
+ *  words: hack commands encoded by code module
+ *  n: amount of words (at most CPU_ROM_SIZE)
+ */
+void cpu_load(cpu_t *cpu, const uint16_t *words, size_t n);
+
+/*
+ * Function: cpu_is_halt
+ * ---------------------
+ *  checks whether the program halts at given address, that is whether it
+ *  holds '@X 0;JMP' self loop at address X which spins forever without
+ *  side effects
+ *
+ *  words: hack commands encoded by code module
+ *  n: amount of words
+ *  address: ROM address to test
+ *
+ *  returns: true if program halts at address
+ *           false otherwise
+ */
+bool cpu_is_halt(const uint16_t *words, size_t n, size_t address);
+
+/*
+ * Function: cpu_read_hack
+ * -----------------------
+ *  reads .hack text (one 16 char binary word per line) from the stream
+ *
+ *  stream: readable hack commands stream
+ *  words: buffer for at least CPU_ROM_SIZE words
+ *
+ *  returns: amount of words read
+ *           -1 if stream has malformed line or too many words
+ */
+long cpu_read_hack(FILE *stream, uint16_t *words);
+
+/*
+ * Function: cpu_run
+ * -----------------
+ *  executes loaded program until it halts or cycle budget is spent
+ *
+ *  program halts when it runs past the end of ROM or enters the
+ *  conventional '@X 0;JMP' self loop at address X
+ *
+ *  cpu: cpu with loaded program
+ *  max_cycles: upper bound of instructions to execute
+ *
+ *  returns: amount of executed instructions
+ */
+uint64_t cpu_run(cpu_t *cpu, uint64_t max_cycles);
+
+#endif // !HACK_ASM_CPU_H
@@ -0,0 +1,265 @@
+/*
+ * File: ctable.c
+ * --------------
+ *  lock free dictionary ADT for symbol-address mappings shared by threads
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ctable.h"
+
+/*
+ * Function: hash
+ * --------------
+ *  hashing function for string keys (FNV-1a), bucket is chosen by its
+ *  low bits
+ *
+ *  s: key to hash
+ *
+ *  returns: hash code of the given key
+ */
+static size_t hash(const char *s)
+{
+    uint64_t h = 14695981039346656037ull;
+
+    for (const unsigned char *p = (const unsigned char *) s; *p; p++) {
+        h = (h ^ *p) * 1099511628211ull;
+    }
+
+    return h ^ (h >> 32);
+}
+
+/*
+ * Function: node_new
+ * ------------------
+ *  creates new table entry holding its own copy of the key
+ *
+ *  key: key associated with table entry
+ *  val: value associated with key
+ *
+ *  returns: pointer to newly allocated table entry
+ */
+static ctable_node_t *node_new(const char *key, int32_t val)
+{
+    size_t key_len = strlen(key) + 1;
+    ctable_node_t *node = malloc(sizeof(ctable_node_t) + key_len);
+
+    node->next = NULL;
+    atomic_init(&node->val, val);
+    memcpy(node->key, key, key_len);
+    return node;
+}
+
+/*
+ * Function: find
+ * --------------
+ *  searches chain of published nodes up to (not including) the given node
+ *
+ *  node: first node of the chain
+ *  stop: node where the search ends (NULL for the whole chain)
+ *  symbol: target key
+ *
+ *  returns: node with the key
+ *           NULL if there is no such node
+ */
+static ctable_node_t *find(ctable_node_t *node, ctable_node_t *stop,
+        const char *symbol)
+{
+    for (; node != stop; node = node->next) {
+        if (!strcmp(node->key, symbol)) {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Function: merge_val
+ * -------------------
+ *  merges value into stored entry
+ *
+ *  node: stored entry
+ *  val: value being inserted
+ *  merge: rule choosing the value
+ *
+ *  returns: value of the entry after the merge
+ */
+static int32_t merge_val(ctable_node_t *node, int32_t val,
+        ctable_merge_t merge)
+{
+    int32_t stored = atomic_load_explicit(&node->val, memory_order_relaxed);
+
+    switch (merge) {
+        case CTABLE_KEEP:
+            return stored;
+        case CTABLE_REPLACE:
+            atomic_store_explicit(&node->val, val, memory_order_relaxed);
+            return val;
+        case CTABLE_MIN:
+        case CTABLE_MAX:
+            /* failed exchange reloads stored value, so loop ends as soon
+             * as stored value is at least as good as the new one */
+            while (merge == CTABLE_MIN ? val < stored : val > stored) {
+                if (atomic_compare_exchange_weak_explicit(&node->val,
+                            &stored, val, memory_order_relaxed,
+                            memory_order_relaxed)) {
+                    return val;
+                }
+            }
+            return stored;
+    }
+
+    return stored;
+}
+
+/*
+ * Function: ctable_new
+ * --------------------
+ *  creates new concurrent table, bucket count is fixed for its life time
+ *
+ *  size_hint: expected amount of entries
+ *
+ *  returns: pointer to allocated empty table
+ */
+ctable_t *ctable_new(size_t size_hint)
+{
+    ctable_t *table = malloc(sizeof(ctable_t));
+    size_t buckets_n = CTABLE_MIN_BUCKETS;
+
+    /* at most one entry per bucket on average */
+    while (buckets_n < size_hint) {
+        buckets_n *= 2;
+    }
+
+    table->buckets = malloc(buckets_n * sizeof(*table->buckets));
+    for (size_t i = 0; i < buckets_n; i++) {
+        atomic_init(&table->buckets[i], NULL);
+    }
+    table->mask = buckets_n - 1;
+    atomic_init(&table->size, 0);
+    return table;
+}
+
+/*
+ * Function: ctable_del
+ * --------------------
+ *  destroys concurrent table (no thread may use it anymore)
+ *
+ *  table: table to be deleted
+ */
+void ctable_del(ctable_t *table)
+{
+    ctable_node_t *p, *q;
+
+    for (size_t i = 0; i <= table->mask; i++) {
+        p = atomic_load_explicit(&table->buckets[i], memory_order_relaxed);
+        for (; p; p = q) {
+            q = p->next;
+            free(p);
+        }
+    }
+
+    free(table->buckets);
+    free(table);
+}
+
+/*
+ * Function: ctable_put
+ * --------------------
+ *  inserts the entry or merges its value with the stored one (thread safe)
+ *
+ *  table: table to write to
+ *  symbol: key of the entry
+ *  val: value of the entry
+ *  merge: rule choosing value when the key is already stored
+ *
+ *  returns: value stored for the key after the merge
+ */
+int32_t ctable_put(ctable_t *table, const char *symbol, int32_t val,
+        ctable_merge_t merge)
+{
+    _Atomic(ctable_node_t *) *bucket =
+        &table->buckets[hash(symbol) & table->mask];
+    ctable_node_t *head = atomic_load_explicit(bucket, memory_order_acquire);
+    ctable_node_t *stop = NULL, *node = NULL, *found;
+
+    for (;;) {
+        /* nodes below the last seen head were already searched */
+        if ((found = find(head, stop, symbol))) {
+            free(node);
+            return merge_val(found, val, merge);
+        }
+
+        if (!node) {
+            node = node_new(symbol, val);
+        }
+        node->next = head;
+
+        /* release publishes the node's key and next with it */
+        if (atomic_compare_exchange_weak_explicit(bucket, &head, node,
+                    memory_order_release, memory_order_acquire)) {
+            atomic_fetch_add_explicit(&table->size, 1, memory_order_relaxed);
+            return val;
+        }
+        stop = node->next;
+    }
+}
+
+/*
+ * Function: ctable_get
+ * --------------------
+ *  searches for the value associated with the given symbol (thread safe,
+ *  lock free)
+ *
+ *  table: table to search in
+ *  symbol: target symbol
+ *
+ *  returns: value associated with symbol key
+ *           -1 if symbol is not found
+ */
+int32_t ctable_get(ctable_t *table, const char *symbol)
+{
+    _Atomic(ctable_node_t *) *bucket =
+        &table->buckets[hash(symbol) & table->mask];
+    ctable_node_t *node = find(atomic_load_explicit(bucket,
+                memory_order_acquire), NULL, symbol);
+
+    return node ? atomic_load_explicit(&node->val, memory_order_relaxed) : -1;
+}
+
+/*
+ * Function: ctable_entries
+ * ------------------------
+ *  lists every entry of the table in unspecified order (keys point into
+ *  the table), only meaningful once inserting threads are joined
+ *
+ *  !!! user in charge of freeing the list
+ *
+ *  table: table to list
+ *  n_ptr: amount of entries
+ *
+ *  returns: list of entries
+ */
+ctable_entry_t *ctable_entries(ctable_t *table, size_t *n_ptr)
+{
+    size_t size = atomic_load(&table->size), n = 0;
+    ctable_entry_t *entries = malloc((size ? size : 1)
+            * sizeof(ctable_entry_t));
+    ctable_node_t *p;
+
+    for (size_t i = 0; i <= table->mask; i++) {
+        p = atomic_load_explicit(&table->buckets[i], memory_order_acquire);
+        for (; p && n < size; p = p->next) {
+            entries[n].key = p->key;
+            entries[n++].val = atomic_load(&p->val);
+        }
+    }
+
+    *n_ptr = n;
+    return entries;
+}
@@ -0,0 +1,120 @@
+/*
+ * File: ctable.h
+ * --------------
+ *  types, constants and function declarations for concurrent symbol table
+ *  module
+ *
+ *  dictionary ADT for symbol-address mappings shared by threads: lookups
+ *  take no locks and inserts publish entries with single compare and swap
+ *  on head of their bucket, so any amount of threads can insert and look
+ *  up at the same time
+ *
+ *  entries are never removed or moved and keys never change, only values
+ *  are updated (atomically), so found entry stays valid until the table
+ *  is deleted
+ *
+ *  when threads race to insert equal key the outcome doesn't depend on
+ *  their order: value is merged with the one already stored by the given
+ *  rule (smaller or larger one wins), e.g. threads storing index of the
+ *  first use of a variable end up with the same table as a single thread
+ */
+
+#ifndef HACK_ASM_CTABLE_H
+#define HACK_ASM_CTABLE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CTABLE_MIN_BUCKETS 64
+
+typedef enum {
+    CTABLE_KEEP,    /* stored value stays (first insert wins) */
+    CTABLE_REPLACE, /* stored value is overwritten (last insert wins) */
+    CTABLE_MIN,     /* smaller value wins */
+    CTABLE_MAX      /* larger value wins */
+} ctable_merge_t;
+
+typedef struct ctable_node_t {
+    struct ctable_node_t *next; /* set before the node is published */
+    _Atomic int32_t val;
+    char key[];
+} ctable_node_t;
+
+typedef struct {
+    _Atomic(ctable_node_t *) *buckets;
+    size_t mask;           /* amount of buckets minus one */
+    atomic_size_t size;
+} ctable_t;
+
+typedef struct {
+    const char *key;
+    int32_t val;
+} ctable_entry_t;
+
+/*
+ * Function: ctable_new
+ * --------------------
+ *  creates new concurrent table, bucket count is fixed for its life time
+ *
+ *  size_hint: expected amount of entries
+ *
+ *  returns: pointer to allocated empty table
+ */
+ctable_t *ctable_new(size_t size_hint);
+
+/*
+ * Function: ctable_del
+ * --------------------
+ *  destroys concurrent table (no thread may use it anymore)
+ *
+ *  table: table to be deleted
+ */
+void ctable_del(ctable_t *table);
+
+/*
+ * Function: ctable_put
+ * --------------------
+ *  inserts the entry or merges its value with the stored one (thread safe)
+ *
+ *  table: table to write to
+ *  symbol: key of the entry
+ *  val: value of the entry
+ *  merge: rule choosing value when the key is already stored
+ *
+ *  returns: value stored for the key after the merge
+ */
+int32_t ctable_put(ctable_t *table, const char *symbol, int32_t val,
+        ctable_merge_t merge);
+
+/*
+ * Function: ctable_get
+ * --------------------
+ *  searches for the value associated with the given symbol (thread safe,
+ *  lock free)
+ *
+ *  table: table to search in
+ *  symbol: target symbol
+ *
+ *  returns: value associated with symbol key
+ *           -1 if symbol is not found
+ */
+int32_t ctable_get(ctable_t *table, const char *symbol);
+
+/*
+ * Function: ctable_entries
+ * ------------------------
+ *  lists every entry of the table in unspecified order (keys point into
+ *  the table), only meaningful once inserting threads are joined
+ *
+ *  !!! user in charge of freeing the list
+ *
+ *  table: table to list
+ *  n_ptr: amount of entries
+ *
+ *  returns: list of entries
+ */
+ctable_entry_t *ctable_entries(ctable_t *table, size_t *n_ptr);
+
+#endif // !HACK_ASM_CTABLE_H
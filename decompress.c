@@ -0,0 +1,354 @@
+/*
+ * File: decompress.c
+ * ------------------
+ *  opens gzip or zstd compressed sources as plain readable streams
+ *
+ *  small inputs are inflated into memory, larger ones are inflated on
+ *  separate thread into a pipe, so decompression overlaps with parsing
+ *  and no expanded copy ever hits the disk
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HACK_ASM_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HACK_ASM_ZSTD
+#include <zstd.h>
+#endif
+
+#include "decompress.h"
+#include "helpers.h"
+
+#ifdef HACK_ASM_ZLIB
+/*
+ * Function: inflate_gzip
+ * ----------------------
+ *  inflates gzip file into the sink
+ *
+ *  path: compressed file path
+ *  sink: writable stream
+ *
+ *  returns: true if whole file was inflated
+ *           false otherwise
+ */
+static bool inflate_gzip(const char *path, FILE *sink)
+{
+    unsigned char *in_buffer = malloc(DECOMPRESS_BUFFER_SIZE);
+    unsigned char *out_buffer = malloc(DECOMPRESS_BUFFER_SIZE);
+    z_stream z = { 0 };
+    size_t n, out_n;
+    int status = Z_OK;
+    bool ok = true;
+    FILE *stream;
+
+    if (!(stream = fopen(path, "rb"))) {
+        ok = false;
+    }
+    /* 16 + MAX_WBITS accepts gzip wrapper only */
+    inflateInit2(&z, 16 + MAX_WBITS);
+
+    while (ok && (n = fread(in_buffer, 1, DECOMPRESS_BUFFER_SIZE, stream)) > 0) {
+        z.next_in = in_buffer;
+        z.avail_in = n;
+
+        /* full output buffer means inflate may still hold pending output */
+        while (ok && (z.avail_in > 0 || z.avail_out == 0)) {
+            /* concatenated gzip members form single stream */
+            if (status == Z_STREAM_END) {
+                if (z.avail_in == 0) {
+                    break;
+                }
+                inflateReset(&z);
+            }
+
+            z.next_out = out_buffer;
+            z.avail_out = DECOMPRESS_BUFFER_SIZE;
+            if ((status = inflate(&z, Z_NO_FLUSH)) == Z_BUF_ERROR) {
+                /* no progress is possible until more input is read */
+                status = Z_OK;
+                break;
+            }
+
+            out_n = DECOMPRESS_BUFFER_SIZE - z.avail_out;
+            ok = (status == Z_OK || status == Z_STREAM_END)
+                && fwrite(out_buffer, 1, out_n, sink) == out_n;
+        }
+    }
+
+    /* input that ends in the middle of a member is truncated */
+    ok = ok && status == Z_STREAM_END;
+
+    if (stream) {
+        fclose(stream);
+    }
+    inflateEnd(&z);
+    free(in_buffer);
+    free(out_buffer);
+    return ok;
+}
+#endif
+
+#ifdef HACK_ASM_ZSTD
+/*
+ * Function: inflate_zstd
+ * ----------------------
+ *  inflates zstd file into the sink
+ *
+ *  path: compressed file path
+ *  sink: writable stream
+ *
+ *  returns: true if whole file was inflated
+ *           false otherwise
+ */
+static bool inflate_zstd(const char *path, FILE *sink)
+{
+    size_t in_size = ZSTD_DStreamInSize(), out_size = ZSTD_DStreamOutSize();
+    char *in_buffer = malloc(in_size), *out_buffer = malloc(out_size);
+    ZSTD_DStream *zstd = ZSTD_createDStream();
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    size_t n, left = 0;
+    bool ok = true;
+    FILE *stream;
+
+    if (!(stream = fopen(path, "rb"))) {
+        ok = false;
+    }
+    ZSTD_initDStream(zstd);
+
+    while (ok && (n = fread(in_buffer, 1, in_size, stream)) > 0) {
+        in.src = in_buffer;
+        in.size = n;
+        in.pos = 0;
+
+        while (ok && in.pos < in.size) {
+            out.dst = out_buffer;
+            out.size = out_size;
+            out.pos = 0;
+
+            left = ZSTD_decompressStream(zstd, &out, &in);
+            ok = !ZSTD_isError(left)
+                && fwrite(out_buffer, 1, out.pos, sink) == out.pos;
+        }
+    }
+
+    /* non zero hint at the end means the last frame is truncated */
+    ok = ok && left == 0;
+
+    if (stream) {
+        fclose(stream);
+    }
+    ZSTD_freeDStream(zstd);
+    free(in_buffer);
+    free(out_buffer);
+    return ok;
+}
+#endif
+
+/*
+ * Function: inflate_file
+ * ----------------------
+ *  inflates compressed file into the sink choosing format by suffix
+ *
+ *  path: compressed file path
+ *  sink: writable stream
+ *
+ *  returns: true if whole file was inflated
+ *           false otherwise
+ */
+static bool inflate_file(const char *path, FILE *sink)
+{
+#ifdef HACK_ASM_ZLIB
+    if (str_ends_with(path, GZIP_SUFFIX)) {
+        return inflate_gzip(path, sink);
+    }
+#endif
+#ifdef HACK_ASM_ZSTD
+    if (str_ends_with(path, ZSTD_SUFFIX)) {
+        return inflate_zstd(path, sink);
+    }
+#endif
+    return false;
+}
+
+/*
+ * Function: inflate_thread
+ * ------------------------
+ *  thread routine inflating file into write end of the pipe
+ *
+ *  arg: decompressor
+ *
+ *  returns: NULL
+ */
+static void *inflate_thread(void *arg)
+{
+    decompress_t *decompressor = arg;
+
+    decompressor->ok = inflate_file(decompressor->path, decompressor->sink);
+
+    /* closing write end lets the reader see end of file */
+    fclose(decompressor->sink);
+    return NULL;
+}
+
+/*
+ * Function: decompress_supported
+ * ------------------------------
+ *  checks wether the path has compression suffix this build can read
+ *
+ *  path: file path
+ *
+ *  returns: true if the file is compressed with supported format
+ *           false otherwise
+ */
+bool decompress_supported(const char *path)
+{
+#ifdef HACK_ASM_ZLIB
+    if (str_ends_with(path, GZIP_SUFFIX)) {
+        return true;
+    }
+#endif
+#ifdef HACK_ASM_ZSTD
+    if (str_ends_with(path, ZSTD_SUFFIX)) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+/*
+ * Function: decompress_suffix_len
+ * -------------------------------
+ *  finds length of compression suffix of the path
+ *
+ *  path: file path
+ *
+ *  returns: length of '.gz' or '.zst' suffix
+ *           0 if path has none
+ */
+size_t decompress_suffix_len(const char *path)
+{
+    if (str_ends_with(path, GZIP_SUFFIX)) {
+        return strlen(GZIP_SUFFIX);
+    }
+    if (str_ends_with(path, ZSTD_SUFFIX)) {
+        return strlen(ZSTD_SUFFIX);
+    }
+    return 0;
+}
+
+/*
+ * Function: decompress_open
+ * -------------------------
+ *  opens compressed file as stream of its decompressed content
+ *
+ *  path: compressed file path (with supported suffix)
+ *
+ *  returns: pointer to allocated decompressor
+ *           NULL if file can't be opened
+ */
+decompress_t *decompress_open(const char *path)
+{
+    decompress_t *decompressor;
+    struct stat st;
+    int fds[2];
+
+    if (stat(path, &st)) {
+        return NULL;
+    }
+
+    decompressor = calloc(1, sizeof(decompress_t));
+    decompressor->path = path;
+
+    /* thread and pipe don't pay off for small inputs */
+    if (st.st_size < DECOMPRESS_THREAD_MIN || pipe(fds)) {
+        decompressor->sink = open_memstream(&decompressor->text,
+                &decompressor->text_len);
+        decompressor->ok = inflate_file(path, decompressor->sink);
+        fclose(decompressor->sink);
+        decompressor->stream = fmemopen(decompressor->text,
+                decompressor->text_len, "r");
+        return decompressor;
+    }
+
+    decompressor->threaded = true;
+    decompressor->stream = fdopen(fds[0], "r");
+    decompressor->sink = fdopen(fds[1], "w");
+    setvbuf(decompressor->stream, NULL, _IOFBF, DECOMPRESS_BUFFER_SIZE);
+    setvbuf(decompressor->sink, NULL, _IOFBF, DECOMPRESS_BUFFER_SIZE);
+    pthread_create(&decompressor->thread, NULL, inflate_thread, decompressor);
+
+    return decompressor;
+}
+
+/*
+ * Function: decompress_buffer
+ * ---------------------------
+ *  inflates the rest of threaded input into memory, so its integrity is
+ *  known before the caller reads it
+ *
+ *  decompressor: decompressor (small inputs are left as they are)
+ *
+ *  returns: true if whole file was inflated without errors
+ *           false otherwise
+ */
+bool decompress_buffer(decompress_t *decompressor)
+{
+    char buffer[BUFSIZ];
+    size_t len;
+    FILE *sink;
+
+    if (!decompressor->threaded) {
+        return decompressor->ok;
+    }
+
+    sink = open_memstream(&decompressor->text, &decompressor->text_len);
+    while ((len = fread(buffer, 1, sizeof(buffer), decompressor->stream)) > 0) {
+        fwrite(buffer, 1, len, sink);
+    }
+    fclose(sink);
+    pthread_join(decompressor->thread, NULL);
+    fclose(decompressor->stream);
+
+    decompressor->threaded = false;
+    decompressor->stream = fmemopen(decompressor->text,
+            decompressor->text_len, "r");
+    return decompressor->ok;
+}
+
+/*
+ * Function: decompress_close
+ * --------------------------
+ *  closes decompressed stream and destroys decompressor
+ *
+ *  decompressor: decompressor to be deleted
+ *
+ *  returns: true if whole file was inflated without errors
+ *           false otherwise
+ */
+bool decompress_close(decompress_t *decompressor)
+{
+    char buffer[BUFSIZ];
+    bool ok;
+
+    if (decompressor->threaded) {
+        /* drain the pipe, so the thread never blocks on closed reader */
+        while (fread(buffer, 1, sizeof(buffer), decompressor->stream) > 0)
+            ;
+        pthread_join(decompressor->thread, NULL);
+    }
+
+    fclose(decompressor->stream);
+    free(decompressor->text);
+
+    ok = decompressor->ok;
+    free(decompressor);
+    return ok;
+}
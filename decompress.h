@@ -0,0 +1,96 @@
+/*
+ * File: decompress.h
+ * ------------------
+ *  types, constants and function declarations for decompress module
+ *
+ *  opens gzip (HACK_ASM_ZLIB) or zstd (HACK_ASM_ZSTD) compressed sources as
+ *  plain readable streams, large inputs are inflated on separate thread
+ *  while the parser consumes them through a pipe
+ */
+
+#ifndef HACK_ASM_DECOMPRESS_H
+#define HACK_ASM_DECOMPRESS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define GZIP_SUFFIX ".gz"
+#define ZSTD_SUFFIX ".zst"
+
+#define DECOMPRESS_BUFFER_SIZE (256 * 1024)
+#define DECOMPRESS_THREAD_MIN (1024 * 1024) /* compressed bytes */
+
+typedef struct {
+    FILE *stream;     /* readable stream of decompressed text */
+    const char *path; /* compressed file path */
+    FILE *sink;       /* write end the text is inflated to */
+    char *text;       /* inflated text of small input (or NULL) */
+    size_t text_len;
+    pthread_t thread;
+    bool threaded;
+    bool ok;
+} decompress_t;
+
+/*
+ * Function: decompress_supported
+ * ------------------------------
+ *  checks wether the path has compression suffix this build can read
+ *
+ *  path: file path
+ *
+ *  returns: true if the file is compressed with supported format
+ *           false otherwise
+ */
+bool decompress_supported(const char *path);
+
+/*
+ * Function: decompress_suffix_len
+ * -------------------------------
+ *  finds length of compression suffix of the path
+ *
+ *  path: file path
+ *
+ *  returns: length of '.gz' or '.zst' suffix
+ *           0 if path has none
+ */
+size_t decompress_suffix_len(const char *path);
+
+/*
+ * Function: decompress_open
+ * -------------------------
+ *  opens compressed file as stream of its decompressed content
+ *
+ *  path: compressed file path (with supported suffix)
+ *
+ *  returns: pointer to allocated decompressor
+ *           NULL if file can't be opened
+ */
+decompress_t *decompress_open(const char *path);
+
+/*
+ * Function: decompress_buffer
+ * ---------------------------
+ *  inflates the rest of threaded input into memory, so its integrity is
+ *  known before the caller reads it
+ *
+ *  decompressor: decompressor (small inputs are left as they are)
+ *
+ *  returns: true if whole file was inflated without errors
+ *           false otherwise
+ */
+bool decompress_buffer(decompress_t *decompressor);
+
+/*
+ * Function: decompress_close
+ * --------------------------
+ *  closes decompressed stream and destroys decompressor
+ *
+ *  decompressor: decompressor to be deleted
+ *
+ *  returns: true if whole file was inflated without errors
+ *           false otherwise
+ */
+bool decompress_close(decompress_t *decompressor);
+
+#endif // !HACK_ASM_DECOMPRESS_H
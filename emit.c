@@ -0,0 +1,417 @@
+/*
+ * File: emit.c
+ * ------------
+ *  output emitters writing encoded program as .hack text, raw binary,
+ *  Intel HEX or Verilog memory image
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "emit.h"
+#include "helpers.h"
+
+#define HEX_DIGITS "0123456789ABCDEF"
+#define HEX_DATA 0x00
+#define HEX_END 0x01
+#define HEX_SEGMENT 0x04 /* extended linear address */
+#define MEM_HEADER "// HACK ROM image, load with $readmemb\n"
+
+/*
+ * Function: emitter_compare
+ * -------------------------
+ *  compares buffered bytes with next chunk of existing image and records
+ *  the word that produced the first differing byte
+ *
+ *  emitter: checking emitter
+ */
+static void emitter_compare(emitter_t *emitter)
+{
+    size_t n = fread(emitter->expected, 1, emitter->used, emitter->stream);
+    size_t first = 0, mark = 0;
+
+    if (n == emitter->used
+            && !memcmp(emitter->buffer, emitter->expected, n)) {
+        return;
+    }
+
+    /* slow path runs once: locate the byte and the word owning it */
+    while (first < n && emitter->buffer[first] == emitter->expected[first]) {
+        first++;
+    }
+    while (mark + 1 < emitter->marks_n
+            && emitter->marks[mark + 1].offset <= first) {
+        mark++;
+    }
+
+    emitter->ok = false;
+    emitter->mismatched = true;
+    emitter->mismatch = emitter->marks_n
+        ? emitter->marks[mark].word : emitter->mark_word;
+}
+
+/*
+ * Function: emitter_flush
+ * -----------------------
+ *  writes buffered bytes into the stream (or compares them with it)
+ *
+ *  emitter: emitter
+ */
+static void emitter_flush(emitter_t *emitter)
+{
+    if (emitter->used > 0 && emitter->ok) {
+        if (emitter->expected) {
+            emitter_compare(emitter);
+        } else if (fwrite(emitter->buffer, 1, emitter->used,
+                    emitter->stream) != emitter->used) {
+            emitter->ok = false;
+        }
+    }
+    emitter->used = 0;
+    emitter->marks_n = 0;
+}
+
+/*
+ * Function: emitter_reserve
+ * -------------------------
+ *  makes room for 'len' more bytes in the buffer
+ *
+ *  emitter: emitter
+ *  len: amount of bytes (at most EMIT_BUFFER_SIZE)
+ *
+ *  returns: pointer to reserved bytes
+ */
+static char *emitter_reserve(emitter_t *emitter, size_t len)
+{
+    char *reserved;
+
+    if (emitter->used + len > EMIT_BUFFER_SIZE) {
+        emitter_flush(emitter);
+    }
+    if (emitter->marks) {
+        emitter->marks[emitter->marks_n].offset = emitter->used;
+        emitter->marks[emitter->marks_n++].word = emitter->mark_word;
+    }
+    reserved = emitter->buffer + emitter->used;
+    emitter->used += len;
+    return reserved;
+}
+
+/*
+ * Function: emit_hack_line
+ * ------------------------
+ *  formats 'code' as sequence of 0's and 1's followed by new line
+ *
+ *  line: buffer of at least 'width' + 1 chars (no '\0' is added)
+ *  code: hack command code
+ *  width: bits per word
+ */
+void emit_hack_line(char *line, uint32_t code, int width)
+{
+    for (int i = 0; i < width; i++) {
+        /* extracts i-th most significat binary digit and
+         * coverts it to ASCII char */
+        line[i] = ((code >> (width - i - 1)) & 1) + '0';
+    }
+    line[width] = '\n';
+}
+
+/*
+ * Function: hack_word
+ * -------------------
+ *  emits word as line of .hack text
+ */
+static void hack_word(emitter_t *emitter, uint32_t code)
+{
+    emit_hack_line(emitter_reserve(emitter, emitter->width + 1), code,
+            emitter->width);
+}
+
+/*
+ * Function: bin_word
+ * ------------------
+ *  emits word as two raw bytes, most significant first
+ */
+static void bin_word(emitter_t *emitter, uint32_t code)
+{
+    int n = emitter->width / 8;
+    char *bytes = emitter_reserve(emitter, n);
+
+    for (int i = 0; i < n; i++) {
+        bytes[i] = code >> (8 * (n - i - 1));
+    }
+}
+
+/*
+ * Function: mem_begin
+ * -------------------
+ *  emits header comment of Verilog memory image
+ */
+static void mem_begin(emitter_t *emitter)
+{
+    memcpy(emitter_reserve(emitter, strlen(MEM_HEADER)), MEM_HEADER,
+            strlen(MEM_HEADER));
+}
+
+/*
+ * Function: hex_record
+ * --------------------
+ *  emits single Intel HEX record ':LLAAAATT<data>CC'
+ *
+ *  emitter: emitter
+ *  type: record type
+ *  address: lower 16 bits of record address
+ *  data: record data
+ *  len: amount of data bytes
+ */
+static void hex_record(emitter_t *emitter, uint8_t type, uint16_t address,
+        const uint8_t *data, size_t len)
+{
+    char *line = emitter_reserve(emitter, 1 + 2 * (4 + len + 1) + 1);
+    uint8_t bytes[4 + EMIT_HEX_RECORD_SIZE + 1];
+    uint8_t sum = 0;
+    size_t n = 0;
+
+    bytes[n++] = len;
+    bytes[n++] = address >> 8;
+    bytes[n++] = address & 0xFF;
+    bytes[n++] = type;
+    for (size_t i = 0; i < len; i++) {
+        bytes[n++] = data[i];
+    }
+    for (size_t i = 0; i < n; i++) {
+        sum += bytes[i];
+    }
+    bytes[n++] = -sum; /* bytes of the record sum to zero */
+
+    *line++ = ':';
+    for (size_t i = 0; i < n; i++) {
+        *line++ = HEX_DIGITS[bytes[i] >> 4];
+        *line++ = HEX_DIGITS[bytes[i] & 0xF];
+    }
+    *line = '\n';
+}
+
+/*
+ * Function: hex_flush_record
+ * --------------------------
+ *  emits pending data bytes as data record, preceded by extended linear
+ *  address record whenever the data crosses into next 64K segment
+ *
+ *  emitter: emitter
+ */
+static void hex_flush_record(emitter_t *emitter)
+{
+    size_t start = emitter->address - emitter->record_n;
+    uint8_t segment[2];
+
+    if (emitter->record_n == 0) {
+        return;
+    }
+    emitter->mark_word = start / (emitter->width / 8);
+
+    if ((start >> 16) != emitter->segment) {
+        emitter->segment = start >> 16;
+        segment[0] = emitter->segment >> 8;
+        segment[1] = emitter->segment & 0xFF;
+        hex_record(emitter, HEX_SEGMENT, 0, segment, 2);
+    }
+
+    hex_record(emitter, HEX_DATA, start & 0xFFFF, emitter->record,
+            emitter->record_n);
+    emitter->record_n = 0;
+}
+
+/*
+ * Function: hex_word
+ * ------------------
+ *  adds word to pending Intel HEX record, most significant byte first
+ */
+static void hex_word(emitter_t *emitter, uint32_t code)
+{
+    int n = emitter->width / 8;
+
+    for (int i = 0; i < n; i++) {
+        emitter->record[emitter->record_n++] = code >> (8 * (n - i - 1));
+    }
+    emitter->address += n;
+
+    /* records are aligned, so they never straddle 64K segments */
+    if (emitter->record_n == EMIT_HEX_RECORD_SIZE) {
+        hex_flush_record(emitter);
+    }
+}
+
+/*
+ * Function: hex_end
+ * -----------------
+ *  emits last data record and end of file record
+ */
+static void hex_end(emitter_t *emitter)
+{
+    hex_flush_record(emitter);
+    hex_record(emitter, HEX_END, 0, NULL, 0);
+}
+
+static const emit_format_t formats[] = {
+    { ".hack", NULL, hack_word, NULL },
+    { ".bin", NULL, bin_word, NULL },
+    { ".hex", NULL, hex_word, hex_end },
+    { ".mem", mem_begin, hack_word, NULL },
+};
+
+/*
+ * Function: emit_format
+ * ---------------------
+ *  finds output format by suffix of the path
+ *
+ *  path: output path
+ *
+ *  returns: pointer to format
+ *           NULL if suffix names no format
+ */
+const emit_format_t *emit_format(const char *path)
+{
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (str_ends_with(path, formats[i].suffix)) {
+            return &formats[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function: emitter_new
+ * ---------------------
+ *  creates emitter writing given format into the stream
+ *
+ *  stream: writable binary stream (stays open after emitter is closed)
+ *  format: output format
+ *  width: bits per word (16 or 32)
+ *
+ *  returns: pointer to allocated emitter
+ */
+emitter_t *emitter_new(FILE *stream, const emit_format_t *format, int width)
+{
+    emitter_t *emitter = calloc(1, sizeof(emitter_t));
+
+    emitter->format = format;
+    emitter->stream = stream;
+    emitter->width = width;
+    emitter->ok = true;
+
+    if (format->begin) {
+        format->begin(emitter);
+    }
+    return emitter;
+}
+
+/*
+ * Function: emitter_new_check
+ * ---------------------------
+ *  creates emitter comparing given format with existing image instead of
+ *  writing it
+ *
+ *  stream: readable binary stream of existing image
+ *  format: output format
+ *  width: bits per word (16 or 32)
+ *
+ *  returns: pointer to allocated emitter
+ */
+emitter_t *emitter_new_check(FILE *stream, const emit_format_t *format,
+        int width)
+{
+    emitter_t *emitter = calloc(1, sizeof(emitter_t));
+
+    emitter->format = format;
+    emitter->stream = stream;
+    emitter->width = width;
+    emitter->ok = true;
+    emitter->expected = malloc(EMIT_BUFFER_SIZE);
+    emitter->marks = malloc(EMIT_MARKS_MAX * sizeof(emit_mark_t));
+
+    if (format->begin) {
+        format->begin(emitter);
+    }
+    return emitter;
+}
+
+/*
+ * Function: emitter_word
+ * ----------------------
+ *  emits next word of the program
+ *
+ *  emitter: emitter
+ *  code: hack command code
+ *
+ *  returns: false once output can't be written or differs from existing
+ *           image (later words are ignored then)
+ *           true otherwise
+ */
+bool emitter_word(emitter_t *emitter, uint32_t code)
+{
+    if (!emitter->ok) {
+        return false;
+    }
+    emitter->mark_word = emitter->words++;
+    emitter->format->word(emitter, code);
+    return emitter->ok;
+}
+
+/*
+ * Function: emitter_finish
+ * ------------------------
+ *  finishes the image and flushes buffer into the stream, checking
+ *  emitter also requires existing image to end right there
+ *
+ *  emitter: emitter
+ *
+ *  returns: true if everything was written (or matched)
+ *           false otherwise
+ */
+bool emitter_finish(emitter_t *emitter)
+{
+    if (emitter->finished) {
+        return emitter->ok;
+    }
+    emitter->finished = true;
+
+    if (emitter->ok && emitter->format->end) {
+        emitter->mark_word = emitter->words;
+        emitter->format->end(emitter);
+    }
+    emitter_flush(emitter);
+
+    if (!emitter->expected) {
+        emitter->ok = emitter->ok && !fflush(emitter->stream);
+    } else if (emitter->ok && fgetc(emitter->stream) != EOF) {
+        /* existing image holds more than the program */
+        emitter->ok = false;
+        emitter->mismatched = true;
+        emitter->mismatch = emitter->words;
+    }
+    return emitter->ok;
+}
+
+/*
+ * Function: emitter_close
+ * -----------------------
+ *  finishes the image unless it is finished already and destroys emitter
+ *
+ *  emitter: emitter to be deleted
+ *
+ *  returns: true if everything was written (or matched)
+ *           false otherwise
+ */
+bool emitter_close(emitter_t *emitter)
+{
+    bool ok = emitter_finish(emitter);
+
+    free(emitter->expected);
+    free(emitter->marks);
+    free(emitter);
+    return ok;
+}
@@ -0,0 +1,158 @@
+/*
+ * File: emit.h
+ * ------------
+ *  types, constants and function declarations for emit module
+ *
+ *  emitters turn stream of encoded words into output images, every
+ *  emitter owns its buffer, so single encode pass can feed several of
+ *  them; format is chosen by output suffix:
+ *
+ *      .hack   text, one word of binary digits per line
+ *      .bin    raw words, most significant byte first
+ *      .hex    Intel HEX, byte addressed, 16 data bytes per record
+ *      .mem    Verilog '$readmemb' image, one word of binary digits per line
+ *
+ *  words are 16 bits wide, or 32 bits in extended ROM mode
+ *
+ *  checking emitter reads existing image instead of writing it and stops
+ *  at the first byte that differs, remembering which word produced it
+ */
+
+#ifndef HACK_ASM_EMIT_H
+#define HACK_ASM_EMIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define EMIT_BUFFER_SIZE (64 * 1024)
+#define EMIT_HEX_RECORD_SIZE 16 /* data bytes per Intel HEX record */
+#define EMIT_MARKS_MAX (EMIT_BUFFER_SIZE / 2) /* every word takes 2+ bytes */
+
+typedef struct emitter_t emitter_t;
+
+typedef struct {
+    size_t offset; /* buffer offset of reserved bytes */
+    size_t word;   /* address of the word the bytes belong to */
+} emit_mark_t;
+
+typedef struct {
+    const char *suffix;
+    void (*begin)(emitter_t *emitter);
+    void (*word)(emitter_t *emitter, uint32_t code);
+    void (*end)(emitter_t *emitter);
+} emit_format_t;
+
+struct emitter_t {
+    const emit_format_t *format;
+    FILE *stream;
+    int width;        /* bits per word */
+    char buffer[EMIT_BUFFER_SIZE];
+    size_t used;      /* bytes waiting in buffer */
+    bool ok;          /* false once write failed or image differs */
+    size_t address;   /* byte address of the next word */
+    uint8_t record[EMIT_HEX_RECORD_SIZE]; /* pending Intel HEX data */
+    size_t record_n;
+    size_t segment;   /* upper 16 bits of last Intel HEX address */
+    size_t words;     /* amount of words emitted so far */
+    size_t mark_word; /* word the next reserved bytes belong to */
+    bool finished;
+    /* checking only */
+    char *expected;      /* chunk of existing image (NULL when writing) */
+    emit_mark_t *marks;  /* word of every reservation in the buffer */
+    size_t marks_n;
+    bool mismatched;
+    size_t mismatch;     /* address of the first differing word */
+};
+
+/*
+ * Function: emit_hack_line
+ * ------------------------
+ *  formats 'code' as sequence of 0's and 1's followed by new line
+ *
+ *  line: buffer of at least 'width' + 1 chars (no '\0' is added)
+ *  code: hack command code
+ *  width: bits per word
+ */
+void emit_hack_line(char *line, uint32_t code, int width);
+
+/*
+ * Function: emit_format
+ * ---------------------
+ *  finds output format by suffix of the path
+ *
+ *  path: output path
+ *
+ *  returns: pointer to format
+ *           NULL if suffix names no format
+ */
+const emit_format_t *emit_format(const char *path);
+
+/*
+ * Function: emitter_new
+ * ---------------------
+ *  creates emitter writing given format into the stream
+ *
+ *  stream: writable binary stream (stays open after emitter is closed)
+ *  format: output format
+ *  width: bits per word (16 or 32)
+ *
+ *  returns: pointer to allocated emitter
+ */
+emitter_t *emitter_new(FILE *stream, const emit_format_t *format, int width);
+
+/*
+ * Function: emitter_new_check
+ * ---------------------------
+ *  creates emitter comparing given format with existing image instead of
+ *  writing it
+ *
+ *  stream: readable binary stream of existing image
+ *  format: output format
+ *  width: bits per word (16 or 32)
+ *
+ *  returns: pointer to allocated emitter
+ */
+emitter_t *emitter_new_check(FILE *stream, const emit_format_t *format,
+        int width);
+
+/*
+ * Function: emitter_word
+ * ----------------------
+ *  emits next word of the program
+ *
+ *  emitter: emitter
+ *  code: hack command code
+ *
+ *  returns: false once output can't be written or differs from existing
+ *           image (later words are ignored then)
+ *           true otherwise
+ */
+bool emitter_word(emitter_t *emitter, uint32_t code);
+
+/*
+ * Function: emitter_finish
+ * ------------------------
+ *  finishes the image and flushes buffer into the stream, checking
+ *  emitter also requires existing image to end right there
+ *
+ *  emitter: emitter
+ *
+ *  returns: true if everything was written (or matched)
+ *           false otherwise
+ */
+bool emitter_finish(emitter_t *emitter);
+
+/*
+ * Function: emitter_close
+ * -----------------------
+ *  finishes the image unless it is finished already and destroys emitter
+ *
+ *  emitter: emitter to be deleted
+ *
+ *  returns: true if everything was written (or matched)
+ *           false otherwise
+ */
+bool emitter_close(emitter_t *emitter);
+
+#endif // !HACK_ASM_EMIT_H
@@ -0,0 +1,328 @@
+/*
+ * File: expr.c
+ * ------------
+ *  evaluates integer expressions written as A command operands
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "expr.h"
+
+typedef struct {
+    char *text;            /* copy of the expression, symbols are cut in it */
+    size_t pos;            /* offset of the next token */
+    expr_lookup_t lookup;
+    void *context;
+    expr_status_t status;  /* first failure */
+    size_t error;          /* offset of the first failure */
+} expr_parser_t;
+
+static int64_t parse_or(expr_parser_t *parser);
+
+/*
+ * Function: fail
+ * --------------
+ *  records failure unless the evaluation has already failed
+ *
+ *  parser: parser state
+ *  status: reason of failure
+ *  position: offset of the failing token
+ *
+ *  returns: 0, the value failed subexpressions take
+ */
+static int64_t fail(expr_parser_t *parser, expr_status_t status,
+        size_t position)
+{
+    if (parser->status == EXPR_OK) {
+        parser->status = status;
+        parser->error = position;
+    }
+    return 0;
+}
+
+/*
+ * Function: checked
+ * -----------------
+ *  checks that intermediate value fits into 32 bits, so no operation can
+ *  overflow 64 bit arithmetic
+ *
+ *  parser: parser state
+ *  value: value to check
+ *  position: offset of the operator producing the value
+ *
+ *  returns: the value, or 0 if it doesn't fit
+ */
+static int64_t checked(expr_parser_t *parser, int64_t value, size_t position)
+{
+    if (value < INT32_MIN || value > INT32_MAX) {
+        return fail(parser, EXPR_OVERFLOW, position);
+    }
+    return value;
+}
+
+/*
+ * Function: is_symbol_char
+ * ------------------------
+ *  determines whether the character may be a part of symbol
+ *
+ *  c: character to test
+ *
+ *  returns: true for letters, digits, '_', '.', '$' and ':'
+ *           false otherwise
+ */
+static bool is_symbol_char(char c)
+{
+    return isalnum((unsigned char) c) || c == '_' || c == '.' || c == '$'
+        || c == ':';
+}
+
+/*
+ * Function: parse_primary
+ * -----------------------
+ *  parses number, symbol or parenthesized expression
+ *
+ *  parser: parser state
+ *
+ *  returns: value of the operand
+ */
+static int64_t parse_primary(expr_parser_t *parser)
+{
+    char *text = parser->text;
+    size_t begin = parser->pos;
+    int64_t value = 0;
+    int32_t found;
+    char end;
+
+    if (text[begin] == '(') {
+        parser->pos++;
+        value = parse_or(parser);
+        if (text[parser->pos] != ')') {
+            return fail(parser, EXPR_SYNTAX, parser->pos);
+        }
+        parser->pos++;
+        return value;
+    }
+
+    if (isdigit((unsigned char) text[begin])) {
+        while (isdigit((unsigned char) text[parser->pos])) {
+            value = 10 * value + (text[parser->pos++] - '0');
+            if (value > INT32_MAX) {
+                return fail(parser, EXPR_OVERFLOW, begin);
+            }
+        }
+        /* symbols can't start with a digit */
+        if (is_symbol_char(text[parser->pos])) {
+            return fail(parser, EXPR_SYNTAX, parser->pos);
+        }
+        return value;
+    }
+
+    while (is_symbol_char(text[parser->pos])) {
+        parser->pos++;
+    }
+    if (parser->pos == begin) {
+        return fail(parser, EXPR_SYNTAX, begin);
+    }
+
+    /* cut the symbol out of the text for the lookup */
+    end = text[parser->pos];
+    text[parser->pos] = '\0';
+    found = parser->lookup(text + begin, begin, parser->context);
+    text[parser->pos] = end;
+
+    if (found < 0) {
+        return fail(parser, EXPR_UNDEFINED, begin);
+    }
+    return found;
+}
+
+/*
+ * Function: parse_unary
+ * ---------------------
+ *  parses operand with any amount of unary minuses
+ *
+ *  parser: parser state
+ *
+ *  returns: value of the operand
+ */
+static int64_t parse_unary(expr_parser_t *parser)
+{
+    if (parser->text[parser->pos] == '-') {
+        parser->pos++;
+        return -parse_unary(parser);
+    }
+    return parse_primary(parser);
+}
+
+/*
+ * Function: parse_product
+ * -----------------------
+ *  parses operands joined with '*', '/' and '%'
+ *
+ *  parser: parser state
+ *
+ *  returns: value of the product
+ */
+static int64_t parse_product(expr_parser_t *parser)
+{
+    int64_t value = parse_unary(parser), operand;
+    size_t position;
+    char op;
+
+    while (parser->status == EXPR_OK && strchr("*/%",
+                (op = parser->text[parser->pos])) && op) {
+        position = parser->pos++;
+        operand = parse_unary(parser);
+        if (op == '*') {
+            value = checked(parser, value * operand, position);
+        } else if (operand == 0) {
+            return fail(parser, EXPR_DIVISION, position);
+        } else {
+            /* quotient of INT32_MIN and -1 is the only one not fitting */
+            value = checked(parser,
+                    op == '/' ? value / operand : value % operand, position);
+        }
+    }
+    return value;
+}
+
+/*
+ * Function: parse_sum
+ * -------------------
+ *  parses products joined with binary '+' and '-'
+ *
+ *  parser: parser state
+ *
+ *  returns: value of the sum
+ */
+static int64_t parse_sum(expr_parser_t *parser)
+{
+    int64_t value = parse_product(parser), operand;
+    size_t position;
+    char op;
+
+    while (parser->status == EXPR_OK && ((op = parser->text[parser->pos])
+                == '+' || op == '-')) {
+        position = parser->pos++;
+        operand = parse_product(parser);
+        value = checked(parser, op == '+' ? value + operand
+                : value - operand, position);
+    }
+    return value;
+}
+
+/*
+ * Function: parse_and
+ * -------------------
+ *  parses sums joined with '&'
+ *
+ *  parser: parser state
+ *
+ *  returns: value of the conjunction
+ */
+static int64_t parse_and(expr_parser_t *parser)
+{
+    int64_t value = parse_sum(parser);
+
+    while (parser->status == EXPR_OK && parser->text[parser->pos] == '&') {
+        parser->pos++;
+        value &= parse_sum(parser);
+    }
+    return value;
+}
+
+/*
+ * Function: parse_or
+ * ------------------
+ *  parses conjunctions joined with '|'
+ *
+ *  parser: parser state
+ *
+ *  returns: value of the disjunction
+ */
+static int64_t parse_or(expr_parser_t *parser)
+{
+    int64_t value = parse_and(parser);
+
+    while (parser->status == EXPR_OK && parser->text[parser->pos] == '|') {
+        parser->pos++;
+        value |= parse_and(parser);
+    }
+    return value;
+}
+
+/*
+ * Function: expr_is_expression
+ * ----------------------------
+ *  determines whether A command operand is an expression
+ *
+ *  text: A command operand
+ *
+ *  returns: true if operand has any operator character
+ *           false otherwise
+ */
+bool expr_is_expression(const char *text)
+{
+    return text[strcspn(text, EXPR_OPERATORS)] != '\0';
+}
+
+/*
+ * Function: expr_eval
+ * -------------------
+ *  evaluates expression (whitespace already removed)
+ *
+ *  text: expression
+ *  lookup: lookup of symbol values
+ *  context: context passed to lookup
+ *  value_ptr: value of the expression
+ *  position_ptr: offset of the token the evaluation failed at (length
+ *                of text if it ended too early)
+ *
+ *  returns: EXPR_OK if value is set, reason of failure otherwise
+ */
+expr_status_t expr_eval(const char *text, expr_lookup_t lookup,
+        void *context, int64_t *value_ptr, size_t *position_ptr)
+{
+    expr_parser_t parser = { strdup(text), 0, lookup, context, EXPR_OK, 0 };
+    int64_t value = parse_or(&parser);
+
+    /* whole text has to be consumed */
+    if (parser.text[parser.pos] != '\0') {
+        fail(&parser, EXPR_SYNTAX, parser.pos);
+    }
+    free(parser.text);
+
+    *value_ptr = value;
+    *position_ptr = parser.error;
+    return parser.status;
+}
+
+/*
+ * Function: expr_message
+ * ----------------------
+ *  describes failure of evaluation
+ *
+ *  status: evaluation status
+ *
+ *  returns: static message
+ */
+const char *expr_message(expr_status_t status)
+{
+    switch (status) {
+        case EXPR_OK:
+            break;
+        case EXPR_SYNTAX:
+            return "malformed expression";
+        case EXPR_UNDEFINED:
+            return "symbol is neither label nor predefined";
+        case EXPR_OVERFLOW:
+            return "expression overflows";
+        case EXPR_DIVISION:
+            return "division by zero";
+    }
+    return "no error";
+}
@@ -0,0 +1,82 @@
+/*
+ * File: expr.h
+ * ------------
+ *  types, constants and function declarations for expression module
+ *
+ *  evaluates integer expressions written as A command operands, e.g.
+ *  '@SCREEN+32*5' or '@TABLE+(ROW-1)*8', so address computations are
+ *  folded into a single constant at assembly time
+ *
+ *  operators from the lowest precedence: '|', '&', binary '+' and '-',
+ *  '*', '/' and '%', unary '-'; parentheses group, operands are decimal
+ *  numbers and symbols, all operators are left associative
+ *
+ *  symbols can't contain any operator character, so an operand holding
+ *  one is an expression and anything else is a plain number or symbol
+ */
+
+#ifndef HACK_ASM_EXPR_H
+#define HACK_ASM_EXPR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EXPR_OPERATORS "+-*/%&|()"
+
+typedef enum {
+    EXPR_OK,
+    EXPR_SYNTAX,    /* malformed expression */
+    EXPR_UNDEFINED, /* lookup doesn't know the symbol */
+    EXPR_OVERFLOW,  /* value doesn't fit into 32 bits */
+    EXPR_DIVISION   /* division by zero */
+} expr_status_t;
+
+/*
+ * lookup of symbol value: symbol is terminated copy of the token,
+ * position is its offset in the expression text, -1 means undefined
+ */
+typedef int32_t (*expr_lookup_t)(const char *symbol, size_t position,
+        void *context);
+
+/*
+ * Function: expr_is_expression
+ * ----------------------------
+ *  determines whether A command operand is an expression
+ *
+ *  text: A command operand
+ *
+ *  returns: true if operand has any operator character
+ *           false otherwise
+ */
+bool expr_is_expression(const char *text);
+
+/*
+ * Function: expr_eval
+ * -------------------
+ *  evaluates expression (whitespace already removed)
+ *
+ *  text: expression
+ *  lookup: lookup of symbol values
+ *  context: context passed to lookup
+ *  value_ptr: value of the expression
+ *  position_ptr: offset of the token the evaluation failed at (length
+ *                of text if it ended too early)
+ *
+ *  returns: EXPR_OK if value is set, reason of failure otherwise
+ */
+expr_status_t expr_eval(const char *text, expr_lookup_t lookup,
+        void *context, int64_t *value_ptr, size_t *position_ptr);
+
+/*
+ * Function: expr_message
+ * ----------------------
+ *  describes failure of evaluation
+ *
+ *  status: evaluation status
+ *
+ *  returns: static message
+ */
+const char *expr_message(expr_status_t status);
+
+#endif // !HACK_ASM_EXPR_H
@@ -6,7 +6,14 @@
 
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "helpers.h"
 
 /*
  * Function: str_ends_with
@@ -52,3 +59,125 @@ bool str_isnum(const char *s)
 
     return true;
 }
+
+/*
+ * Function: clock_seconds
+ * -----------------------
+ *  reads monotonic clock
+ *
+ *  returns: current time in seconds
+ */
+double clock_seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Function: join_path
+ * -------------------
+ *  resolves path relative to directory of the file it is written in
+ *
+ *  file: path of the file referencing another one
+ *  path: referenced path
+ *
+ *  returns: allocated resolved path
+ */
+char *join_path(const char *file, const char *path)
+{
+    const char *slash = strrchr(file, '/');
+    size_t dir_len;
+    char *joined;
+
+    if (path[0] == '/' || !slash) {
+        return strdup(path);
+    }
+
+    /* keep directory part including trailing '/' */
+    dir_len = slash - file + 1;
+    joined = malloc(dir_len + strlen(path) + 1);
+    memcpy(joined, file, dir_len);
+    strcpy(joined + dir_len, path);
+    return joined;
+}
+
+/*
+ * Function: staged_path
+ * ---------------------
+ *  names temporary file next to the path, output written there replaces
+ *  the path by rename once it is known to be good
+ *
+ *  path: final output path
+ *
+ *  returns: allocated temporary path
+ */
+char *staged_path(const char *path)
+{
+    size_t len = strlen(path) + STAGED_SUFFIX_MAX;
+    char *staged = malloc(len);
+
+    /* same directory keeps rename atomic, pid keeps parallel runs apart */
+    snprintf(staged, len, "%s.%ld.tmp", path, (long) getpid());
+    return staged;
+}
+
+/*
+ * Function: put_u16
+ * -----------------
+ *  writes 16 bit integer in little endian order
+ */
+void put_u16(FILE *stream, uint16_t v)
+{
+    fputc(v & 0xFF, stream);
+    fputc(v >> 8, stream);
+}
+
+/*
+ * Function: put_u32
+ * -----------------
+ *  writes 32 bit integer in little endian order
+ */
+void put_u32(FILE *stream, uint32_t v)
+{
+    put_u16(stream, v & 0xFFFF);
+    put_u16(stream, v >> 16);
+}
+
+/*
+ * Function: get_u16
+ * -----------------
+ *  reads 16 bit integer in little endian order
+ *
+ *  returns: false on end of stream
+ */
+bool get_u16(FILE *stream, uint16_t *v)
+{
+    int lo = fgetc(stream);
+    int hi = fgetc(stream);
+
+    if (lo == EOF || hi == EOF) {
+        return false;
+    }
+    *v = lo | (hi << 8);
+    return true;
+}
+
+/*
+ * Function: get_u32
+ * -----------------
+ *  reads 32 bit integer in little endian order
+ *
+ *  returns: false on end of stream
+ */
+bool get_u32(FILE *stream, uint32_t *v)
+{
+    uint16_t lo, hi;
+
+    if (!get_u16(stream, &lo) || !get_u16(stream, &hi)) {
+        return false;
+    }
+    *v = lo | ((uint32_t) hi << 16);
+    return true;
+}
@@ -9,6 +9,12 @@
 #ifndef HACK_ASM_HELPERS_H
 #define HACK_ASM_HELPERS_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define STAGED_SUFFIX_MAX 32 /* '.<pid>.tmp' and terminating null */
+
 /*
  * Function: str_ends_with
  * -----------------------
@@ -34,4 +40,69 @@ bool str_ends_with(const char *s, const char *suffix);
  */
 bool str_isnum(const char *s);
 
+/*
+ * Function: clock_seconds
+ * -----------------------
+ *  reads monotonic clock
+ *
+ *  returns: current time in seconds
+ */
+double clock_seconds(void);
+
+/*
+ * Function: join_path
+ * -------------------
+ *  resolves path relative to directory of the file it is written in
+ *
+ *  file: path of the file referencing another one
+ *  path: referenced path
+ *
+ *  returns: allocated resolved path
+ */
+char *join_path(const char *file, const char *path);
+
+/*
+ * Function: staged_path
+ * ---------------------
+ *  names temporary file next to the path, output written there replaces
+ *  the path by rename once it is known to be good
+ *
+ *  path: final output path
+ *
+ *  returns: allocated temporary path
+ */
+char *staged_path(const char *path);
+
+/*
+ * Function: put_u16
+ * -----------------
+ *  writes 16 bit integer in little endian order
+ */
+void put_u16(FILE *stream, uint16_t v);
+
+/*
+ * Function: put_u32
+ * -----------------
+ *  writes 32 bit integer in little endian order
+ */
+void put_u32(FILE *stream, uint32_t v);
+
+/*
+ * Function: get_u16
+ * -----------------
+ *  reads 16 bit integer in little endian order
+ *
+ *  returns: false on end of stream
+ */
+bool get_u16(FILE *stream, uint16_t *v);
+
+/*
+ * Function: get_u32
+ * -----------------
+ *  reads 32 bit integer in little endian order
+ *
+ *  returns: false on end of stream
+ */
+bool get_u32(FILE *stream, uint32_t *v);
+
 #endif // !HACK_ASM_HELPERS_H
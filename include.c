@@ -0,0 +1,391 @@
+/*
+ * File: include.c
+ * ---------------
+ *  parse-once cache of files pulled in with '#include' directive
+ *
+ *  entries are keyed by real path and validated by modification time and
+ *  size, so edited files are lexed again while unchanged shared modules
+ *  are tokenized once no matter how many programs include them
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "helpers.h"
+#include "include.h"
+#include "parser.h"
+
+static include_entry_t **entries = NULL;
+static size_t entries_n = 0;
+static pthread_mutex_t entries_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Function: put_u64
+ * -----------------
+ *  writes 64 bit integer in little endian order
+ */
+static void put_u64(FILE *stream, uint64_t v)
+{
+    put_u32(stream, v & 0xFFFFFFFF);
+    put_u32(stream, v >> 32);
+}
+
+/*
+ * Function: get_u64
+ * -----------------
+ *  reads 64 bit integer in little endian order
+ *
+ *  returns: false on end of stream
+ */
+static bool get_u64(FILE *stream, uint64_t *v)
+{
+    uint32_t lo, hi;
+
+    if (!get_u32(stream, &lo) || !get_u32(stream, &hi)) {
+        return false;
+    }
+    *v = lo | ((uint64_t) hi << 32);
+    return true;
+}
+
+/*
+ * Function: put_field
+ * -------------------
+ *  writes optional command field
+ */
+static void put_field(FILE *stream, const char *field)
+{
+    size_t len;
+
+    if (!field) {
+        put_u16(stream, INCLUDE_NULL_FIELD);
+        return;
+    }
+    len = strlen(field);
+    put_u16(stream, len);
+    fwrite(field, 1, len, stream);
+}
+
+/*
+ * Function: get_field
+ * -------------------
+ *  reads optional command field
+ *
+ *  stream: readable binary stream
+ *  field_ptr: allocated field (NULL for missing one)
+ *
+ *  returns: false if stream ends too early
+ */
+static bool get_field(FILE *stream, char **field_ptr)
+{
+    uint16_t len;
+
+    *field_ptr = NULL;
+    if (!get_u16(stream, &len)) {
+        return false;
+    }
+    if (len == INCLUDE_NULL_FIELD) {
+        return true;
+    }
+
+    *field_ptr = malloc(len + 1);
+    (*field_ptr)[len] = '\0';
+    return fread(*field_ptr, 1, len, stream) == len;
+}
+
+/*
+ * Function: cache_path
+ * --------------------
+ *  names disk cache file of the source by hash of its real path
+ *
+ *  dir: cache directory
+ *  path: real path of the source
+ *
+ *  returns: allocated cache file path
+ */
+static char *cache_path(const char *dir, const char *path)
+{
+    uint64_t h = 14695981039346656037ULL; /* FNV-1a */
+    char *cached;
+    size_t len;
+
+    for (const char *p = path; *p; p++) {
+        h = (h ^ (unsigned char) *p) * 1099511628211ULL;
+    }
+
+    len = strlen(dir) + 1 + 16 + strlen(INCLUDE_CACHE_SUFFIX) + 1;
+    cached = malloc(len);
+    snprintf(cached, len, "%s/%016llx%s", dir, (unsigned long long) h,
+            INCLUDE_CACHE_SUFFIX);
+    return cached;
+}
+
+/*
+ * Function: entry_del
+ * -------------------
+ *  destroys cache entry
+ *
+ *  entry: entry to be deleted
+ */
+static void entry_del(include_entry_t *entry)
+{
+    for (size_t i = 0; i < entry->n; i++) {
+        command_del(entry->commands[i]);
+    }
+    free(entry->commands);
+    free(entry->path);
+    free(entry);
+}
+
+/*
+ * Function: entry_add_command
+ * ---------------------------
+ *  appends lexed command to the entry
+ */
+static void entry_add_command(include_entry_t *entry, asm_command_t *command)
+{
+    /* capacity is implied by n: it is doubled whenever n is a power of 2 */
+    if (entry->n == 0 || (entry->n & (entry->n - 1)) == 0) {
+        entry->commands = realloc(entry->commands,
+                (entry->n ? 2 * entry->n : 1) * sizeof(asm_command_t *));
+    }
+    command->file = entry->path;
+    entry->commands[entry->n++] = command;
+}
+
+/*
+ * Function: lex_file
+ * ------------------
+ *  lexes all commands of the file into the entry
+ *
+ *  entry: entry with path set
+ *
+ *  returns: true if file is read
+ *           false otherwise
+ */
+static bool lex_file(include_entry_t *entry)
+{
+    asm_command_t *command;
+    size_t line = 1;
+    FILE *stream;
+
+    if (!(stream = fopen(entry->path, "r"))) {
+        return false;
+    }
+
+    while ((command = get_command(stream, &line))) {
+        entry_add_command(entry, command);
+    }
+
+    fclose(stream);
+    return true;
+}
+
+/*
+ * Function: load_cached
+ * ---------------------
+ *  reads lexed commands of the file from disk cache
+ *
+ *  cached: cache file path
+ *  entry: entry with path, modification time and size set
+ *
+ *  returns: true if cache holds current version of the file
+ *           false otherwise
+ */
+static bool load_cached(const char *cached, include_entry_t *entry)
+{
+    char magic[sizeof(INCLUDE_CACHE_MAGIC)] = { 0 };
+    char *path = NULL, *fields[4];
+    uint16_t version;
+    uint64_t sec, size;
+    uint32_t nsec, n, line;
+    int type;
+    bool valid;
+    FILE *stream;
+
+    if (!(stream = fopen(cached, "rb"))) {
+        return false;
+    }
+
+    valid = fread(magic, 1, strlen(INCLUDE_CACHE_MAGIC), stream)
+            == strlen(INCLUDE_CACHE_MAGIC)
+        && !strcmp(magic, INCLUDE_CACHE_MAGIC)
+        && get_u16(stream, &version) && version == INCLUDE_CACHE_VERSION
+        && get_u64(stream, &sec) && get_u32(stream, &nsec)
+        && get_u64(stream, &size) && get_field(stream, &path)
+        && path && !strcmp(path, entry->path)
+        && (time_t) sec == entry->mtime.tv_sec
+        && (long) nsec == entry->mtime.tv_nsec && size == entry->size
+        && get_u32(stream, &n);
+    free(path);
+
+    for (uint32_t i = 0; valid && i < n; i++) {
+        type = fgetc(stream);
+        valid = type >= A_COMMAND && type <= I_COMMAND
+            && get_u32(stream, &line);
+
+        for (int j = 0; j < 4; j++) {
+            fields[j] = NULL;
+            valid = valid && get_field(stream, &fields[j]);
+        }
+
+        if (valid) {
+            entry_add_command(entry, command_new_from(type, fields[0],
+                        fields[1], fields[2], fields[3], line));
+        } else {
+            for (int j = 0; j < 4; j++) {
+                free(fields[j]);
+            }
+        }
+    }
+
+    fclose(stream);
+    return valid;
+}
+
+/*
+ * Function: save_cached
+ * ---------------------
+ *  writes lexed commands of the file to disk cache, the file is replaced
+ *  atomically, so concurrent runs never read half written cache
+ *
+ *  cached: cache file path
+ *  entry: lexed entry
+ */
+static void save_cached(const char *cached, const include_entry_t *entry)
+{
+    size_t len = strlen(cached) + 32;
+    char *tmp = malloc(len);
+    asm_command_t *command;
+    FILE *stream;
+
+    snprintf(tmp, len, "%s.%ld.tmp", cached, (long) getpid());
+    if (!(stream = fopen(tmp, "wb"))) {
+        free(tmp);
+        return;
+    }
+
+    fputs(INCLUDE_CACHE_MAGIC, stream);
+    put_u16(stream, INCLUDE_CACHE_VERSION);
+    put_u64(stream, entry->mtime.tv_sec);
+    put_u32(stream, entry->mtime.tv_nsec);
+    put_u64(stream, entry->size);
+    put_field(stream, entry->path);
+    put_u32(stream, entry->n);
+
+    for (size_t i = 0; i < entry->n; i++) {
+        command = entry->commands[i];
+        fputc(command->type, stream);
+        put_u32(stream, command->line);
+        put_field(stream, command->symbol);
+        put_field(stream, command->dest);
+        put_field(stream, command->comp);
+        put_field(stream, command->jump);
+    }
+
+    if (fclose(stream) || rename(tmp, cached)) {
+        unlink(tmp);
+    }
+    free(tmp);
+}
+
+/*
+ * Function: entry_load
+ * --------------------
+ *  creates entry for current version of the file using disk cache when
+ *  it is enabled
+ *
+ *  path: real path of the file
+ *  st: status of the file
+ *
+ *  returns: pointer to allocated entry
+ *           NULL if file can't be read
+ */
+static include_entry_t *entry_load(const char *path, const struct stat *st)
+{
+    include_entry_t *entry = calloc(1, sizeof(include_entry_t));
+    const char *dir = getenv(INCLUDE_CACHE_ENV);
+    char *cached = dir && *dir ? cache_path(dir, path) : NULL;
+
+    entry->path = strdup(path);
+    entry->mtime = st->st_mtim;
+    entry->size = st->st_size;
+
+    if (cached && load_cached(cached, entry)) {
+        free(cached);
+        return entry;
+    }
+
+    /* partially loaded cache is dropped */
+    for (size_t i = 0; i < entry->n; i++) {
+        command_del(entry->commands[i]);
+    }
+    entry->n = 0;
+
+    if (!lex_file(entry)) {
+        entry_del(entry);
+        free(cached);
+        return NULL;
+    }
+
+    if (cached) {
+        save_cached(cached, entry);
+    }
+    free(cached);
+    return entry;
+}
+
+/*
+ * Function: include_lookup
+ * ------------------------
+ *  finds lexed commands of the file, lexing it only if neither process
+ *  nor disk cache holds its current version (thread safe)
+ *
+ *  entry lives until the end of the process and must not be modified
+ *
+ *  path: file path
+ *
+ *  returns: pointer to cache entry
+ *           NULL if file can't be read
+ */
+const include_entry_t *include_lookup(const char *path)
+{
+    char real[PATH_MAX];
+    struct stat st;
+    include_entry_t *entry = NULL;
+
+    if (!realpath(path, real) || stat(real, &st)) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&entries_lock);
+
+    /* newest version of the file is the last one */
+    for (size_t i = entries_n; i-- > 0;) {
+        if (!strcmp(entries[i]->path, real)) {
+            entry = entries[i];
+            break;
+        }
+    }
+
+    /* stale entries are kept alive, commands may still point to them */
+    if (!entry || entry->size != (size_t) st.st_size
+            || entry->mtime.tv_sec != st.st_mtim.tv_sec
+            || entry->mtime.tv_nsec != st.st_mtim.tv_nsec) {
+        if ((entry = entry_load(real, &st))) {
+            entries = realloc(entries,
+                    (entries_n + 1) * sizeof(include_entry_t *));
+            entries[entries_n++] = entry;
+        }
+    }
+
+    pthread_mutex_unlock(&entries_lock);
+    return entry;
+}
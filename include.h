@@ -0,0 +1,58 @@
+/*
+ * File: include.h
+ * ---------------
+ *  types, constants and function declarations for include module
+ *
+ *  parse-once cache of files pulled in with '#include' directive: every
+ *  file is lexed once per process and, if HACK_ASM_CACHE names a
+ *  directory, once per its modification time across runs
+ *
+ *  disk cache layout (all integers little endian):
+ *
+ *      "HLEX" u16 version
+ *      u64 mtime_sec  u32 mtime_nsec  u64 size  u16 path_len  path
+ *      u32 commands_n
+ *      (u8 type  u32 line  field * 4) * commands_n
+ *
+ *  where field is 'u16 len  chars' (len 0xFFFF for missing field)
+ */
+
+#ifndef HACK_ASM_INCLUDE_H
+#define HACK_ASM_INCLUDE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "parser.h"
+
+#define INCLUDE_CACHE_ENV "HACK_ASM_CACHE"
+#define INCLUDE_CACHE_SUFFIX ".lex"
+#define INCLUDE_CACHE_MAGIC "HLEX"
+#define INCLUDE_CACHE_VERSION 1
+#define INCLUDE_NULL_FIELD 0xFFFF
+
+typedef struct {
+    char *path;               /* real path of the file */
+    struct timespec mtime;    /* modification time the commands belong to */
+    size_t size;
+    asm_command_t **commands; /* lexed commands (includes not expanded) */
+    size_t n;
+} include_entry_t;
+
+/*
+ * Function: include_lookup
+ * ------------------------
+ *  finds lexed commands of the file, lexing it only if neither process
+ *  nor disk cache holds its current version (thread safe)
+ *
+ *  entry lives until the end of the process and must not be modified
+ *
+ *  path: file path
+ *
+ *  returns: pointer to cache entry
+ *           NULL if file can't be read
+ */
+const include_entry_t *include_lookup(const char *path);
+
+#endif // !HACK_ASM_INCLUDE_H
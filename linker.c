@@ -0,0 +1,220 @@
+/*
+ * File: linker.c
+ * --------------
+ *  entry point for hack linker program
+ *
+ *  merges relocatable objects written by 'HackAssembler -c' into single
+ *  hack program: objects are placed into ROM one after another, labels get
+ *  final addresses and every external symbol not exported by any object
+ *  becomes a variable allocated from FIRST_FREE_ADDRESS in order of its
+ *  first use, exactly as if all sources were assembled as one file
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler.h"
+#include "helpers.h"
+#include "object.h"
+#include "table.h"
+
+/*
+ * Function: write_help_msg
+ * ------------------------
+ *  writes help message for HackLinker user
+ */
+static void write_help_msg(void)
+{
+    printf("\nUsage: HackLinker -o program object...\n\n"
+           "Link relocatable objects into HACK program.\n\n"
+           "Arguments:\n"
+           "object(required)\tobject file path (must have .obj suffix)\n"
+           "-o program(required)\toutput path (must have .hack suffix)\n\n"
+           "Label may be exported by one object only, as HackAssembler\n"
+           "allows single definition of label per program.\n\n");
+}
+
+/*
+ * Function: read_objects
+ * ----------------------
+ *  reads every object given on command line
+ *
+ *  paths: object file paths
+ *  n: amount of objects
+ *
+ *  returns: list of objects
+ */
+static object_t **read_objects(char **paths, size_t n)
+{
+    object_t **objects = malloc(n * sizeof(object_t *));
+    FILE *stream;
+
+    for (size_t i = 0; i < n; i++) {
+        if (!(stream = fopen(paths[i], "rb"))) {
+            fprintf(stderr, "HackLinker: can't open %s\n", paths[i]);
+            exit(1);
+        }
+        if (!(objects[i] = object_read(stream))) {
+            fprintf(stderr, "HackLinker: %s is not a valid object\n",
+                    paths[i]);
+            exit(1);
+        }
+        fclose(stream);
+    }
+
+    return objects;
+}
+
+/*
+ * Function: place_labels
+ * ----------------------
+ *  gives every exported label its final ROM address
+ *
+ *  objects: list of objects
+ *  paths: object file paths (for diagnostics)
+ *  n: amount of objects
+ *  bases: ROM address of every object
+ *
+ *  returns: table of labels
+ */
+static table_t *place_labels(object_t **objects, char **paths,
+        size_t n, const size_t *bases)
+{
+    table_t *labels = table_new();
+    object_symbol_t *symbol;
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < objects[i]->symbols_n; j++) {
+            symbol = &objects[i]->symbols[j];
+            if (symbol->kind != OBJECT_LABEL) {
+                continue;
+            }
+            if (table_contains(labels, symbol->name)) {
+                fprintf(stderr, "HackLinker: %s: label %s is already "
+                        "defined\n", paths[i], symbol->name);
+                exit(1);
+            }
+            table_add(labels, symbol->name, bases[i] + symbol->value);
+        }
+    }
+
+    return labels;
+}
+
+/*
+ * Function: link_objects
+ * ----------------------
+ *  writes linked program, patching every relocated word
+ *
+ *  stream: writable hack commands stream
+ *  objects: list of objects
+ *  n: amount of objects
+ *  bases: ROM address of every object
+ *  labels: table of placed labels
+ */
+static void link_objects(FILE *stream, object_t **objects, size_t n,
+        const size_t *bases, table_t *labels)
+{
+    table_t *variables = table_new();
+    int32_t address = FIRST_FREE_ADDRESS;
+    object_t *object;
+    object_symbol_t *symbol;
+    size_t r;
+
+    for (size_t i = 0; i < n; i++) {
+        object = objects[i];
+
+        /* relocations are sorted by word, so variables are allocated in
+         * order of first use */
+        for (r = 0; r < object->relocs_n; r++) {
+            symbol = &object->symbols[object->relocs[r].symbol];
+
+            if (symbol->kind == OBJECT_LABEL) {
+                object->words[object->relocs[r].word] =
+                    bases[i] + symbol->value;
+            } else if (table_contains(labels, symbol->name)) {
+                object->words[object->relocs[r].word] =
+                    table_get(labels, symbol->name);
+            } else {
+                if (!table_contains(variables, symbol->name)) {
+                    if (address > HACK_MAX_ADDRESS) {
+                        fprintf(stderr, "HackLinker: variable %s doesn't "
+                                "fit into memory\n", symbol->name);
+                        exit(1);
+                    }
+                    table_add(variables, symbol->name, address++);
+                }
+                object->words[object->relocs[r].word] =
+                    table_get(variables, symbol->name);
+            }
+        }
+
+        for (size_t j = 0; j < object->words_n; j++) {
+            write_hack_command(stream, object->words[j]);
+        }
+    }
+
+    table_del(variables);
+}
+
+int main(int argc, char **argv)
+{
+    char *output = NULL;
+    char **paths;
+    size_t n = 0, *bases;
+    object_t **objects;
+    table_t *labels;
+    FILE *output_stream;
+
+    paths = malloc(argc * sizeof(char *));
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc && !output
+                && str_ends_with(argv[i + 1], OUTPUT_SUFFIX)) {
+            output = argv[++i];
+        } else if (str_ends_with(argv[i], OBJECT_SUFFIX)) {
+            paths[n++] = argv[i];
+        } else {
+            write_help_msg();
+            exit(1);
+        }
+    }
+
+    if (!output || n == 0) {
+        write_help_msg();
+        exit(1);
+    }
+
+    objects = read_objects(paths, n);
+
+    /* objects are laid out in command line order */
+    bases = malloc(n * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        bases[i] = i ? bases[i - 1] + objects[i - 1]->words_n : 0;
+    }
+    if (bases[n - 1] + objects[n - 1]->words_n > HACK_ROM_SIZE) {
+        fprintf(stderr, "HackLinker: program doesn't fit into ROM\n");
+        exit(1);
+    }
+
+    labels = place_labels(objects, paths, n, bases);
+
+    if (!(output_stream = fopen(output, "w"))) {
+        fprintf(stderr, "HackLinker: can't open %s\n", output);
+        exit(1);
+    }
+    link_objects(output_stream, objects, n, bases, labels);
+    fclose(output_stream);
+
+    /* cleanup */
+    for (size_t i = 0; i < n; i++) {
+        object_del(objects[i]);
+    }
+    free(objects);
+    free(bases);
+    free(paths);
+    table_del(labels);
+
+    return 0;
+}
@@ -4,29 +4,211 @@
  *  entry point for hack assembler program
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "assembler.h"
+#include "batch.h"
+#include "decompress.h"
+#include "emit.h"
+#include "helpers.h"
+#include "vm.h"
+
+#define MAIN_MAX_STAGED (ASM_MAX_OUTPUTS + 4) /* -o, default, map, -S, -p */
+
+/* outputs of streamed source, written aside until it is known intact */
+typedef struct {
+    const char *paths[MAIN_MAX_STAGED];
+    char *temps[MAIN_MAX_STAGED];
+    size_t n;
+    bool enabled;
+} staged_t;
+
+/*
+ * Function: stage_output
+ * ----------------------
+ *  names file the output is actually written to
+ *
+ *  staged: staged outputs
+ *  path: output path
+ *
+ *  returns: temporary path if outputs are staged
+ *           path itself otherwise
+ */
+static const char *stage_output(staged_t *staged, const char *path)
+{
+    if (!staged->enabled) {
+        return path;
+    }
+    staged->paths[staged->n] = path;
+    staged->temps[staged->n] = staged_path(path);
+    return staged->temps[staged->n++];
+}
+
+/*
+ * Function: finish_staged
+ * -----------------------
+ *  moves staged outputs over their paths, or removes them if the source
+ *  turned out broken
+ *
+ *  staged: staged outputs
+ *  keep: true if outputs are good
+ *
+ *  returns: false if any output can't be moved
+ */
+static bool finish_staged(staged_t *staged, bool keep)
+{
+    bool ok = true;
+
+    for (size_t i = 0; i < staged->n; i++) {
+        if (keep && rename(staged->temps[i], staged->paths[i])) {
+            fprintf(stderr, "HackAssembler: can't write %s\n",
+                    staged->paths[i]);
+            ok = false;
+        }
+        if (!keep || !ok) {
+            remove(staged->temps[i]);
+        }
+        free(staged->temps[i]);
+    }
+    staged->n = 0;
+    return ok;
+}
 
 int main(int argc, char **argv)
 {
-    char *source, *output;
-    FILE *input_stream, *output_stream;
+    char *source, *output, *map = NULL;
+    FILE *input_stream, *output_stream = NULL;
+    FILE *streams[ASM_MAX_OUTPUTS];
+    const emit_format_t *format;
+    int width;
+    decompress_t *decompressor = NULL;
+    staged_t staged = { .n = 0, .enabled = false };
+    asm_options_t options;
+    bool ok;
 
-    source = parse_args(argc, argv);
-    output = get_output(source);
+    source = parse_args(argc, argv, &options);
+    if (options.syntax_only) {
+        /* checked sources produce no output at all */
+        ok = check_syntax(&options);
+        free(options.sources);
+        free(source);
+        return ok ? 0 : 1;
+    }
+    if (options.sources_n > 1) {
+        ok = batch_assemble(options.sources, options.sources_n, &options);
+        free(options.sources);
+        free(source);
+        return ok ? 0 : 1;
+    }
+    width = options.extended ? HACK_EXTENDED_WORD_SIZE : HACK_WORD_SIZE;
+    output = get_output(source,
+            options.object ? OBJECT_SUFFIX : OUTPUT_SUFFIX);
 
-    input_stream = fopen(source, "r");
-    output_stream = fopen(output, "w");
+    if (decompress_suffix_len(source)) {
+        if (!(decompressor = decompress_open(source))) {
+            fprintf(stderr, "HackAssembler: can't open %s\n", source);
+            exit(1);
+        }
+        /* image updated in place can't be staged, so its source is
+         * inflated completely first */
+        if (options.apply) {
+            decompress_buffer(decompressor);
+        }
+        /* small source is inflated already, broken one writes nothing */
+        if (!decompressor->threaded && !decompressor->ok) {
+            fprintf(stderr, "HackAssembler: %s is corrupted\n", source);
+            exit(1);
+        }
+        staged.enabled = decompressor->threaded;
+        input_stream = decompressor->stream;
+    } else if (vm_is_project(source)) {
+        /* project files are opened by translator itself */
+        input_stream = NULL;
+    } else {
+        input_stream = fopen(source, "r");
+    }
+    /* checked output is never opened for writing */
+    if (options.check && options.outputs_n == 0) {
+        options.outputs[options.outputs_n++] = output;
+    }
+    if (options.symbols_out) {
+        options.symbols_out = stage_output(&staged, options.symbols_out);
+    }
+    if (options.patch) {
+        options.patch = stage_output(&staged, options.patch);
+    }
 
-    assemble(input_stream, output_stream);
+    if (options.patch || options.apply) {
+        /* previous build is only read, or updated in place */
+        options.patch_base = options.outputs_n > 0
+            ? options.outputs[0] : output;
+        options.outputs_n = 0;
+    } else if (options.outputs_n > 0) {
+        /* explicit outputs replace the default one */
+        for (size_t i = 0; i < options.outputs_n; i++) {
+            streams[i] = options.check
+                ? fopen(options.outputs[i], "rb")
+                : fopen(stage_output(&staged, options.outputs[i]), "wb");
+            if (!streams[i]) {
+                fprintf(stderr, "HackAssembler: can't open %s\n",
+                        options.outputs[i]);
+                finish_staged(&staged, false);
+                exit(1);
+            }
+            format = emit_format(options.outputs[i]);
+            options.emitters[i] = options.check
+                ? emitter_new_check(streams[i], format, width)
+                : emitter_new(streams[i], format, width);
+        }
+    } else {
+        /* mapping output for writing needs read access as well */
+        output_stream = fopen(stage_output(&staged, output),
+                options.object ? "wb" : options.mapped ? "w+" : "w");
+    }
+
+    if (options.source_map) {
+        map = get_output(source, MAP_SUFFIX);
+        options.map_stream = fopen(stage_output(&staged, map), "w");
+    }
+
+    ok = assemble(input_stream, output_stream, &options);
 
     /* cleanup */
-    free(source);
+    if (decompressor) {
+        if (!decompress_close(decompressor)) {
+            fprintf(stderr, "HackAssembler: %s is corrupted\n", source);
+            ok = false;
+        }
+    } else if (input_stream) {
+        fclose(input_stream);
+    }
+    for (size_t i = 0; i < options.outputs_n; i++) {
+        /* check_outputs has reported differing outputs already */
+        if (!emitter_close(options.emitters[i]) || fclose(streams[i])) {
+            if (!options.check) {
+                fprintf(stderr, "HackAssembler: can't write %s\n",
+                        options.outputs[i]);
+            }
+            ok = false;
+        }
+    }
+    if (output_stream && fclose(output_stream)) {
+        fprintf(stderr, "HackAssembler: can't write %s\n", output);
+        ok = false;
+    }
+    if (options.map_stream) {
+        fclose(options.map_stream);
+    }
+    /* outputs of broken streamed source never replace previous ones */
+    if (!finish_staged(&staged, ok)) {
+        ok = false;
+    }
+    free(map);
     free(output);
-    fclose(input_stream);
-    fclose(output_stream);
+    free(options.sources);
+    free(source);
 
-    return 0;
+    return ok ? 0 : 1;
 }
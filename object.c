@@ -0,0 +1,232 @@
+/*
+ * File: object.c
+ * --------------
+ *  relocatable object holding encoded words of separately assembled source
+ *  together with its symbols and relocations of A command operands
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helpers.h"
+#include "object.h"
+
+/*
+ * Function: grow
+ * --------------
+ *  makes room for one more item of a list growing by doubling
+ *
+ *  items: list (can be NULL)
+ *  n: amount of items in the list
+ *  size: size of one item
+ *
+ *  returns: list able to hold n + 1 items
+ */
+static void *grow(void *items, size_t n, size_t size)
+{
+    /* capacity is implied by n: it is doubled whenever n is a power of 2 */
+    if (n == 0 || (n & (n - 1)) == 0) {
+        items = realloc(items, (n ? 2 * n : 1) * size);
+    }
+    return items;
+}
+
+/*
+ * Function: object_new
+ * --------------------
+ *  creates new empty object
+ *
+ *  returns: pointer to allocated object
+ */
+object_t *object_new(void)
+{
+    return calloc(1, sizeof(object_t));
+}
+
+/*
+ * Function: object_del
+ * --------------------
+ *  destroys object
+ *
+ *  object: object to be deleted
+ */
+void object_del(object_t *object)
+{
+    for (size_t i = 0; i < object->symbols_n; i++) {
+        free(object->symbols[i].name);
+    }
+
+    free(object->words);
+    free(object->symbols);
+    free(object->relocs);
+    free(object);
+}
+
+/*
+ * Function: object_add_word
+ * -------------------------
+ *  appends encoded word to the object
+ *
+ *  object: object to write to
+ *  word: encoded hack command
+ *
+ *  returns: index of added word
+ */
+size_t object_add_word(object_t *object, uint16_t word)
+{
+    object->words = grow(object->words, object->words_n, sizeof(uint16_t));
+    object->words[object->words_n] = word;
+    return object->words_n++;
+}
+
+/*
+ * Function: object_add_symbol
+ * ---------------------------
+ *  appends new symbol (assumes object doesn't have it yet)
+ *
+ *  object: object to write to
+ *  name: symbol name
+ *  kind: symbol kind
+ *  value: object relative address (for labels)
+ *
+ *  returns: index of the symbol
+ */
+size_t object_add_symbol(object_t *object, const char *name,
+        object_symbol_kind_t kind, uint16_t value)
+{
+    object_symbol_t *symbol;
+
+    object->symbols = grow(object->symbols, object->symbols_n,
+            sizeof(object_symbol_t));
+    symbol = &object->symbols[object->symbols_n];
+    symbol->name = strdup(name);
+    symbol->kind = kind;
+    symbol->value = value;
+    return object->symbols_n++;
+}
+
+/*
+ * Function: object_add_reloc
+ * --------------------------
+ *  appends relocation of the word
+ *
+ *  object: object to write to
+ *  word: index of A command word
+ *  symbol: index of symbol providing the value
+ */
+void object_add_reloc(object_t *object, size_t word, size_t symbol)
+{
+    object->relocs = grow(object->relocs, object->relocs_n,
+            sizeof(object_reloc_t));
+    object->relocs[object->relocs_n].word = word;
+    object->relocs[object->relocs_n].symbol = symbol;
+    object->relocs_n++;
+}
+
+/*
+ * Function: object_write
+ * ----------------------
+ *  writes object in binary layout
+ *
+ *  stream: writable binary stream
+ *  object: object to write
+ */
+void object_write(FILE *stream, const object_t *object)
+{
+    size_t i, len;
+
+    fputs(OBJECT_MAGIC, stream);
+    put_u16(stream, OBJECT_VERSION);
+    put_u32(stream, object->words_n);
+    put_u32(stream, object->symbols_n);
+    put_u32(stream, object->relocs_n);
+
+    for (i = 0; i < object->words_n; i++) {
+        put_u16(stream, object->words[i]);
+    }
+
+    for (i = 0; i < object->symbols_n; i++) {
+        len = strlen(object->symbols[i].name);
+        fputc(object->symbols[i].kind, stream);
+        put_u16(stream, object->symbols[i].value);
+        put_u16(stream, len);
+        fwrite(object->symbols[i].name, 1, len, stream);
+    }
+
+    for (i = 0; i < object->relocs_n; i++) {
+        put_u32(stream, object->relocs[i].word);
+        put_u32(stream, object->relocs[i].symbol);
+    }
+}
+
+/*
+ * Function: object_read
+ * ---------------------
+ *  reads object in binary layout
+ *
+ *  stream: readable binary stream
+ *
+ *  returns: pointer to allocated object
+ *           NULL if stream doesn't hold valid object
+ */
+object_t *object_read(FILE *stream)
+{
+    char magic[sizeof(OBJECT_MAGIC)] = { 0 };
+    uint16_t version, word, value, len;
+    uint32_t words_n, symbols_n, relocs_n, at, symbol;
+    int kind;
+    char *name;
+    object_t *object;
+    bool valid;
+
+    if (fread(magic, 1, strlen(OBJECT_MAGIC), stream) != strlen(OBJECT_MAGIC)
+            || strcmp(magic, OBJECT_MAGIC)
+            || !get_u16(stream, &version) || version != OBJECT_VERSION
+            || !get_u32(stream, &words_n) || !get_u32(stream, &symbols_n)
+            || !get_u32(stream, &relocs_n)) {
+        return NULL;
+    }
+
+    object = object_new();
+    valid = true;
+
+    for (uint32_t i = 0; valid && i < words_n; i++) {
+        if ((valid = get_u16(stream, &word))) {
+            object_add_word(object, word);
+        }
+    }
+
+    for (uint32_t i = 0; valid && i < symbols_n; i++) {
+        kind = fgetc(stream);
+        valid = (kind == OBJECT_LABEL || kind == OBJECT_EXTERN)
+            && get_u16(stream, &value) && get_u16(stream, &len);
+        if (!valid) {
+            break;
+        }
+
+        name = malloc(len + 1);
+        valid = fread(name, 1, len, stream) == len;
+        name[len] = '\0';
+        if (valid) {
+            object_add_symbol(object, name, kind, value);
+        }
+        free(name);
+    }
+
+    for (uint32_t i = 0; valid && i < relocs_n; i++) {
+        valid = get_u32(stream, &at) && get_u32(stream, &symbol)
+            && at < words_n && symbol < symbols_n;
+        if (valid) {
+            object_add_reloc(object, at, symbol);
+        }
+    }
+
+    if (!valid) {
+        object_del(object);
+        return NULL;
+    }
+    return object;
+}
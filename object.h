@@ -0,0 +1,131 @@
+/*
+ * File: object.h
+ * --------------
+ *  types, constants and function declarations for object module
+ *
+ *  relocatable object holding encoded words of separately assembled source
+ *  together with its symbols and relocations of A command operands
+ *
+ *  binary layout (all integers little endian):
+ *
+ *      "HOBJ" u16 version
+ *      u32 words_n  u32 symbols_n  u32 relocs_n
+ *      u16 word * words_n
+ *      (u8 kind  u16 value  u16 name_len  name) * symbols_n
+ *      (u32 word  u32 symbol) * relocs_n
+ */
+
+#ifndef HACK_ASM_OBJECT_H
+#define HACK_ASM_OBJECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define OBJECT_MAGIC "HOBJ"
+#define OBJECT_VERSION 1
+
+typedef enum {
+    OBJECT_LABEL, /* label defined (and exported) by the object */
+    OBJECT_EXTERN /* label of another object or variable */
+} object_symbol_kind_t;
+
+typedef struct {
+    char *name;
+    object_symbol_kind_t kind;
+    uint16_t value; /* object relative ROM address of label */
+} object_symbol_t;
+
+typedef struct {
+    uint32_t word;   /* index of A command word to patch */
+    uint32_t symbol; /* index of symbol providing the value */
+} object_reloc_t;
+
+typedef struct {
+    uint16_t *words;
+    size_t words_n;
+    object_symbol_t *symbols;
+    size_t symbols_n;
+    object_reloc_t *relocs;
+    size_t relocs_n;
+} object_t;
+
+/*
+ * Function: object_new
+ * --------------------
+ *  creates new empty object
+ *
+ *  returns: pointer to allocated object
+ */
+object_t *object_new(void);
+
+/*
+ * Function: object_del
+ * --------------------
+ *  destroys object
+ *
+ *  object: object to be deleted
+ */
+void object_del(object_t *object);
+
+/*
+ * Function: object_add_word
+ * -------------------------
+ *  appends encoded word to the object
+ *
+ *  object: object to write to
+ *  word: encoded hack command
+ *
+ *  returns: index of added word
+ */
+size_t object_add_word(object_t *object, uint16_t word);
+
+/*
+ * Function: object_add_symbol
+ * ---------------------------
+ *  appends new symbol (assumes object doesn't have it yet)
+ *
+ *  object: object to write to
+ *  name: symbol name
+ *  kind: symbol kind
+ *  value: object relative address (for labels)
+ *
+ *  returns: index of the symbol
+ */
+size_t object_add_symbol(object_t *object, const char *name,
+        object_symbol_kind_t kind, uint16_t value);
+
+/*
+ * Function: object_add_reloc
+ * --------------------------
+ *  appends relocation of the word
+ *
+ *  object: object to write to
+ *  word: index of A command word
+ *  symbol: index of symbol providing the value
+ */
+void object_add_reloc(object_t *object, size_t word, size_t symbol);
+
+/*
+ * Function: object_write
+ * ----------------------
+ *  writes object in binary layout
+ *
+ *  stream: writable binary stream
+ *  object: object to write
+ */
+void object_write(FILE *stream, const object_t *object);
+
+/*
+ * Function: object_read
+ * ---------------------
+ *  reads object in binary layout
+ *
+ *  stream: readable binary stream
+ *
+ *  returns: pointer to allocated object
+ *           NULL if stream doesn't hold valid object
+ */
+object_t *object_read(FILE *stream);
+
+#endif // !HACK_ASM_OBJECT_H
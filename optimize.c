@@ -0,0 +1,918 @@
+/*
+ * File: optimize.c
+ * ----------------
+ *  rewrites parsed assembler commands into shorter equivalent sequences
+ *
+ *  all rules only look at straight line code: value of a register is
+ *  followed forward along the fall through path and considered live as
+ *  soon as it may be observed (read, jump or end of program for RAM)
+ *
+ *  layout pass works on chains: runs of basic blocks glued together by
+ *  fall through and closed by unconditional jump, so moving whole chains
+ *  never needs new jumps
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ctable.h"
+#include "helpers.h"
+#include "optimize.h"
+#include "parser.h"
+#include "table.h"
+
+typedef enum {
+    REG_A,
+    REG_D,
+    REG_M
+} reg_t;
+
+typedef struct {
+    size_t begin;  /* first command of the chain */
+    size_t end;    /* command after the chain */
+    bool jumps;    /* closed by '@L' and unconditional jump without dest */
+    bool placed;
+} layout_chain_t;
+
+/* comps reading A which have constant counterpart for A = 0 and A = 1 */
+static const char *fold_table[][3] = {
+    /* comp     A = 0   A = 1 */
+    { "A",      "0",    "1"   },
+    { "!A",     "-1",   NULL  },
+    { "-A",     "0",    "-1"  },
+    { "A+1",    "1",    NULL  },
+    { "A-1",    "-1",   "0"   },
+    { "D+A",    "D",    "D+1" },
+    { "D-A",    "D",    "D-1" },
+    { "A-D",    "-D",   NULL  },
+    { "D&A",    "0",    NULL  },
+    { "D|A",    "D",    NULL  },
+};
+
+/*
+ * Function: reg_name
+ * ------------------
+ *  maps register to its mnemonic letter
+ *
+ *  reg: register
+ *
+ *  returns: 'A', 'D' or 'M'
+ */
+static char reg_name(reg_t reg)
+{
+    return "ADM"[reg];
+}
+
+/*
+ * Function: reads_reg
+ * -------------------
+ *  checks whether C command observes the register
+ *
+ *  M is read through A, so any M access or jump (target is A) reads A
+ *
+ *  command: C command
+ *  reg: register
+ *
+ *  returns: true if command reads register
+ *           false otherwise
+ */
+static bool reads_reg(asm_command_t *command, reg_t reg)
+{
+    if (strchr(command->comp, reg_name(reg))) {
+        return true;
+    }
+    if (reg == REG_A) {
+        return strchr(command->comp, 'M') || command->jump
+            || (command->dest && strchr(command->dest, 'M'));
+    }
+    return false;
+}
+
+/*
+ * Function: writes_reg
+ * --------------------
+ *  checks whether C command stores to the register
+ *
+ *  command: C command
+ *  reg: register
+ *
+ *  returns: true if register is in 'dest' part
+ *           false otherwise
+ */
+static bool writes_reg(asm_command_t *command, reg_t reg)
+{
+    return command->dest && strchr(command->dest, reg_name(reg));
+}
+
+/*
+ * Function: is_live
+ * -----------------
+ *  checks whether register value may be observed after given position
+ *
+ *  commands: list of commands (removed ones are NULL)
+ *  n: amount of commands
+ *  from: first command executed after the value is produced
+ *  reg: register holding the value
+ *
+ *  returns: true if value may be read
+ *           false if it is surely overwritten first
+ */
+static bool is_live(asm_command_t **commands, size_t n, size_t from, reg_t reg)
+{
+    asm_command_t *command;
+
+    for (size_t i = from; i < n; i++) {
+        if (!(command = commands[i]) || command->type == L_COMMAND) {
+            /* other paths joining at label don't affect this one */
+            continue;
+        }
+
+        if (command->type == A_COMMAND) {
+            if (reg == REG_A) {
+                return false;
+            }
+            if (reg == REG_M) {
+                return true; /* different cell from now on */
+            }
+            continue;
+        }
+
+        if (reads_reg(command, reg) || command->jump) {
+            return true;
+        }
+        if (writes_reg(command, reg)) {
+            return false;
+        }
+        if (reg == REG_M && writes_reg(command, REG_A)) {
+            return true;
+        }
+    }
+
+    /* registers die with the program, RAM is its result */
+    return reg == REG_M;
+}
+
+/*
+ * Function: next_command
+ * ----------------------
+ *  finds next command that was not removed
+ *
+ *  commands: list of commands (removed ones are NULL)
+ *  n: amount of commands
+ *  i: current position
+ *
+ *  returns: index of next command
+ *           n if there is none
+ */
+static size_t next_command(asm_command_t **commands, size_t n, size_t i)
+{
+    for (i++; i < n && !commands[i]; i++) {
+    }
+    return i;
+}
+
+/*
+ * Function: remove_command
+ * ------------------------
+ *  frees command and marks its slot as removed
+ *
+ *  commands: list of commands
+ *  i: position of command to remove
+ */
+static void remove_command(asm_command_t **commands, size_t i)
+{
+    command_del(commands[i]);
+    commands[i] = NULL;
+}
+
+/*
+ * Function: constant_value
+ * ------------------------
+ *  resolves A command symbol known before labels are placed
+ *
+ *  symbol: symbol of A command
+ *  builtins: table of predefined symbols
+ *  value_ptr: resolved value
+ *
+ *  returns: true if symbol is numeric or predefined
+ *           false otherwise (label or variable)
+ */
+static bool constant_value(const char *symbol, table_t *builtins,
+        long *value_ptr)
+{
+    if (str_isnum(symbol)) {
+        *value_ptr = atol(symbol);
+        return true;
+    }
+    if (table_contains(builtins, symbol)) {
+        *value_ptr = table_get(builtins, symbol);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Function: same_address
+ * ----------------------
+ *  checks whether two A command symbols surely load the same value
+ *
+ *  s: first symbol
+ *  t: second symbol
+ *  builtins: table of predefined symbols
+ *
+ *  returns: true if both load the same value
+ *           false otherwise
+ */
+static bool same_address(const char *s, const char *t, table_t *builtins)
+{
+    long u, v;
+
+    if (!strcmp(s, t)) {
+        return true;
+    }
+    return constant_value(s, builtins, &u)
+        && constant_value(t, builtins, &v) && u == v;
+}
+
+/*
+ * Function: drop_repeated_loads
+ * -----------------------------
+ *  removes '@X' while A already holds X
+ *
+ *  commands: list of commands (removed ones are NULL)
+ *  n: amount of commands
+ *  i: position of A command
+ *  builtins: table of predefined symbols
+ *
+ *  returns: true if anything was removed
+ *           false otherwise
+ */
+static bool drop_repeated_loads(asm_command_t **commands, size_t n,
+        size_t i, table_t *builtins)
+{
+    asm_command_t *command;
+    bool changed = false;
+
+    for (size_t j = next_command(commands, n, i); j < n;
+            j = next_command(commands, n, j)) {
+        command = commands[j];
+
+        if (command->type == L_COMMAND) {
+            break; /* jump may land here with any A */
+        }
+        if (command->type == C_COMMAND) {
+            if (writes_reg(command, REG_A)) {
+                break;
+            }
+            continue;
+        }
+        if (!same_address(commands[i]->symbol, command->symbol, builtins)) {
+            break;
+        }
+
+        remove_command(commands, j);
+        changed = true;
+    }
+
+    return changed;
+}
+
+/*
+ * Function: fold_constant_load
+ * ----------------------------
+ *  turns '@0'/'@1' followed by C command reading A into constant comp,
+ *  e.g. '@1 D=D+A' becomes 'D=D+1'
+ *
+ *  commands: list of commands (removed ones are NULL)
+ *  n: amount of commands
+ *  i: position of A command
+ *  builtins: table of predefined symbols
+ *
+ *  returns: true if A command was folded
+ *           false otherwise
+ */
+static bool fold_constant_load(asm_command_t **commands, size_t n,
+        size_t i, table_t *builtins)
+{
+    size_t j = next_command(commands, n, i);
+    size_t rules_n = sizeof(fold_table) / sizeof(fold_table[0]);
+    asm_command_t *command;
+    long value;
+
+    if (j == n || !constant_value(commands[i]->symbol, builtins, &value)
+            || (value != 0 && value != 1)) {
+        return false;
+    }
+
+    /* C command must not be shared with other paths or observe A itself */
+    command = commands[j];
+    if (command->type != C_COMMAND || command->jump
+            || writes_reg(command, REG_M)
+            || is_live(commands, n, j + 1, REG_A)) {
+        return false;
+    }
+
+    for (size_t k = 0; k < rules_n; k++) {
+        if (!strcmp(command->comp, fold_table[k][0])
+                && fold_table[k][1 + value]) {
+            free(command->comp);
+            command->comp = strdup(fold_table[k][1 + value]);
+            command->code = COMMAND_NOT_ENCODED;
+            remove_command(commands, i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Function: drop_jump_to_next
+ * ---------------------------
+ *  removes '@L' and jump without 'dest' when '(L)' follows the jump
+ *
+ *  commands: list of commands (removed ones are NULL)
+ *  n: amount of commands
+ *  i: position of A command
+ *
+ *  returns: true if jump was removed
+ *           false otherwise
+ */
+static bool drop_jump_to_next(asm_command_t **commands, size_t n, size_t i)
+{
+    size_t j = next_command(commands, n, i);
+    size_t k;
+    asm_command_t *command;
+
+    if (j == n) {
+        return false;
+    }
+
+    command = commands[j];
+    if (command->type != C_COMMAND || !command->jump || command->dest
+            || is_live(commands, n, j + 1, REG_A)) {
+        return false;
+    }
+
+    for (k = next_command(commands, n, j);
+            k < n && commands[k]->type == L_COMMAND;
+            k = next_command(commands, n, k)) {
+        if (!strcmp(commands[k]->symbol, commands[i]->symbol)) {
+            remove_command(commands, j);
+            remove_command(commands, i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Function: drop_dead_stores
+ * --------------------------
+ *  removes 'dest' registers of C command which are overwritten before
+ *  being read, and the whole command if nothing is left
+ *
+ *  commands: list of commands (removed ones are NULL)
+ *  n: amount of commands
+ *  i: position of C command
+ *
+ *  returns: true if anything was removed
+ *           false otherwise
+ */
+static bool drop_dead_stores(asm_command_t **commands, size_t n, size_t i)
+{
+    asm_command_t *command = commands[i];
+    char dest[4];
+    size_t len = 0;
+
+    /* value of jumping command also flows to jump target */
+    if (command->jump || !command->dest) {
+        return false;
+    }
+
+    /* M store of command writing A goes to the old address, while later
+       M accesses see the new one, so it is never known to be dead */
+    for (reg_t reg = REG_A; reg <= REG_M; reg++) {
+        if (writes_reg(command, reg) && (is_live(commands, n, i + 1, reg)
+                    || (reg == REG_M && writes_reg(command, REG_A)))) {
+            dest[len++] = reg_name(reg);
+        }
+    }
+    dest[len] = '\0';
+
+    if (len == strlen(command->dest)) {
+        return false;
+    }
+
+    if (len == 0) {
+        remove_command(commands, i);
+    } else {
+        free(command->dest);
+        command->dest = strdup(dest);
+        command->code = COMMAND_NOT_ENCODED;
+    }
+    return true;
+}
+
+/*
+ * Function: optimize_peephole
+ * ---------------------------
+ *  removes redundant commands until no rule applies:
+ *   - repeated load of the address already held in A
+ *   - '@0'/'@1' folded into following command as constant comp
+ *   - jump to the very next command
+ *   - stores to A, D or M overwritten before being read
+ *   - loads to A overwritten before being read
+ *
+ *  removed commands are freed; labels are kept, so their addresses have to
+ *  be resolved again afterwards
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n: amount of commands
+ *  builtins: table of predefined symbols
+ *
+ *  returns: amount of commands left
+ */
+size_t optimize_peephole(asm_command_t **commands, size_t n, table_t *builtins)
+{
+    bool changed = true;
+    size_t i, m;
+
+    while (changed) {
+        changed = false;
+
+        for (i = 0; i < n; i++) {
+            if (!commands[i]) {
+                continue;
+            }
+
+            switch (commands[i]->type) {
+                case A_COMMAND:
+                    if (!is_live(commands, n, i + 1, REG_A)) {
+                        remove_command(commands, i);
+                        changed = true;
+                    } else {
+                        changed |= drop_repeated_loads(commands, n, i, builtins)
+                            || drop_jump_to_next(commands, n, i)
+                            || fold_constant_load(commands, n, i, builtins);
+                    }
+                    break;
+                case C_COMMAND:
+                    changed |= drop_dead_stores(commands, n, i);
+                    break;
+                case L_COMMAND:
+                case I_COMMAND:
+                    break;
+            }
+        }
+    }
+
+    /* squeeze out removed slots */
+    for (i = 0, m = 0; i < n; i++) {
+        if (commands[i]) {
+            commands[m++] = commands[i];
+        }
+    }
+
+    return m;
+}
+
+/*
+ * Function: is_unconditional
+ * --------------------------
+ *  checks whether command always jumps
+ *
+ *  command: any command
+ *
+ *  returns: true if command is C command with 'JMP'
+ *           false otherwise
+ */
+static bool is_unconditional(const asm_command_t *command)
+{
+    return command->type == C_COMMAND && command->jump
+        && !strcmp(command->jump, "JMP");
+}
+
+/*
+ * Function: collect_labels
+ * ------------------------
+ *  maps every label to position of its definition, labels defined more
+ *  than once are mapped to LAYOUT_AMBIGUOUS and never touched
+ *
+ *  commands: list of commands
+ *  n: amount of commands
+ *
+ *  returns: table of labels
+ */
+static ctable_t *collect_labels(asm_command_t **commands, size_t n)
+{
+    ctable_t *labels = ctable_new(n / LAYOUT_COMMANDS_PER_LABEL);
+
+    for (size_t i = 0; i < n; i++) {
+        if (commands[i]->type != L_COMMAND) {
+            continue;
+        }
+        if (ctable_get(labels, commands[i]->symbol) != -1) {
+            ctable_put(labels, commands[i]->symbol, LAYOUT_AMBIGUOUS,
+                    CTABLE_REPLACE);
+        } else {
+            ctable_put(labels, commands[i]->symbol, i, CTABLE_KEEP);
+        }
+    }
+
+    return labels;
+}
+
+/*
+ * Function: trampoline_target
+ * ---------------------------
+ *  finds where jump to the label ends up when the label only leads to
+ *  another unconditional jump ('(L) @M 0;JMP')
+ *
+ *  commands: list of commands
+ *  n: amount of commands
+ *  labels: table of labels
+ *  symbol: jump target
+ *
+ *  returns: symbol of the final target (equal to the given one if label
+ *           isn't trampoline or jumps form a cycle)
+ */
+static const char *trampoline_target(asm_command_t **commands, size_t n,
+        ctable_t *labels, const char *symbol)
+{
+    const char *target = symbol;
+    int32_t i;
+
+    /* each step follows distinct label, so longer walk is a cycle */
+    for (size_t steps = 0; steps <= labels->size; steps++) {
+        if ((i = ctable_get(labels, target)) < 0) {
+            return target;
+        }
+        while ((size_t) i < n && commands[i]->type == L_COMMAND) {
+            i++;
+        }
+        if ((size_t) i + 1 >= n || commands[i]->type != A_COMMAND
+                || !is_unconditional(commands[i + 1])
+                || commands[i + 1]->dest) {
+            return target;
+        }
+        target = commands[i]->symbol;
+    }
+
+    return symbol;
+}
+
+/*
+ * Function: thread_jumps
+ * ----------------------
+ *  retargets jumps landing on unconditional jumps to the final target;
+ *  taken jump arrives there with the same registers, so jump is skipped
+ *  only if its comp doesn't depend on A (M is read through it) and A
+ *  isn't observed when conditional jump falls through
+ *
+ *  commands: list of commands
+ *  n: amount of commands
+ *  labels: table of labels
+ *
+ *  returns: amount of retargeted jumps
+ */
+static size_t thread_jumps(asm_command_t **commands, size_t n,
+        ctable_t *labels)
+{
+    asm_command_t *jump;
+    const char *target;
+    size_t threaded = 0;
+
+    for (size_t i = 0; i + 1 < n; i++) {
+        jump = commands[i + 1];
+        if (commands[i]->type != A_COMMAND || jump->type != C_COMMAND
+                || !jump->jump || strchr(jump->comp, 'A')
+                || strchr(jump->comp, 'M')
+                || (jump->dest && strchr(jump->dest, 'M'))) {
+            continue;
+        }
+        if (!is_unconditional(jump) && !writes_reg(jump, REG_A)
+                && is_live(commands, n, i + 2, REG_A)) {
+            continue;
+        }
+
+        target = trampoline_target(commands, n, labels, commands[i]->symbol);
+        if (target != commands[i]->symbol) {
+            free(commands[i]->symbol);
+            commands[i]->symbol = strdup(target);
+            threaded++;
+        }
+    }
+
+    return threaded;
+}
+
+/*
+ * Function: reads_a_first
+ * -----------------------
+ *  checks whether the chain observes A before storing to it
+ *
+ *  commands: list of commands
+ *  chain: chain closed by unconditional jump
+ *
+ *  returns: true if value of A at the chain start may be read
+ *           false otherwise
+ */
+static bool reads_a_first(asm_command_t **commands,
+        const layout_chain_t *chain)
+{
+    for (size_t i = chain->begin; i < chain->end; i++) {
+        if (commands[i]->type == A_COMMAND) {
+            return false;
+        }
+        if (commands[i]->type == C_COMMAND) {
+            if (reads_reg(commands[i], REG_A)) {
+                return true;
+            }
+            if (writes_reg(commands[i], REG_A)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Function: fixed_addresses
+ * -------------------------
+ *  checks whether some jump goes to fixed ROM address: number (other than
+ *  0) or symbol which isn't label, i.e. predefined symbol or variable, or
+ *  label defined more than once (the last definition wins, which depends
+ *  on order), code can't be moved then as the address would land elsewhere
+ *
+ *  commands: list of commands
+ *  n: amount of commands
+ *  labels: table of labels
+ *  builtins: table of predefined symbols
+ *
+ *  returns: true if there is such jump or label
+ *           false otherwise
+ */
+static bool fixed_addresses(asm_command_t **commands, size_t n,
+        ctable_t *labels, table_t *builtins)
+{
+    long value;
+
+    for (size_t i = 0; i < n; i++) {
+        if (commands[i]->type == L_COMMAND && ctable_get(labels,
+                    commands[i]->symbol) == LAYOUT_AMBIGUOUS) {
+            return true;
+        }
+        if (commands[i]->type != A_COMMAND || i + 1 == n
+                || commands[i + 1]->type != C_COMMAND
+                || !commands[i + 1]->jump
+                || ctable_get(labels, commands[i]->symbol) >= 0) {
+            continue;
+        }
+        if (!constant_value(commands[i]->symbol, builtins, &value)
+                || value != 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Function: split_chains
+ * ----------------------
+ *  splits program after every unconditional jump
+ *
+ *  commands: list of commands
+ *  n: amount of commands (at least one)
+ *  chains_n_ptr: amount of chains
+ *
+ *  returns: list of chains
+ */
+static layout_chain_t *split_chains(asm_command_t **commands, size_t n,
+        size_t *chains_n_ptr)
+{
+    layout_chain_t *chains = malloc(n * sizeof(layout_chain_t));
+    size_t chains_n = 0, begin = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (!is_unconditional(commands[i]) && i + 1 < n) {
+            continue;
+        }
+        chains[chains_n].begin = begin;
+        chains[chains_n].end = i + 1;
+        chains[chains_n].jumps = is_unconditional(commands[i])
+            && !commands[i]->dest && i > begin
+            && commands[i - 1]->type == A_COMMAND;
+        chains[chains_n++].placed = false;
+        begin = i + 1;
+    }
+
+    *chains_n_ptr = chains_n;
+    return chains;
+}
+
+/*
+ * Function: next_chain
+ * --------------------
+ *  picks chain to lay out right after the given one: the chain its jump
+ *  goes to, if the jump can be dropped for fall through
+ *
+ *  commands: list of commands
+ *  chains: list of chains
+ *  chains_n: amount of chains
+ *  labels: table of labels
+ *  current: chain just laid out
+ *
+ *  returns: index of the chain
+ *           chains_n if jump has to stay
+ */
+static size_t next_chain(asm_command_t **commands, layout_chain_t *chains,
+        size_t chains_n, ctable_t *labels, const layout_chain_t *current)
+{
+    const layout_chain_t *last = &chains[chains_n - 1];
+    int32_t label;
+    size_t lo = 0, hi = chains_n, mid;
+
+    if (!current->jumps || (label = ctable_get(labels,
+                    commands[current->end - 2]->symbol)) < 0) {
+        return chains_n;
+    }
+
+    /* chains are sorted by position, find the one holding the label */
+    while (hi - lo > 1) {
+        mid = (lo + hi) / 2;
+        if (chains[mid].begin <= (size_t) label) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    /* only labels heading the chain are reached by falling into it, the
+     * entry chain stays first and open chain ending program stays last */
+    for (size_t i = chains[lo].begin; i < (size_t) label; i++) {
+        if (commands[i]->type != L_COMMAND) {
+            return chains_n;
+        }
+    }
+    if (chains[lo].placed || lo == 0 || (&chains[lo] == last
+                && !is_unconditional(commands[last->end - 1]))
+            || reads_a_first(commands, &chains[lo])) {
+        return chains_n;
+    }
+    return lo;
+}
+
+/*
+ * Function: optimize_layout
+ * -------------------------
+ *  rearranges basic blocks for fall through:
+ *   - jumps landing on unconditional jump go straight to its target
+ *   - chain of blocks closed by '@L 0;JMP' is followed by chain starting
+ *     at L, and the jump is dropped
+ *
+ *  first chain stays at ROM address 0 and chain falling off the end of
+ *  the program stays last; nothing is moved if any jump goes to fixed ROM
+ *  address (number, predefined symbol or variable) or label is defined
+ *  more than once
+ *
+ *  removed commands are freed; labels are kept, so their addresses have to
+ *  be resolved again afterwards
+ *
+ *  commands: list of parsed commands (rearranged in place)
+ *  n: amount of commands
+ *  builtins: table of predefined symbols
+ *
+ *  returns: amount of commands left
+ */
+size_t optimize_layout(asm_command_t **commands, size_t n, table_t *builtins)
+{
+    layout_chain_t *chains, *chain;
+    asm_command_t **laid_out;
+    size_t chains_n, m = 0, next = 0, c = 0;
+    ctable_t *labels;
+
+    if (n == 0 || n > INT32_MAX) {
+        return n;
+    }
+
+    labels = collect_labels(commands, n);
+    thread_jumps(commands, n, labels);
+    if (fixed_addresses(commands, n, labels, builtins)) {
+        ctable_del(labels);
+        return n;
+    }
+
+    chains = split_chains(commands, n, &chains_n);
+    laid_out = malloc(n * sizeof(asm_command_t *));
+
+    while (c < chains_n) {
+        chain = &chains[c];
+        chain->placed = true;
+        memcpy(laid_out + m, commands + chain->begin,
+                (chain->end - chain->begin) * sizeof(asm_command_t *));
+        m += chain->end - chain->begin;
+
+        if ((c = next_chain(commands, chains, chains_n, labels, chain))
+                < chains_n) {
+            /* target falls in now, so '@L 0;JMP' goes away */
+            command_del(laid_out[--m]);
+            command_del(laid_out[--m]);
+            continue;
+        }
+
+        /* otherwise keep the original order */
+        while (next < chains_n && chains[next].placed) {
+            next++;
+        }
+        c = next;
+    }
+
+    memcpy(commands, laid_out, m * sizeof(asm_command_t *));
+    free(laid_out);
+    free(chains);
+    ctable_del(labels);
+    return m;
+}
+
+/*
+ * Function: optimize_unreachable
+ * ------------------------------
+ *  removes commands which can't be reached from ROM address 0: control
+ *  flows from a reached command to the next one unless it always jumps,
+ *  and every label loaded by a reached command is reached as well, be it
+ *  direct jump target or address stored for computed jump later
+ *
+ *  nothing is removed if any jump goes to fixed ROM address (number,
+ *  predefined symbol or variable) or label is defined more than once;
+ *  addresses computed from plain numbers can't be followed
+ *
+ *  removed commands are freed (labels included), so addresses have to be
+ *  resolved again afterwards
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n: amount of commands
+ *  builtins: table of predefined symbols
+ *  removed_ptr: amount of removed ROM words
+ *
+ *  returns: amount of commands left
+ */
+size_t optimize_unreachable(asm_command_t **commands, size_t n,
+        table_t *builtins, size_t *removed_ptr)
+{
+    size_t *pending, pending_n = 0, i, m;
+    bool *reached;
+    ctable_t *labels;
+    int32_t target;
+
+    *removed_ptr = 0;
+    if (n == 0 || n > INT32_MAX) {
+        return n;
+    }
+
+    labels = collect_labels(commands, n);
+    if (fixed_addresses(commands, n, labels, builtins)) {
+        ctable_del(labels);
+        return n;
+    }
+
+    /* every push but the first one comes from distinct A command */
+    reached = calloc(n, sizeof(bool));
+    pending = malloc((n + 1) * sizeof(size_t));
+    pending[pending_n++] = 0;
+
+    while (pending_n > 0) {
+        for (i = pending[--pending_n]; i < n && !reached[i]; i++) {
+            reached[i] = true;
+            if (commands[i]->type == A_COMMAND && (target = ctable_get(
+                            labels, commands[i]->symbol)) >= 0
+                    && !reached[target]) {
+                pending[pending_n++] = target;
+            }
+            if (is_unconditional(commands[i])) {
+                break;
+            }
+        }
+    }
+
+    for (i = 0, m = 0; i < n; i++) {
+        if (reached[i]) {
+            commands[m++] = commands[i];
+            continue;
+        }
+        if (commands[i]->type == A_COMMAND
+                || commands[i]->type == C_COMMAND) {
+            (*removed_ptr)++;
+        }
+        command_del(commands[i]);
+    }
+
+    free(reached);
+    free(pending);
+    ctable_del(labels);
+    return m;
+}
@@ -0,0 +1,92 @@
+/*
+ * File: optimize.h
+ * ----------------
+ *  function declarations for optimize module
+ *
+ *  rewrites parsed assembler commands into shorter equivalent sequences,
+ *  lays out basic blocks so that control falls through instead of
+ *  jumping and removes code that is never reached
+ */
+
+#ifndef HACK_ASM_OPTIMIZE_H
+#define HACK_ASM_OPTIMIZE_H
+
+#include <stdlib.h>
+
+#include "parser.h"
+#include "table.h"
+
+#define LAYOUT_AMBIGUOUS -2 /* label defined more than once */
+#define LAYOUT_COMMANDS_PER_LABEL 8 /* sizes label table from commands */
+
+/*
+ * Function: optimize_peephole
+ * ---------------------------
+ *  removes redundant commands until no rule applies:
+ *   - repeated load of the address already held in A
+ *   - '@0'/'@1' folded into following command as constant comp
+ *   - jump to the very next command
+ *   - stores to A, D or M overwritten before being read
+ *   - loads to A overwritten before being read
+ *
+ *  removed commands are freed; labels are kept, so their addresses have to
+ *  be resolved again afterwards
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n: amount of commands
+ *  builtins: table of predefined symbols
+ *
+ *  returns: amount of commands left
+ */
+size_t optimize_peephole(asm_command_t **commands, size_t n, table_t *builtins);
+
+/*
+ * Function: optimize_layout
+ * -------------------------
+ *  rearranges basic blocks for fall through:
+ *   - jumps landing on unconditional jump go straight to its target
+ *   - chain of blocks closed by '@L 0;JMP' is followed by chain starting
+ *     at L, and the jump is dropped
+ *
+ *  first chain stays at ROM address 0 and chain falling off the end of
+ *  the program stays last; nothing is moved if any jump goes to fixed ROM
+ *  address (number, predefined symbol or variable) or label is defined
+ *  more than once
+ *
+ *  removed commands are freed; labels are kept, so their addresses have to
+ *  be resolved again afterwards
+ *
+ *  commands: list of parsed commands (rearranged in place)
+ *  n: amount of commands
+ *  builtins: table of predefined symbols
+ *
+ *  returns: amount of commands left
+ */
+size_t optimize_layout(asm_command_t **commands, size_t n, table_t *builtins);
+
+/*
+ * Function: optimize_unreachable
+ * ------------------------------
+ *  removes commands which can't be reached from ROM address 0: control
+ *  flows from a reached command to the next one unless it always jumps,
+ *  and every label loaded by a reached command is reached as well, be it
+ *  direct jump target or address stored for computed jump later
+ *
+ *  nothing is removed if any jump goes to fixed ROM address (number,
+ *  predefined symbol or variable) or label is defined more than once;
+ *  addresses computed from plain numbers can't be followed
+ *
+ *  removed commands are freed (labels included), so addresses have to be
+ *  resolved again afterwards
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n: amount of commands
+ *  builtins: table of predefined symbols
+ *  removed_ptr: amount of removed ROM words
+ *
+ *  returns: amount of commands left
+ */
+size_t optimize_unreachable(asm_command_t **commands, size_t n,
+        table_t *builtins, size_t *removed_ptr);
+
+#endif // !HACK_ASM_OPTIMIZE_H
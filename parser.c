@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "code.h"
 #include "parser.h"
 
 /*
@@ -34,6 +35,10 @@ static asm_command_t *command_new(command_type_t type)
     command->dest = NULL;
     command->comp = NULL;
     command->jump = NULL;
+    command->line = 0;
+    command->file = NULL;
+    command->code = COMMAND_NOT_ENCODED;
+    command->id = COMMAND_NO_ID;
     return command;
 }
 
@@ -53,6 +58,67 @@ void command_del(asm_command_t *command)
     free(command);
 }
 
+/*
+ * Function: dup_field
+ * -------------------
+ *  duplicates optional command field
+ *
+ *  field: field to copy (can be NULL)
+ *
+ *  returns: allocated copy
+ *           NULL if field is NULL
+ */
+static char *dup_field(const char *field)
+{
+    return field ? strdup(field) : NULL;
+}
+
+/*
+ * Function: command_copy
+ * ----------------------
+ *  duplicates command with all of its fields
+ *
+ *  command: command to copy
+ *
+ *  returns: pointer to newly allocated command
+ */
+asm_command_t *command_copy(const asm_command_t *command)
+{
+    asm_command_t *copy = command_new_from(command->type,
+            dup_field(command->symbol), dup_field(command->dest),
+            dup_field(command->comp), dup_field(command->jump), command->line);
+    copy->file = command->file;
+    copy->code = command->code;
+    copy->id = command->id;
+    return copy;
+}
+
+/*
+ * Function: command_new_from
+ * --------------------------
+ *  creates command from its raw fields (used by parse cache)
+ *
+ *  type: type of assembler command
+ *  symbol: symbol field (can be NULL), should be allocated
+ *  dest: dest field (can be NULL), should be allocated
+ *  comp: comp field (can be NULL), should be allocated
+ *  jump: jump field (can be NULL), should be allocated
+ *  line: source line number
+ *
+ *  returns: a pointer to newly created command in memory
+ */
+asm_command_t *command_new_from(command_type_t type, char *symbol,
+        char *dest, char *comp, char *jump, size_t line)
+{
+    asm_command_t *command = command_new(type);
+    command->symbol = symbol;
+    command->dest = dest;
+    command->comp = comp;
+    command->jump = jump;
+    command->line = line;
+    return command;
+}
+
 /*
  * Function: command_addr_new
  * --------------------------
@@ -130,14 +196,18 @@ static bool iscomment(char c)
  *  or end of the file is reached
  *
  *  stream: input stream with asm commands
+ *  line_ptr: current line number, advanced for every skipped line
  */
-static void skip_comments_and_spaces(FILE *stream)
+static void skip_comments_and_spaces(FILE *stream, size_t *line_ptr)
 {
     char c = getc(stream);
 
     while (isspace(c) || iscomment(c)) {
         /* skip all leading whitespace */
         while (isspace(c)) {
+            if (c == '\n') {
+                *line_ptr += 1;
+            }
             c = getc(stream);
         }
 
@@ -163,15 +233,19 @@ static void skip_comments_and_spaces(FILE *stream)
  *
  *  stream: data stream to be read from
  *  buffer: string to store assembler command
+ *  line_ptr: current line number, advanced past the command
+ *  command_line_ptr: line number the command is written on
  *
  *  returns: amount of characters written to buffer
  */
-static size_t read_command(FILE *stream, char *buffer)
+static size_t read_command(FILE *stream, char *buffer,
+        size_t *line_ptr, size_t *command_line_ptr)
 {
     char c;
     size_t i;
 
-    skip_comments_and_spaces(stream);
+    skip_comments_and_spaces(stream, line_ptr);
+    *command_line_ptr = *line_ptr;
 
     i = 0;
     while ((c = getc(stream)) != EOF && c != '\n') {
@@ -181,6 +255,10 @@ static size_t read_command(FILE *stream, char *buffer)
         }
     }
 
+    if (c == '\n') {
+        *line_ptr += 1;
+    }
+
     buffer[i] = '\0';
     return i;
 }
@@ -213,6 +291,22 @@ static bool islabl(const char *line) {
     return line[0] == '(';
 }
 
+/*
+ * Function: isincl
+ * ----------------
+ *  determines whether the given command is include directive
+ *
+ *  line: assembler command in plain text
+ *
+ *  returns: true if '#include' or '.include' directive
+ *           false otherwise
+ */
+static bool isincl(const char *line) {
+    return !strncmp(line, INCLUDE_DIRECTIVE, strlen(INCLUDE_DIRECTIVE))
+        || !strncmp(line, INCLUDE_DIRECTIVE_ALT,
+                strlen(INCLUDE_DIRECTIVE_ALT));
+}
+
 /*
  * Function: classify_command
  * --------------------------
@@ -228,6 +322,8 @@ static command_type_t classify_command(const char *line)
         return A_COMMAND;
     } else if (islabl(line)) {
         return L_COMMAND;
+    } else if (isincl(line)) {
+        return I_COMMAND;
     }
     /* first ver assumes input commands are valid so don't need to check */
     return C_COMMAND;
@@ -263,6 +359,29 @@ static char *get_symbol_from_labl(const char *line, size_t line_len)
     return strndup(line + 1, line_len - 2);
 }
 
+/*
+ * Function: get_path_from_incl
+ * ----------------------------
+ *  extracts included path of include directive, the path may be wrapped
+ *  into quotes or angle brackets
+ *
+ *  line: assembler command in plain text (whitespace already removed)
+ *
+ *  returns: included path
+ */
+static char *get_path_from_incl(const char *line)
+{
+    /* both directives have the same length */
+    const char *path = line + strlen(INCLUDE_DIRECTIVE);
+    size_t len = strlen(path);
+
+    if (len >= 2 && ((path[0] == '"' && path[len - 1] == '"')
+                || (path[0] == '<' && path[len - 1] == '>'))) {
+        return strndup(path + 1, len - 2);
+    }
+    return strdup(path);
+}
+
 /*
  * Function: get_dest
  * ------------------
@@ -338,24 +457,57 @@ static char *get_jump(const char *line)
     return strdup(divider + 1);
 }
 
+/*
+ * Function: command_from_cache
+ * ----------------------------
+ *  creates C command from encoding cache entry without parsing its text
+ *
+ *  entry: cache entry of the command text
+ *
+ *  returns: command C structure with known encoding
+ */
+static asm_command_t *command_from_cache(const code_cache_entry_t *entry)
+{
+    const char *text = entry->text;
+    char *dest = NULL, *comp, *jump = NULL;
+    asm_command_t *command;
+
+    /* fields are the same get_dest, get_comp and get_jump would produce */
+    if (entry->eq != CODE_CACHE_NONE) {
+        dest = strndup(text, entry->eq);
+        comp = strdup(text + entry->eq + 1);
+    } else {
+        comp = strndup(text, entry->semi);
+    }
+    if (entry->semi != CODE_CACHE_NONE) {
+        jump = strdup(text + entry->semi + 1);
+    }
+
+    command = command_comp_new(dest, comp, jump);
+    command->code = entry->code;
+    return command;
+}
+
 /*
  * Function: get_command
  * ---------------------
  *  reads next command from the file stream and returns in a structured way
  *
  *  stream: input data stream to be read
+ *  line_ptr: current line number (starts with 1), advanced past the command
  *
  *  returns: pointer to structure representing assembler command
  *           NULL if no commands left
  */
-asm_command_t *get_command(FILE *stream)
+asm_command_t *get_command(FILE *stream, size_t *line_ptr)
 {
     char line[MAXLINE];
-    size_t line_len;
+    size_t line_len, command_line;
     char *symbol, *dest, *comp, *jump;
+    const code_cache_entry_t *cached;
     asm_command_t *command;
 
-    if ((line_len = read_command(stream, line)) == 0) {
+    if ((line_len = read_command(stream, line, line_ptr, &command_line)) == 0) {
         return NULL;
     }
 
@@ -365,6 +517,10 @@ asm_command_t *get_command(FILE *stream)
             command = command_addr_new(symbol);
             break;
         case C_COMMAND:
+            if ((cached = encode_cached(line))) {
+                command = command_from_cache(cached);
+                break;
+            }
             dest = get_dest(line);
             comp = get_comp(line);
             jump = get_jump(line);
@@ -374,7 +530,12 @@ asm_command_t *get_command(FILE *stream)
             symbol = get_symbol_from_labl(line, line_len);
             command = command_labl_new(symbol);
             break;
+        case I_COMMAND:
+            command = command_new(I_COMMAND);
+            command->symbol = get_path_from_incl(line);
+            break;
     }
 
+    command->line = command_line;
     return command;
 }
@@ -14,14 +14,22 @@
 #ifndef HACK_ASM_PARSER_H
 #define HACK_ASM_PARSER_H
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #define MAXLINE 256
 
+#define COMMAND_NOT_ENCODED -1
+#define COMMAND_NO_ID -1
+
+#define INCLUDE_DIRECTIVE "#include"
+#define INCLUDE_DIRECTIVE_ALT ".include"
+
 typedef enum {
     A_COMMAND,
     C_COMMAND,
-    L_COMMAND
+    L_COMMAND,
+    I_COMMAND /* include directive, symbol holds included path */
 } command_type_t;
 
 typedef struct {
@@ -30,6 +38,12 @@ typedef struct {
     char *dest;
     char *comp;
     char *jump;
+    size_t line;      /* source line number */
+    const char *file; /* included file the command comes from (or NULL) */
+    int code;         /* 16 bit encoding of C command known from parsing
+                         (COMMAND_NOT_ENCODED if it has to be encoded) */
+    int id;           /* dense ID of A command operand assigned by
+                         assembler (COMMAND_NO_ID until then) */
 } asm_command_t;
 
 /*
@@ -41,6 +55,34 @@ typedef struct {
  */
 void command_del(asm_command_t *command);
 
+/*
+ * Function: command_copy
+ * ----------------------
+ *  duplicates command with all of its fields
+ *
+ *  command: command to copy
+ *
+ *  returns: pointer to newly allocated command
+ */
+asm_command_t *command_copy(const asm_command_t *command);
+
+/*
+ * Function: command_new_from
+ * --------------------------
+ *  creates command from its raw fields (used by parse cache)
+ *
+ *  type: type of assembler command
+ *  symbol: symbol field (can be NULL), should be allocated
+ *  dest: dest field (can be NULL), should be allocated
+ *  comp: comp field (can be NULL), should be allocated
+ *  jump: jump field (can be NULL), should be allocated
+ *  line: source line number
+ *
+ *  returns: a pointer to newly created command in memory
+ */
+asm_command_t *command_new_from(command_type_t type, char *symbol,
+        char *dest, char *comp, char *jump, size_t line);
+
 /*
  * Function: get_command
  * ---------------------
@@ -50,10 +92,11 @@ void command_del(asm_command_t *command);
  *  with corresponding destructor 'command_del'
  *
  *  stream: input data stream to be read
+ *  line_ptr: current line number (starts with 1), advanced past the command
  *
  *  returns: pointer to structure representing assembler command
  *           NULL if no commands left
  */
-asm_command_t *get_command(FILE *stream);
+asm_command_t *get_command(FILE *stream, size_t *line_ptr);
 
 #endif // !HACK_ASM_PARSER_H
@@ -0,0 +1,342 @@
+/*
+ * File: patch.c
+ * -------------
+ *  diffs encoded program against image of the previous build, writes the
+ *  difference as patch file and applies it to the image in place
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "emit.h"
+#include "helpers.h"
+#include "patch.h"
+
+#define PATCH_READ_SIZE (64 * 1024)
+
+/*
+ * Function: read_all
+ * ------------------
+ *  reads the rest of the stream into memory
+ *
+ *  stream: readable stream
+ *  len_ptr: amount of bytes read
+ *
+ *  returns: allocated contents
+ *           NULL if stream can't be read
+ */
+static char *read_all(FILE *stream, size_t *len_ptr)
+{
+    size_t len = 0, capacity = PATCH_READ_SIZE, got;
+    char *data = malloc(capacity);
+
+    while ((got = fread(data + len, 1, capacity - len, stream)) > 0) {
+        len += got;
+        if (len == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+    }
+    if (ferror(stream)) {
+        free(data);
+        return NULL;
+    }
+    *len_ptr = len;
+    return data;
+}
+
+/*
+ * Function: parse_text
+ * --------------------
+ *  decodes lines of binary digits following optional '//' comment lines
+ *
+ *  data: image contents
+ *  len: amount of bytes
+ *  image: image with width set
+ *
+ *  returns: false if image is malformed
+ */
+static bool parse_text(const char *data, size_t len, patch_image_t *image)
+{
+    size_t pos = 0;
+    uint32_t word;
+    const char *line;
+
+    while (len - pos >= 2 && data[pos] == '/' && data[pos + 1] == '/') {
+        while (pos < len && data[pos] != '\n') {
+            pos++;
+        }
+        if (pos++ == len) {
+            return false;
+        }
+    }
+
+    image->header = pos;
+    image->stride = image->width + 1;
+    if ((len - pos) % image->stride) {
+        return false;
+    }
+    image->n = (len - pos) / image->stride;
+    image->words = malloc((image->n ? image->n : 1) * sizeof(uint32_t));
+
+    for (size_t i = 0; i < image->n; i++) {
+        line = data + pos + i * image->stride;
+        word = 0;
+        for (int j = 0; j < image->width; j++) {
+            if (line[j] != '0' && line[j] != '1') {
+                return false;
+            }
+            word = (word << 1) | (line[j] - '0');
+        }
+        if (line[image->width] != '\n') {
+            return false;
+        }
+        image->words[i] = word;
+    }
+    return true;
+}
+
+/*
+ * Function: parse_binary
+ * ----------------------
+ *  decodes raw words, most significant byte first
+ *
+ *  data: image contents
+ *  len: amount of bytes
+ *  image: image with width set
+ *
+ *  returns: false if image is malformed
+ */
+static bool parse_binary(const char *data, size_t len, patch_image_t *image)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+
+    image->header = 0;
+    image->stride = image->width / 8;
+    if (len % image->stride) {
+        return false;
+    }
+    image->n = len / image->stride;
+    image->words = malloc((image->n ? image->n : 1) * sizeof(uint32_t));
+
+    for (size_t i = 0; i < image->n; i++) {
+        image->words[i] = 0;
+        for (size_t j = 0; j < image->stride; j++) {
+            image->words[i] = (image->words[i] << 8)
+                | bytes[i * image->stride + j];
+        }
+    }
+    return true;
+}
+
+/*
+ * Function: patch_image_read
+ * --------------------------
+ *  reads image of previous build, format is given by suffix of its path
+ *
+ *  stream: readable binary stream of the image
+ *  path: image path
+ *  width: bits per word (16 or 32)
+ *  image: image to fill (words are allocated)
+ *
+ *  returns: true if image is read
+ *           false if format can't be patched or image is malformed
+ */
+bool patch_image_read(FILE *stream, const char *path, int width,
+        patch_image_t *image)
+{
+    const emit_format_t *format = emit_format(path);
+    size_t len;
+    char *data;
+    bool ok;
+
+    memset(image, 0, sizeof(patch_image_t));
+    image->width = width;
+
+    /* Intel HEX records carry checksums, so words can't be rewritten
+     * on their own */
+    if (!format || !strcmp(format->suffix, ".hex")
+            || !(data = read_all(stream, &len))) {
+        return false;
+    }
+
+    image->text = strcmp(format->suffix, ".bin") != 0;
+    ok = image->text ? parse_text(data, len, image)
+        : parse_binary(data, len, image);
+    free(data);
+
+    if (!ok) {
+        free(image->words);
+        image->words = NULL;
+    }
+    return ok;
+}
+
+/*
+ * Function: patch_diff
+ * --------------------
+ *  finds runs of words that differ from the image, runs separated by
+ *  fewer unchanged bytes than run header takes are merged
+ *
+ *  image: image of previous build
+ *  words: words of the new program
+ *  n: amount of words
+ *
+ *  returns: pointer to allocated patch
+ */
+patch_t *patch_diff(const patch_image_t *image, const uint32_t *words,
+        size_t n)
+{
+    patch_t *patch = calloc(1, sizeof(patch_t));
+    size_t capacity = 0, word_size = image->width / 8;
+    patch_run_t *last;
+
+    patch->words = words;
+    patch->n = n;
+
+    for (size_t i = 0; i < n; i++) {
+        if (i < image->n && image->words[i] == words[i]) {
+            continue;
+        }
+
+        last = patch->runs_n ? &patch->runs[patch->runs_n - 1] : NULL;
+        if (last && (i - last->address - last->n) * word_size
+                <= PATCH_RUN_HEADER_SIZE) {
+            /* resending the gap is cheaper than starting new run */
+            patch->changed += i - last->address + 1 - last->n;
+            last->n = i - last->address + 1;
+            continue;
+        }
+
+        if (patch->runs_n == capacity) {
+            capacity = capacity ? 2 * capacity : 16;
+            patch->runs = realloc(patch->runs,
+                    capacity * sizeof(patch_run_t));
+        }
+        patch->runs[patch->runs_n].address = i;
+        patch->runs[patch->runs_n++].n = 1;
+        patch->changed++;
+    }
+    return patch;
+}
+
+/*
+ * Function: patch_write
+ * ---------------------
+ *  writes patch file
+ *
+ *  stream: writable binary stream
+ *  patch: patch
+ *  width: bits per word
+ *
+ *  returns: false if stream can't be written
+ */
+bool patch_write(FILE *stream, const patch_t *patch, int width)
+{
+    const patch_run_t *run;
+
+    fputs(PATCH_MAGIC, stream);
+    fputc(width, stream);
+    put_u32(stream, patch->n);
+    put_u32(stream, patch->runs_n);
+
+    for (size_t i = 0; i < patch->runs_n; i++) {
+        run = &patch->runs[i];
+        put_u32(stream, run->address);
+        put_u32(stream, run->n);
+        for (uint32_t j = run->address; j < run->address + run->n; j++) {
+            if (width > 16) {
+                put_u32(stream, patch->words[j]);
+            } else {
+                put_u16(stream, patch->words[j]);
+            }
+        }
+    }
+    return !ferror(stream);
+}
+
+/*
+ * Function: pwrite_all
+ * --------------------
+ *  writes whole buffer at given offset, retrying short writes
+ *
+ *  returns: false if file can't be written
+ */
+static bool pwrite_all(int fd, const char *buffer, size_t len, off_t offset)
+{
+    ssize_t written;
+
+    while (len > 0) {
+        if ((written = pwrite(fd, buffer, len, offset)) <= 0) {
+            return false;
+        }
+        buffer += written;
+        len -= written;
+        offset += written;
+    }
+    return true;
+}
+
+/*
+ * Function: patch_apply
+ * ---------------------
+ *  updates the image file in place: writes changed words at their offsets
+ *  and cuts or extends the file to length of the new program
+ *
+ *  fd: file descriptor of the image opened for writing
+ *  image: image of previous build read from the file
+ *  patch: patch made against the image
+ *
+ *  returns: false if file can't be written
+ */
+bool patch_apply(int fd, const patch_image_t *image, const patch_t *patch)
+{
+    const patch_run_t *run;
+    char *buffer, *p;
+    uint32_t word;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < patch->runs_n; i++) {
+        run = &patch->runs[i];
+        buffer = malloc(run->n * image->stride);
+
+        p = buffer;
+        for (uint32_t j = run->address; j < run->address + run->n; j++) {
+            word = patch->words[j];
+            if (image->text) {
+                emit_hack_line(p, word, image->width);
+            } else {
+                for (size_t k = 0; k < image->stride; k++) {
+                    p[k] = word >> (8 * (image->stride - k - 1));
+                }
+            }
+            p += image->stride;
+        }
+
+        ok = pwrite_all(fd, buffer, run->n * image->stride,
+                image->header + (off_t) run->address * image->stride);
+        free(buffer);
+    }
+
+    if (ok && patch->n < image->n) {
+        ok = !ftruncate(fd, image->header + (off_t) patch->n * image->stride);
+    }
+    return ok;
+}
+
+/*
+ * Function: patch_del
+ * -------------------
+ *  frees memory allocated by patch
+ *
+ *  patch: patch to be deleted
+ */
+void patch_del(patch_t *patch)
+{
+    free(patch->runs);
+    free(patch);
+}
@@ -0,0 +1,121 @@
+/*
+ * File: patch.h
+ * -------------
+ *  types, constants and function declarations for patch module
+ *
+ *  compares encoded program with image of the previous build and
+ *  describes the difference as runs of changed words, so loaders (and
+ *  in place update of the image) touch only words that changed
+ *
+ *  images with fixed bytes per word can be patched: .hack and .mem text
+ *  (one line of binary digits per word, .mem after its header) and .bin
+ *
+ *  binary layout of patch file (all integers little endian):
+ *
+ *      "HPT1" u8 width  u32 words_n  u32 runs_n
+ *      (u32 address  u32 n  word * n) * runs_n
+ *
+ *  words_n is length of the new program (image is cut or extended to it),
+ *  words are u16 or u32 by width, runs are sorted by address
+ */
+
+#ifndef HACK_ASM_PATCH_H
+#define HACK_ASM_PATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PATCH_MAGIC "HPT1"
+#define PATCH_RUN_HEADER_SIZE 8 /* bytes of run address and length */
+
+typedef struct {
+    uint32_t *words;
+    size_t n;
+    size_t header; /* bytes before the first word */
+    size_t stride; /* bytes per word */
+    bool text;     /* words are lines of binary digits */
+    int width;     /* bits per word */
+} patch_image_t;
+
+typedef struct {
+    uint32_t address; /* first word of the run */
+    uint32_t n;       /* amount of words */
+} patch_run_t;
+
+typedef struct {
+    const uint32_t *words; /* words of the new program (not owned) */
+    size_t n;
+    patch_run_t *runs;
+    size_t runs_n;
+    size_t changed;        /* words carried by runs */
+} patch_t;
+
+/*
+ * Function: patch_image_read
+ * --------------------------
+ *  reads image of previous build, format is given by suffix of its path
+ *
+ *  stream: readable binary stream of the image
+ *  path: image path
+ *  width: bits per word (16 or 32)
+ *  image: image to fill (words are allocated)
+ *
+ *  returns: true if image is read
+ *           false if format can't be patched or image is malformed
+ */
+bool patch_image_read(FILE *stream, const char *path, int width,
+        patch_image_t *image);
+
+/*
+ * Function: patch_diff
+ * --------------------
+ *  finds runs of words that differ from the image, runs separated by
+ *  fewer unchanged bytes than run header takes are merged
+ *
+ *  image: image of previous build
+ *  words: words of the new program
+ *  n: amount of words
+ *
+ *  returns: pointer to allocated patch
+ */
+patch_t *patch_diff(const patch_image_t *image, const uint32_t *words,
+        size_t n);
+
+/*
+ * Function: patch_write
+ * ---------------------
+ *  writes patch file
+ *
+ *  stream: writable binary stream
+ *  patch: patch
+ *  width: bits per word
+ *
+ *  returns: false if stream can't be written
+ */
+bool patch_write(FILE *stream, const patch_t *patch, int width);
+
+/*
+ * Function: patch_apply
+ * ---------------------
+ *  updates the image file in place: writes changed words at their offsets
+ *  and cuts or extends the file to length of the new program
+ *
+ *  fd: file descriptor of the image opened for writing
+ *  image: image of previous build read from the file
+ *  patch: patch made against the image
+ *
+ *  returns: false if file can't be written
+ */
+bool patch_apply(int fd, const patch_image_t *image, const patch_t *patch);
+
+/*
+ * Function: patch_del
+ * -------------------
+ *  frees memory allocated by patch
+ *
+ *  patch: patch to be deleted
+ */
+void patch_del(patch_t *patch);
+
+#endif // !HACK_ASM_PATCH_H
@@ -0,0 +1,323 @@
+/*
+ * File: profiler.c
+ * ----------------
+ *  entry point for hack profiler program
+ *
+ *  joins source map written by HackAssembler with program counter profile
+ *  or trace written by HackSimulator and reports cycles per source line and
+ *  per label, either as flat table or as folded stacks for flamegraph tools
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+
+#define PROFILER_LINE_MAX 512
+#define PROFILER_UNKNOWN "?"
+
+typedef struct {
+    const char *file;  /* source file ('?' if address is not mapped) */
+    size_t line;       /* source line (0 if address is not mapped) */
+    const char *label; /* enclosing label ('?' if there is none) */
+    uint64_t cycles;
+} profiler_entry_t;
+
+/*
+ * Function: write_help_msg
+ * ------------------------
+ *  writes help message for HackProfiler user
+ */
+static void write_help_msg(void)
+{
+    printf("\nUsage: HackProfiler [-f] map profile\n\n"
+           "Report cycles per source line and label.\n\n"
+           "Arguments:\n"
+           "map(required)\t\tsource map written by 'HackAssembler -m'\n"
+           "profile(required)\t'address cycles' profile written by\n"
+           "\t\t\t'HackSimulator -p' or trace of addresses\n"
+           "-f\t\t\twrite folded stacks 'file;label;line cycles'\n\n");
+}
+
+/*
+ * Function: read_map
+ * ------------------
+ *  reads source map into per address entries
+ *
+ *  path: source map path
+ *  entries: CPU_ROM_SIZE + 1 entries to fill
+ *
+ *  returns: true if the map is valid
+ *           false otherwise
+ */
+static bool read_map(const char *path, profiler_entry_t *entries)
+{
+    char line[PROFILER_LINE_MAX];
+    char label[PROFILER_LINE_MAX];
+    const char *file = PROFILER_UNKNOWN, *enclosing = PROFILER_UNKNOWN;
+    unsigned address;
+    size_t source_line;
+    int fields;
+    FILE *stream;
+
+    if (!(stream = fopen(path, "r"))) {
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), stream)) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (!strncmp(line, "file ", 5)) {
+            file = strdup(line + 5);
+            continue;
+        }
+
+        fields = sscanf(line, "%u %zu %s", &address, &source_line, label);
+        if (fields < 2 || address >= CPU_ROM_SIZE) {
+            fclose(stream);
+            return false;
+        }
+
+        if (fields == 3) {
+            enclosing = strdup(label);
+        }
+        entries[address].file = file;
+        entries[address].line = source_line;
+        entries[address].label = enclosing;
+    }
+
+    fclose(stream);
+    return true;
+}
+
+/*
+ * Function: read_profile
+ * ----------------------
+ *  accumulates cycles of 'address cycles' profile or address trace
+ *
+ *  path: profile path
+ *  entries: CPU_ROM_SIZE + 1 entries to update
+ *
+ *  returns: true if the profile is valid
+ *           false otherwise
+ */
+static bool read_profile(const char *path, profiler_entry_t *entries)
+{
+    char line[PROFILER_LINE_MAX];
+    unsigned address;
+    unsigned long long cycles;
+    int fields;
+    FILE *stream;
+
+    if (!(stream = fopen(path, "r"))) {
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), stream)) {
+        /* trace holds only address, every line is one executed command */
+        fields = sscanf(line, "%u %llu", &address, &cycles);
+        if (fields < 1 || address > CPU_ROM_SIZE) {
+            fclose(stream);
+            return false;
+        }
+        entries[address].cycles += fields == 2 ? cycles : 1;
+    }
+
+    fclose(stream);
+    return true;
+}
+
+/*
+ * Function: cmp_location
+ * ----------------------
+ *  orders entries by file and line
+ */
+static int cmp_location(const void *p, const void *q)
+{
+    const profiler_entry_t *u = p, *v = q;
+    int c = strcmp(u->file, v->file);
+
+    if (c) {
+        return c;
+    }
+    return (u->line > v->line) - (u->line < v->line);
+}
+
+/*
+ * Function: cmp_label
+ * -------------------
+ *  orders entries by file and label
+ */
+static int cmp_label(const void *p, const void *q)
+{
+    const profiler_entry_t *u = p, *v = q;
+    int c = strcmp(u->file, v->file);
+
+    return c ? c : strcmp(u->label, v->label);
+}
+
+/*
+ * Function: cmp_cycles
+ * --------------------
+ *  orders entries by cycles, hottest first
+ */
+static int cmp_cycles(const void *p, const void *q)
+{
+    const profiler_entry_t *u = p, *v = q;
+
+    return (u->cycles < v->cycles) - (u->cycles > v->cycles);
+}
+
+/*
+ * Function: merge_entries
+ * -----------------------
+ *  sums cycles of adjacent entries equal by comparator
+ *
+ *  entries: sorted entries (merged in place)
+ *  n: amount of entries
+ *  cmp: comparator entries are sorted with
+ *
+ *  returns: amount of merged entries
+ */
+static size_t merge_entries(profiler_entry_t *entries, size_t n,
+        int (*cmp)(const void *, const void *))
+{
+    size_t m = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (m && !cmp(&entries[m - 1], &entries[i])) {
+            entries[m - 1].cycles += entries[i].cycles;
+        } else {
+            entries[m++] = entries[i];
+        }
+    }
+
+    return m;
+}
+
+/*
+ * Function: write_flat
+ * --------------------
+ *  writes per line and per label tables, hottest first
+ *
+ *  entries: entries with non zero cycles (reordered)
+ *  n: amount of entries
+ */
+static void write_flat(profiler_entry_t *entries, size_t n)
+{
+    profiler_entry_t *labels = malloc((n ? n : 1) * sizeof(profiler_entry_t));
+    uint64_t total = 0;
+    size_t m;
+    char location[PROFILER_LINE_MAX];
+
+    for (size_t i = 0; i < n; i++) {
+        total += entries[i].cycles;
+    }
+    memcpy(labels, entries, n * sizeof(profiler_entry_t));
+
+    qsort(entries, n, sizeof(profiler_entry_t), cmp_location);
+    m = merge_entries(entries, n, cmp_location);
+    qsort(entries, m, sizeof(profiler_entry_t), cmp_cycles);
+
+    printf("%14s %7s  %-32s %s\n", "cycles", "%", "line", "label");
+    for (size_t i = 0; i < m; i++) {
+        snprintf(location, sizeof(location), "%s:%zu",
+                entries[i].file, entries[i].line);
+        printf("%14llu %6.2f%%  %-32s %s\n",
+                (unsigned long long) entries[i].cycles,
+                100.0 * entries[i].cycles / total, location, entries[i].label);
+    }
+
+    qsort(labels, n, sizeof(profiler_entry_t), cmp_label);
+    m = merge_entries(labels, n, cmp_label);
+    qsort(labels, m, sizeof(profiler_entry_t), cmp_cycles);
+
+    printf("\n%14s %7s  %s\n", "cycles", "%", "label");
+    for (size_t i = 0; i < m; i++) {
+        printf("%14llu %6.2f%%  %s:%s\n",
+                (unsigned long long) labels[i].cycles,
+                100.0 * labels[i].cycles / total, labels[i].file,
+                labels[i].label);
+    }
+
+    free(labels);
+}
+
+/*
+ * Function: write_folded
+ * ----------------------
+ *  writes folded stacks 'file;label;line cycles' one per source line
+ *
+ *  entries: entries with non zero cycles (reordered)
+ *  n: amount of entries
+ */
+static void write_folded(profiler_entry_t *entries, size_t n)
+{
+    size_t m;
+
+    qsort(entries, n, sizeof(profiler_entry_t), cmp_location);
+    m = merge_entries(entries, n, cmp_location);
+
+    for (size_t i = 0; i < m; i++) {
+        printf("%s;%s;%zu %llu\n", entries[i].file, entries[i].label,
+                entries[i].line, (unsigned long long) entries[i].cycles);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    profiler_entry_t *entries, *hot;
+    bool folded = false;
+    size_t n = 0;
+    int i = 1;
+
+    if (i < argc && !strcmp(argv[i], "-f")) {
+        folded = true;
+        i++;
+    }
+    if (argc - i != 2) {
+        write_help_msg();
+        exit(1);
+    }
+
+    entries = malloc((CPU_ROM_SIZE + 1) * sizeof(profiler_entry_t));
+    for (size_t j = 0; j <= CPU_ROM_SIZE; j++) {
+        entries[j].file = PROFILER_UNKNOWN;
+        entries[j].line = 0;
+        entries[j].label = PROFILER_UNKNOWN;
+        entries[j].cycles = 0;
+    }
+
+    if (!read_map(argv[i], entries)) {
+        fprintf(stderr, "HackProfiler: %s is not a valid source map\n", argv[i]);
+        exit(1);
+    }
+    if (!read_profile(argv[i + 1], entries)) {
+        fprintf(stderr, "HackProfiler: %s is not a valid profile\n",
+                argv[i + 1]);
+        exit(1);
+    }
+
+    /* only addresses that were actually executed are reported */
+    hot = malloc((CPU_ROM_SIZE + 1) * sizeof(profiler_entry_t));
+    for (size_t j = 0; j <= CPU_ROM_SIZE; j++) {
+        if (entries[j].cycles) {
+            hot[n++] = entries[j];
+        }
+    }
+
+    if (folded) {
+        write_folded(hot, n);
+    } else {
+        write_flat(hot, n);
+    }
+
+    /* file and label names live until exit */
+    free(entries);
+    free(hot);
+
+    return 0;
+}
@@ -0,0 +1,9 @@
+// M store of command writing A too goes to the old address, so -O must
+// keep it: RAM[18] ends up -1
+@18
+D=D+M
+AMD=!M
+AM=-D
+(END)
+@END
+0;JMP
@@ -0,0 +1,11 @@
+// assembled with -s of snapshot_save.asm snapshot, new variable j must not
+// alias loaded i: RAM[16] = 2, RAM[17] = 1
+@j
+M=1
+@2
+D=A
+@i
+M=D
+(END)
+@END
+0;JMP
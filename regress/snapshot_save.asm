@@ -0,0 +1,6 @@
+// saved with -S, its variable i takes RAM[16]
+@i
+M=1
+(END)
+@END
+0;JMP
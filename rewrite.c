@@ -0,0 +1,359 @@
+/*
+ * File: rewrite.c
+ * ---------------
+ *  loads rewrite database and replaces its target sequences in program
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "rewrite.h"
+
+#define REWRITE_KEY_MAX 8 /* longest key, 'AMD=D|M' and its separator */
+
+/*
+ * Function: parse_command
+ * -----------------------
+ *  splits single database command into its fields
+ *
+ *  text: command text in 'dest=comp' or 'comp' form (modified in place)
+ *  dest_ptr: allocated 'dest' field or NULL
+ *  comp_ptr: allocated 'comp' field
+ *
+ *  returns: false if command has invalid mnemonics
+ */
+static bool parse_command(char *text, char **dest_ptr, char **comp_ptr)
+{
+    char *comp = strchr(text, '=');
+    char *dest = NULL;
+
+    if (comp) {
+        *comp++ = '\0';
+        dest = text;
+        if (!valid_dest(dest)) {
+            return false;
+        }
+    } else {
+        comp = text;
+    }
+    if (!valid_comp(comp)) {
+        return false;
+    }
+
+    *dest_ptr = dest ? strdup(dest) : NULL;
+    *comp_ptr = strdup(comp);
+    return true;
+}
+
+/*
+ * Function: parse_side
+ * --------------------
+ *  splits side of the rule into its commands
+ *
+ *  text: commands separated by single spaces (modified in place)
+ *  rule: rule receiving the commands
+ *
+ *  returns: false if side is malformed or too long
+ */
+static bool parse_side(char *text, rewrite_rule_t *rule)
+{
+    char *next;
+
+    rule->n = 0;
+    if (*text == '\0') {
+        return true;
+    }
+    for (; text; text = next) {
+        if ((next = strchr(text, ' '))) {
+            *next++ = '\0';
+        }
+        if (rule->n == REWRITE_MAX_COMMANDS || !parse_command(text,
+                    &rule->dest[rule->n], &rule->comp[rule->n])) {
+            return false;
+        }
+        rule->n++;
+    }
+    return true;
+}
+
+/*
+ * Function: rule_free
+ * -------------------
+ *  frees commands of the rule
+ *
+ *  rule: rule to be freed
+ */
+static void rule_free(rewrite_rule_t *rule)
+{
+    for (size_t i = 0; i < rule->n; i++) {
+        free(rule->dest[i]);
+        free(rule->comp[i]);
+    }
+    rule->n = 0;
+}
+
+/*
+ * Function: parse_rule
+ * --------------------
+ *  adds single rule line to the database
+ *
+ *  db: database
+ *  line: rule line without newline (modified in place)
+ *
+ *  returns: false if rule is malformed, doesn't shorten its target, spells
+ *           'dest' of target out of canonical order or repeats target of
+ *           another rule
+ */
+static bool parse_rule(rewrite_db_t *db, char *line)
+{
+    char *tab = strchr(line, '\t');
+    rewrite_rule_t target = { .n = 0 };
+    rewrite_rule_t *rule;
+    char *text;
+    bool ok;
+
+    if (!tab || tab == line) {
+        return false;
+    }
+    *tab = '\0';
+    if (table_contains(db->targets, line)) {
+        return false;
+    }
+
+    /* target only gets validated, the table keeps its text */
+    text = strdup(line);
+    ok = parse_side(text, &target);
+    free(text);
+    /* target has to be spelled the way rewrite_key spells program, else it
+       never matches */
+    for (size_t i = 0; ok && i < target.n; i++) {
+        ok = !target.dest[i] || !strcmp(target.dest[i],
+                dest_mnemonic(encode_dest(target.dest[i])));
+    }
+    if (!ok || target.n == 0) {
+        rule_free(&target);
+        return false;
+    }
+
+    db->rules = realloc(db->rules, (db->n + 1) * sizeof(rewrite_rule_t));
+    rule = &db->rules[db->n];
+    if (!parse_side(tab + 1, rule) || rule->n >= target.n) {
+        rule_free(rule);
+        rule_free(&target);
+        return false;
+    }
+
+    table_add(db->targets, line, (int32_t) db->n++);
+    if (target.n > db->max_len) {
+        db->max_len = target.n;
+    }
+    rule_free(&target);
+    return true;
+}
+
+/*
+ * Function: rewrite_load
+ * ----------------------
+ *  reads rewrite database, checking every command against code tables
+ *
+ *  path: database path
+ *
+ *  returns: pointer to allocated database
+ *           NULL if file can't be read or isn't valid database
+ */
+rewrite_db_t *rewrite_load(const char *path)
+{
+    FILE *stream = fopen(path, "r");
+    rewrite_db_t *db;
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t len;
+    bool ok;
+
+    if (!stream) {
+        return NULL;
+    }
+
+    db = calloc(1, sizeof(rewrite_db_t));
+    db->targets = table_new();
+
+    ok = (len = getline(&line, &capacity, stream)) != -1;
+    for (bool header = true; ok; header = false) {
+        if (len > 0 && line[len - 1] == '\n') {
+            line[--len] = '\0';
+        }
+        if (header) {
+            ok = !strcmp(line, REWRITE_HEADER);
+        } else if (len > 0 && line[0] != '#') {
+            ok = parse_rule(db, line);
+        }
+        if (ok && (len = getline(&line, &capacity, stream)) == -1) {
+            break;
+        }
+    }
+
+    free(line);
+    fclose(stream);
+
+    if (!ok) {
+        rewrite_del(db);
+        return NULL;
+    }
+    return db;
+}
+
+/*
+ * Function: rewrite_del
+ * ---------------------
+ *  frees memory allocated by database
+ *
+ *  db: database to be deleted
+ */
+void rewrite_del(rewrite_db_t *db)
+{
+    for (size_t i = 0; i < db->n; i++) {
+        rule_free(&db->rules[i]);
+    }
+    free(db->rules);
+    table_del(db->targets);
+    free(db);
+}
+
+/*
+ * Function: rewrite_key
+ * ---------------------
+ *  writes text of C command the way the database spells it
+ *
+ *  buffer: buffer of MAXLINE characters
+ *  command: C command
+ *
+ *  returns: false if command jumps (it can't be rewritten)
+ */
+bool rewrite_key(char *buffer, const asm_command_t *command)
+{
+    if (command->type != C_COMMAND || command->jump || !command->comp
+            || !valid_comp(command->comp)
+            || (command->dest && !valid_dest(command->dest))) {
+        return false;
+    }
+
+    /* 'dest' letters may come in any order, database spells them one way */
+    if (command->dest) {
+        sprintf(buffer, "%s=%s",
+                dest_mnemonic(encode_dest(command->dest)), command->comp);
+    } else {
+        strcpy(buffer, command->comp);
+    }
+    return true;
+}
+
+/*
+ * Function: rewrite_pass
+ * ----------------------
+ *  replaces targets found in a single scan over the commands
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n_ptr: amount of commands, updated
+ *  db: rewrite database
+ *
+ *  returns: amount of replaced sequences
+ */
+static size_t rewrite_pass(asm_command_t **commands, size_t *n_ptr,
+        const rewrite_db_t *db)
+{
+    char key[REWRITE_MAX_COMMANDS * REWRITE_KEY_MAX];
+    size_t ends[REWRITE_MAX_COMMANDS + 1];
+    char command_key[MAXLINE];
+    size_t n = *n_ptr, out = 0, i = 0, run, k, rewritten = 0;
+    const rewrite_rule_t *rule;
+    asm_command_t *command;
+    const char *file;
+    int32_t found = -1;
+    size_t line;
+    char end;
+
+    while (i < n) {
+        /* keys of the rewritable run starting here, joined with spaces */
+        ends[0] = 0;
+        for (run = 0; run < db->max_len && i + run < n
+                && rewrite_key(command_key, commands[i + run]); run++) {
+            sprintf(key + ends[run], run ? " %s" : "%s", command_key);
+            ends[run + 1] = ends[run] + strlen(key + ends[run]);
+        }
+
+        for (k = run; k > 0; k--) {
+            end = key[ends[k]];
+            key[ends[k]] = '\0';
+            found = table_get(db->targets, key);
+            key[ends[k]] = end;
+            if (found >= 0) {
+                break;
+            }
+        }
+
+        if (k == 0) {
+            commands[out++] = commands[i++];
+            continue;
+        }
+
+        /* replacement is shorter, so it never overwrites unread commands */
+        rule = &db->rules[found];
+        line = commands[i]->line;
+        file = commands[i]->file;
+        for (size_t j = 0; j < k; j++) {
+            command_del(commands[i + j]);
+        }
+        for (size_t j = 0; j < rule->n; j++) {
+            command = command_new_from(C_COMMAND, NULL,
+                    rule->dest[j] ? strdup(rule->dest[j]) : NULL,
+                    strdup(rule->comp[j]), NULL, line);
+            command->file = file;
+            commands[out++] = command;
+        }
+        i += k;
+        rewritten++;
+    }
+
+    *n_ptr = out;
+    return rewritten;
+}
+
+/*
+ * Function: rewrite_apply
+ * -----------------------
+ *  replaces sequences of C commands found in the database, the longest
+ *  target starting at every command wins
+ *
+ *  removed commands are freed; labels are kept, so their addresses have to
+ *  be resolved again afterwards
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n: amount of commands
+ *  db: rewrite database
+ *  rewritten_ptr: amount of replaced sequences
+ *
+ *  returns: amount of commands left
+ */
+size_t rewrite_apply(asm_command_t **commands, size_t n,
+        const rewrite_db_t *db, size_t *rewritten_ptr)
+{
+    size_t rewritten;
+
+    *rewritten_ptr = 0;
+    if (db->n == 0) {
+        return n;
+    }
+
+    /* replacements may complete new targets with their neighbours, every
+       pass shrinks the program, so it stops */
+    do {
+        rewritten = rewrite_pass(commands, &n, db);
+        *rewritten_ptr += rewritten;
+    } while (rewritten > 0);
+
+    return n;
+}
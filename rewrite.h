@@ -0,0 +1,102 @@
+/*
+ * File: rewrite.h
+ * ---------------
+ *  types, constants and function declarations for rewrite module
+ *
+ *  rewrite database maps sequences of C commands onto shorter sequences
+ *  leaving A, D and memory in the same state (found by HackSuperopt),
+ *  the assembler replaces every occurrence of such sequence in the
+ *  program
+ *
+ *  database is a text file starting with REWRITE_HEADER line, followed
+ *  by one rule per line:
+ *
+ *      target<TAB>replacement
+ *
+ *  where both sides are commands in 'dest=comp' form separated by single
+ *  spaces, replacement is shorter than its target (and may be empty);
+ *  'dest' of target is spelled in canonical order (M, D, MD, A, AM, AD,
+ *  AMD); lines starting with '#' are comments
+ *
+ *  sequences never hold jumps and are never split by labels, so control
+ *  can neither enter nor leave them in the middle
+ */
+
+#ifndef HACK_ASM_REWRITE_H
+#define HACK_ASM_REWRITE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parser.h"
+#include "table.h"
+
+#define REWRITE_HEADER "# hack rewrite database 1"
+#define REWRITE_MAX_COMMANDS 8 /* longest target sequence */
+
+typedef struct {
+    char *dest[REWRITE_MAX_COMMANDS]; /* replacement commands */
+    char *comp[REWRITE_MAX_COMMANDS];
+    size_t n;
+} rewrite_rule_t;
+
+typedef struct {
+    table_t *targets;      /* target text -> index of its rule */
+    rewrite_rule_t *rules;
+    size_t n;
+    size_t max_len;        /* commands of the longest target */
+} rewrite_db_t;
+
+/*
+ * Function: rewrite_load
+ * ----------------------
+ *  reads rewrite database, checking every command against code tables
+ *
+ *  path: database path
+ *
+ *  returns: pointer to allocated database
+ *           NULL if file can't be read or isn't valid database
+ */
+rewrite_db_t *rewrite_load(const char *path);
+
+/*
+ * Function: rewrite_del
+ * ---------------------
+ *  frees memory allocated by database
+ *
+ *  db: database to be deleted
+ */
+void rewrite_del(rewrite_db_t *db);
+
+/*
+ * Function: rewrite_key
+ * ---------------------
+ *  writes text of C command the way the database spells it
+ *
+ *  buffer: buffer of MAXLINE characters
+ *  command: C command
+ *
+ *  returns: false if command jumps (it can't be rewritten)
+ */
+bool rewrite_key(char *buffer, const asm_command_t *command);
+
+/*
+ * Function: rewrite_apply
+ * -----------------------
+ *  replaces sequences of C commands found in the database, the longest
+ *  target starting at every command wins
+ *
+ *  removed commands are freed; labels are kept, so their addresses have to
+ *  be resolved again afterwards
+ *
+ *  commands: list of parsed commands (compacted in place)
+ *  n: amount of commands
+ *  db: rewrite database
+ *  rewritten_ptr: amount of replaced sequences
+ *
+ *  returns: amount of commands left
+ */
+size_t rewrite_apply(asm_command_t **commands, size_t n,
+        const rewrite_db_t *db, size_t *rewritten_ptr);
+
+#endif // !HACK_ASM_REWRITE_H
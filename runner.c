@@ -0,0 +1,398 @@
+/*
+ * File: runner.c
+ * --------------
+ *  entry point for hack test runner program
+ *
+ *  runs test specifications on all cores and writes JUnit or JSON report
+ *
+ *  tests are split into one contiguous shard per worker thread; worker which
+ *  drains its own shard steals pending tests from the other shards
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cpu.h"
+#include "helpers.h"
+#include "spec.h"
+
+#define JUNIT_SUFFIX ".xml"
+#define JSON_SUFFIX ".json"
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t head; /* next test to be stolen */
+    size_t tail; /* one past next test to be run by owner */
+} runner_shard_t;
+
+typedef struct {
+    size_t id;
+    size_t workers_n;
+    runner_shard_t *shards;
+    const spec_t *specs;
+    spec_result_t *results;
+} runner_worker_t;
+
+/*
+ * Function: write_help_msg
+ * ------------------------
+ *  writes help message for HackRunner user
+ */
+static void write_help_msg(void)
+{
+    printf("\nUsage: HackRunner [-j threads] [-r report] spec...\n\n"
+           "Run test specifications against assembled programs.\n\n"
+           "Arguments:\n"
+           "spec(required)\t\ttest specification file path\n"
+           "-j threads\t\tamount of worker threads (default: all cores)\n"
+           "-r report\t\treport file path (.xml for JUnit, .json for JSON)\n\n");
+}
+
+/*
+ * Function: shard_pop
+ * -------------------
+ *  takes test from the end of the shard (owner side)
+ *
+ *  shard: worker's own shard
+ *  index_ptr: taken test index
+ *
+ *  returns: true if test was taken
+ *           false if shard is empty
+ */
+static bool shard_pop(runner_shard_t *shard, size_t *index_ptr)
+{
+    bool taken = false;
+
+    pthread_mutex_lock(&shard->lock);
+    if (shard->head < shard->tail) {
+        *index_ptr = --shard->tail;
+        taken = true;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return taken;
+}
+
+/*
+ * Function: shard_steal
+ * ---------------------
+ *  takes test from the beginning of the shard (thief side)
+ *
+ *  shard: other worker's shard
+ *  index_ptr: taken test index
+ *
+ *  returns: true if test was taken
+ *           false if shard is empty
+ */
+static bool shard_steal(runner_shard_t *shard, size_t *index_ptr)
+{
+    bool taken = false;
+
+    pthread_mutex_lock(&shard->lock);
+    if (shard->head < shard->tail) {
+        *index_ptr = shard->head++;
+        taken = true;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return taken;
+}
+
+/*
+ * Function: next_test
+ * -------------------
+ *  finds next test for worker, stealing when own shard is drained
+ *
+ *  worker: worker looking for work
+ *  index_ptr: found test index
+ *
+ *  returns: true if test was found
+ *           false if all shards are empty
+ */
+static bool next_test(runner_worker_t *worker, size_t *index_ptr)
+{
+    size_t victim;
+
+    if (shard_pop(&worker->shards[worker->id], index_ptr)) {
+        return true;
+    }
+
+    /* no test is ever added, so one empty sweep means all work is taken */
+    for (size_t i = 1; i < worker->workers_n; i++) {
+        victim = (worker->id + i) % worker->workers_n;
+        if (shard_steal(&worker->shards[victim], index_ptr)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Function: work
+ * --------------
+ *  worker thread routine, runs tests until none are left
+ *
+ *  arg: worker state (runner_worker_t)
+ *
+ *  returns: NULL
+ */
+static void *work(void *arg)
+{
+    runner_worker_t *worker = arg;
+    cpu_t *cpu = cpu_new();
+    size_t i;
+
+    while (next_test(worker, &i)) {
+        spec_run(&worker->specs[i], cpu, &worker->results[i]);
+    }
+
+    cpu_del(cpu);
+    return NULL;
+}
+
+/*
+ * Function: run_tests
+ * -------------------
+ *  runs every test on the pool of worker threads
+ *
+ *  specs: list of tests
+ *  results: outcome for every test
+ *  n: amount of tests
+ *  workers_n: amount of worker threads
+ */
+static void run_tests(const spec_t *specs, spec_result_t *results,
+        size_t n, size_t workers_n)
+{
+    runner_shard_t *shards = malloc(workers_n * sizeof(runner_shard_t));
+    runner_worker_t *workers = malloc(workers_n * sizeof(runner_worker_t));
+    pthread_t *threads = malloc(workers_n * sizeof(pthread_t));
+    size_t i;
+
+    for (i = 0; i < workers_n; i++) {
+        pthread_mutex_init(&shards[i].lock, NULL);
+        shards[i].head = n * i / workers_n;
+        shards[i].tail = n * (i + 1) / workers_n;
+
+        workers[i].id = i;
+        workers[i].workers_n = workers_n;
+        workers[i].shards = shards;
+        workers[i].specs = specs;
+        workers[i].results = results;
+    }
+
+    for (i = 0; i < workers_n; i++) {
+        pthread_create(&threads[i], NULL, work, &workers[i]);
+    }
+    for (i = 0; i < workers_n; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* cleanup */
+    for (i = 0; i < workers_n; i++) {
+        pthread_mutex_destroy(&shards[i].lock);
+    }
+    free(shards);
+    free(workers);
+    free(threads);
+}
+
+/*
+ * Function: write_escaped
+ * -----------------------
+ *  writes string escaped for JSON or XML text
+ *
+ *  stream: writable stream
+ *  s: string to write
+ *  xml: true for XML escaping, false for JSON one
+ */
+static void write_escaped(FILE *stream, const char *s, bool xml)
+{
+    for (const char *p = s; *p; p++) {
+        if (xml && *p == '&') {
+            fputs("&amp;", stream);
+        } else if (xml && *p == '<') {
+            fputs("&lt;", stream);
+        } else if (xml && *p == '>') {
+            fputs("&gt;", stream);
+        } else if (xml && *p == '"') {
+            fputs("&quot;", stream);
+        } else if (!xml && (*p == '"' || *p == '\\')) {
+            fprintf(stream, "\\%c", *p);
+        } else if (!xml && (unsigned char) *p < 0x20) {
+            fprintf(stream, "\\u%04x", *p);
+        } else {
+            fputc(*p, stream);
+        }
+    }
+}
+
+/*
+ * Function: write_junit
+ * ---------------------
+ *  writes JUnit XML report
+ *
+ *  stream: writable stream
+ *  specs: list of tests
+ *  results: outcome for every test
+ *  n: amount of tests
+ *  seconds: total run time
+ */
+static void write_junit(FILE *stream, const spec_t *specs,
+        const spec_result_t *results, size_t n, double seconds)
+{
+    size_t failures = 0, errors = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        failures += results[i].status == SPEC_FAIL;
+        errors += results[i].status == SPEC_ERROR;
+    }
+
+    fprintf(stream, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<testsuite name=\"HackRunner\" tests=\"%zu\" failures=\"%zu\" "
+            "errors=\"%zu\" time=\"%.6f\">\n", n, failures, errors, seconds);
+
+    for (size_t i = 0; i < n; i++) {
+        fprintf(stream, "  <testcase classname=\"");
+        write_escaped(stream, specs[i].file, true);
+        fprintf(stream, "\" name=\"");
+        write_escaped(stream, specs[i].name, true);
+        fprintf(stream, "\" time=\"%.6f\"", results[i].seconds);
+
+        if (results[i].status == SPEC_PASS) {
+            fprintf(stream, "/>\n");
+            continue;
+        }
+
+        fprintf(stream, ">\n    <%s message=\"",
+                results[i].status == SPEC_FAIL ? "failure" : "error");
+        write_escaped(stream, results[i].message, true);
+        fprintf(stream, "\"/>\n  </testcase>\n");
+    }
+
+    fprintf(stream, "</testsuite>\n");
+}
+
+/*
+ * Function: write_json
+ * --------------------
+ *  writes JSON report
+ *
+ *  stream: writable stream
+ *  specs: list of tests
+ *  results: outcome for every test
+ *  n: amount of tests
+ *  seconds: total run time
+ */
+static void write_json(FILE *stream, const spec_t *specs,
+        const spec_result_t *results, size_t n, double seconds)
+{
+    static const char *statuses[] = {
+        [SPEC_PASS] = "pass",
+        [SPEC_FAIL] = "fail",
+        [SPEC_ERROR] = "error"
+    };
+
+    fprintf(stream, "{\n  \"tests\": %zu,\n  \"time\": %.6f,\n"
+            "  \"results\": [", n, seconds);
+
+    for (size_t i = 0; i < n; i++) {
+        fprintf(stream, "%s\n    {\"file\": \"", i ? "," : "");
+        write_escaped(stream, specs[i].file, false);
+        fprintf(stream, "\", \"name\": \"");
+        write_escaped(stream, specs[i].name, false);
+        fprintf(stream, "\", \"status\": \"%s\", \"cycles\": %llu, "
+                "\"time\": %.6f, \"message\": \"",
+                statuses[results[i].status],
+                (unsigned long long) results[i].cycles, results[i].seconds);
+        write_escaped(stream, results[i].message, false);
+        fprintf(stream, "\"}");
+    }
+
+    fprintf(stream, "\n  ]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+    spec_t *specs = NULL;
+    spec_result_t *results;
+    size_t n = 0, failed = 0;
+    long workers_n = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *report = NULL;
+    bool valid = true, has_specs = false;
+    double start, seconds;
+    FILE *report_stream;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc && str_isnum(argv[i + 1])
+                && atol(argv[i + 1]) > 0) {
+            workers_n = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc
+                && (str_ends_with(argv[i + 1], JUNIT_SUFFIX)
+                    || str_ends_with(argv[i + 1], JSON_SUFFIX))) {
+            report = argv[++i];
+        } else if (argv[i][0] != '-') {
+            valid = spec_read(argv[i], &specs, &n) && valid;
+            has_specs = true;
+        } else {
+            write_help_msg();
+            exit(1);
+        }
+    }
+
+    if (!has_specs) {
+        write_help_msg();
+        exit(1);
+    }
+    if (!valid) {
+        spec_del(specs, n);
+        exit(1);
+    }
+    if (workers_n < 1) {
+        workers_n = 1;
+    }
+    if ((size_t) workers_n > n && n > 0) {
+        workers_n = n;
+    }
+
+    results = calloc(n ? n : 1, sizeof(spec_result_t));
+
+    start = clock_seconds();
+    run_tests(specs, results, n, workers_n);
+    seconds = clock_seconds() - start;
+
+    for (size_t i = 0; i < n; i++) {
+        if (results[i].status != SPEC_PASS) {
+            printf("%s %s: %s\n",
+                    results[i].status == SPEC_FAIL ? "FAIL" : "ERROR",
+                    specs[i].name, results[i].message);
+            failed++;
+        }
+    }
+    printf("%zu tests, %zu passed, %zu failed (%.3f s, %ld threads)\n",
+            n, n - failed, failed, seconds, workers_n);
+
+    if (report) {
+        if (!(report_stream = fopen(report, "w"))) {
+            fprintf(stderr, "HackRunner: can't open %s\n", report);
+            exit(1);
+        }
+        if (str_ends_with(report, JUNIT_SUFFIX)) {
+            write_junit(report_stream, specs, results, n, seconds);
+        } else {
+            write_json(report_stream, specs, results, n, seconds);
+        }
+        fclose(report_stream);
+    }
+
+    /* cleanup */
+    spec_del(specs, n);
+    free(results);
+
+    return failed ? 1 : 0;
+}
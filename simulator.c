@@ -0,0 +1,197 @@
+/*
+ * File: simulator.c
+ * -----------------
+ *  entry point for hack simulator program
+ *
+ *  loads binary hack encodings, runs them on simulated Hack computer and
+ *  dumps the beginning of RAM
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "helpers.h"
+
+#define SIM_DEFAULT_DUMP 16
+#define SIM_CHUNK_CYCLES 100000000
+
+/*
+ * Function: write_help_msg
+ * ------------------------
+ *  writes help message for HackSimulator user
+ */
+static void write_help_msg(void)
+{
+    printf("\nUsage: HackSimulator [-n cycles] [-d words] "
+           "[-s address=value]... [-p profile [-i interval]] program\n\n"
+           "Run assembled HACK program.\n\n"
+           "Arguments:\n"
+           "program(required)\tprogram file path (must have .hack suffix)\n"
+           "-n cycles\t\tstop after given amount of instructions\n"
+           "\t\t\t(default: run until program halts)\n"
+           "-d words\t\tamount of RAM words to dump (default: 16)\n"
+           "-s address=value\tstore value in RAM before the run\n"
+           "-p profile\t\twrite 'address cycles' program counter profile\n"
+           "-i interval\t\tsample program counter every given amount of\n"
+           "\t\t\tinstructions (default: 1, exact profile)\n\n");
+}
+
+/*
+ * Function: write_profile
+ * -----------------------
+ *  writes program counter profile, one 'address cycles' line per address
+ *
+ *  path: profile file path
+ *  samples: cycles spent at every ROM address
+ */
+static void write_profile(const char *path, const uint64_t *samples)
+{
+    FILE *stream;
+
+    if (!(stream = fopen(path, "w"))) {
+        fprintf(stderr, "HackSimulator: can't open %s\n", path);
+        exit(1);
+    }
+
+    for (size_t i = 0; i <= CPU_ROM_SIZE; i++) {
+        if (samples[i]) {
+            fprintf(stream, "%zu %llu\n", i, (unsigned long long) samples[i]);
+        }
+    }
+
+    fclose(stream);
+}
+
+/*
+ * Function: parse_store
+ * ---------------------
+ *  parses 'address=value' RAM initializer
+ *
+ *  arg: CLI argument
+ *  address_ptr: parsed RAM address
+ *  value_ptr: parsed value
+ *
+ *  returns: true if argument is valid
+ *           false otherwise
+ */
+static bool parse_store(const char *arg, long *address_ptr, long *value_ptr)
+{
+    char *end;
+
+    *address_ptr = strtol(arg, &end, 10);
+    if (end == arg || *end != '=' || *address_ptr < 0
+            || *address_ptr >= CPU_RAM_SIZE) {
+        return false;
+    }
+
+    arg = end + 1;
+    *value_ptr = strtol(arg, &end, 10);
+    return end != arg && !*end && *value_ptr >= -32768 && *value_ptr <= 65535;
+}
+
+int main(int argc, char **argv)
+{
+    char *source = NULL, *profile = NULL;
+    FILE *input_stream;
+    uint16_t *words;
+    long n;
+    long dump = SIM_DEFAULT_DUMP;
+    long address, value;
+    uint64_t max_cycles = 0, cycles, chunk, interval = 1;
+    uint64_t *samples = NULL;
+    uint16_t pc;
+    double start, elapsed;
+    cpu_t *cpu;
+
+    cpu = cpu_new();
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc && str_isnum(argv[i + 1])) {
+            max_cycles = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-d") && i + 1 < argc
+                && str_isnum(argv[i + 1])) {
+            dump = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc
+                && parse_store(argv[i + 1], &address, &value)) {
+            cpu->ram[address] = (uint16_t) value;
+            i++;
+        } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            profile = argv[++i];
+        } else if (!strcmp(argv[i], "-i") && i + 1 < argc
+                && str_isnum(argv[i + 1]) && atol(argv[i + 1]) > 0) {
+            interval = strtoull(argv[++i], NULL, 10);
+        } else if (!source && str_ends_with(argv[i], OUTPUT_SUFFIX)) {
+            source = argv[i];
+        } else {
+            write_help_msg();
+            exit(1);
+        }
+    }
+
+    if (!source || dump > CPU_RAM_SIZE) {
+        write_help_msg();
+        exit(1);
+    }
+
+    if (!(input_stream = fopen(source, "r"))) {
+        fprintf(stderr, "HackSimulator: can't open %s\n", source);
+        exit(1);
+    }
+
+    words = malloc(CPU_ROM_SIZE * sizeof(uint16_t));
+    n = cpu_read_hack(input_stream, words);
+    fclose(input_stream);
+
+    if (n < 0) {
+        fprintf(stderr, "HackSimulator: %s is not a valid program\n", source);
+        exit(1);
+    }
+
+    cpu_load(cpu, words, n);
+
+    if (profile) {
+        samples = calloc(CPU_ROM_SIZE + 1, sizeof(uint64_t));
+    }
+
+    /* run in chunks so unlimited runs don't need a special budget;
+     * when profiling, chunk is charged to the address it started at */
+    start = clock_seconds();
+    do {
+        chunk = profile ? interval : SIM_CHUNK_CYCLES;
+        if (max_cycles && max_cycles - cpu->cycles < chunk) {
+            chunk = max_cycles - cpu->cycles;
+        }
+        pc = cpu->pc;
+        cycles = cpu_run(cpu, chunk);
+        if (samples) {
+            samples[pc] += cycles;
+        }
+    } while (!cpu->halted && cycles == chunk
+            && (!max_cycles || cpu->cycles < max_cycles));
+    elapsed = clock_seconds() - start;
+
+    for (long i = 0; i < dump; i++) {
+        printf("RAM[%ld] = %d\n", i, (int16_t) cpu->ram[i]);
+    }
+
+    fprintf(stderr, "%s after %llu cycles (%.3f s, %.1f M instructions/s)\n",
+            cpu->halted ? "halted" : "stopped",
+            (unsigned long long) cpu->cycles, elapsed,
+            elapsed > 0 ? cpu->cycles / elapsed / 1e6 : 0.0);
+
+    if (profile) {
+        write_profile(profile, samples);
+    }
+
+    /* cleanup */
+    cpu_del(cpu);
+    free(words);
+    free(samples);
+
+    return 0;
+}
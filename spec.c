@@ -0,0 +1,294 @@
+/*
+ * File: spec.c
+ * ------------
+ *  reads test specifications and runs them against simulated Hack computer
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "helpers.h"
+#include "spec.h"
+
+#define SPEC_LINE_MAX 512
+
+/*
+ * Function: parse_number
+ * ----------------------
+ *  parses decimal integer token and checks its range
+ *
+ *  token: string to parse (can be NULL)
+ *  min: smallest accepted value
+ *  max: largest accepted value
+ *  value_ptr: parsed value
+ *
+ *  returns: true if token is a number in range
+ *           false otherwise
+ */
+static bool parse_number(const char *token, long long min, long long max,
+        long long *value_ptr)
+{
+    char *end;
+
+    if (!token) {
+        return false;
+    }
+
+    *value_ptr = strtoll(token, &end, 10);
+    return end != token && !*end && *value_ptr >= min && *value_ptr <= max;
+}
+
+/*
+ * Function: parse_cell
+ * --------------------
+ *  parses 'address value' pair of tokens and appends it to the list
+ *
+ *  cells_ptr: growable list of RAM cells
+ *  n_ptr: amount of cells in the list
+ *
+ *  returns: true if both tokens are valid
+ *           false otherwise
+ */
+static bool parse_cell(spec_cell_t **cells_ptr, size_t *n_ptr)
+{
+    long long address, value;
+
+    if (!parse_number(strtok(NULL, " \t"), 0, CPU_RAM_SIZE - 1, &address)
+            || !parse_number(strtok(NULL, " \t"), -32768, 65535, &value)) {
+        return false;
+    }
+
+    *cells_ptr = realloc(*cells_ptr, (*n_ptr + 1) * sizeof(spec_cell_t));
+    (*cells_ptr)[*n_ptr].address = address;
+    (*cells_ptr)[*n_ptr].value = (uint16_t) value;
+    *n_ptr += 1;
+    return true;
+}
+
+/*
+ * Function: spec_read
+ * -------------------
+ *  reads all tests from spec file and appends them to the list
+ *
+ *  syntax errors are reported to stderr as 'file:line: message'
+ *
+ *  path: spec file path
+ *  specs_ptr: growable list of tests (NULL for empty one)
+ *  n_ptr: amount of tests in the list
+ *
+ *  returns: true if the file is valid
+ *           false otherwise
+ */
+bool spec_read(const char *path, spec_t **specs_ptr, size_t *n_ptr)
+{
+    char line[SPEC_LINE_MAX];
+    char *directive, *arg;
+    long long value;
+    size_t ln = 0;
+    spec_t *spec = NULL; /* currently open test */
+    const char *error = NULL;
+    FILE *stream;
+
+    if (!(stream = fopen(path, "r"))) {
+        fprintf(stderr, "%s: can't open\n", path);
+        return false;
+    }
+
+    while (!error && fgets(line, sizeof(line), stream)) {
+        ln++;
+        line[strcspn(line, "\r\n#")] = '\0';
+
+        if (!(directive = strtok(line, " \t"))) {
+            continue;
+        }
+
+        if (!strcmp(directive, "test")) {
+            if (spec) {
+                error = "previous test is not closed with 'end'";
+            } else if (!(arg = strtok(NULL, " \t"))) {
+                error = "test name expected";
+            } else {
+                *specs_ptr = realloc(*specs_ptr,
+                        (*n_ptr + 1) * sizeof(spec_t));
+                spec = &(*specs_ptr)[*n_ptr];
+                *n_ptr += 1;
+
+                memset(spec, 0, sizeof(spec_t));
+                spec->name = strdup(arg);
+                spec->file = strdup(path);
+                spec->cycles = SPEC_DEFAULT_CYCLES;
+            }
+        } else if (!spec) {
+            error = "directive outside of test";
+        } else if (!strcmp(directive, "source")) {
+            if (!(arg = strtok(NULL, " \t"))) {
+                error = "source path expected";
+            } else {
+                free(spec->source);
+                spec->source = join_path(path, arg);
+            }
+        } else if (!strcmp(directive, "set")) {
+            if (!parse_cell(&spec->init, &spec->init_n)) {
+                error = "'set address value' expected";
+            }
+        } else if (!strcmp(directive, "expect")) {
+            if (!parse_cell(&spec->expect, &spec->expect_n)) {
+                error = "'expect address value' expected";
+            }
+        } else if (!strcmp(directive, "cycles")) {
+            if (!parse_number(strtok(NULL, " \t"), 1, INT64_MAX, &value)) {
+                error = "positive cycle budget expected";
+            } else {
+                spec->cycles = value;
+            }
+        } else if (!strcmp(directive, "halt")) {
+            spec->halt = true;
+        } else if (!strcmp(directive, "end")) {
+            if (!spec->source) {
+                error = "test has no source";
+            }
+            spec = NULL;
+        } else {
+            error = "unknown directive";
+        }
+    }
+
+    if (!error && spec) {
+        error = "last test is not closed with 'end'";
+    }
+    if (error) {
+        fprintf(stderr, "%s:%zu: %s\n", path, ln, error);
+    }
+
+    fclose(stream);
+    return !error;
+}
+
+/*
+ * Function: spec_del
+ * ------------------
+ *  frees memory allocated by list of tests
+ *
+ *  specs: list of tests
+ *  n: amount of tests
+ */
+void spec_del(spec_t *specs, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        free(specs[i].name);
+        free(specs[i].file);
+        free(specs[i].source);
+        free(specs[i].init);
+        free(specs[i].expect);
+    }
+
+    free(specs);
+}
+
+/*
+ * Function: assemble_source
+ * -------------------------
+ *  assembles source file in memory
+ *
+ *  source: assembler source path
+ *  words: buffer for at least CPU_ROM_SIZE words
+ *
+ *  returns: amount of assembled words
+ *           -1 if source can't be read or has any error (reported to
+ *           stderr by the assembler)
+ */
+static long assemble_source(const char *source, uint16_t *words)
+{
+    FILE *input_stream, *output_stream;
+    char *text;
+    size_t text_len;
+    long n;
+    bool ok;
+    asm_options_t options = { 0 };
+
+    if (!(input_stream = fopen(source, "r"))) {
+        return -1;
+    }
+    options.source = source; /* includes are relative to the source */
+
+    output_stream = open_memstream(&text, &text_len);
+    ok = assemble(input_stream, output_stream, &options);
+    fclose(input_stream);
+    fclose(output_stream);
+
+    if (!ok) {
+        n = -1;
+    } else if (text_len == 0) {
+        n = 0;
+    } else {
+        input_stream = fmemopen(text, text_len, "r");
+        n = cpu_read_hack(input_stream, words);
+        fclose(input_stream);
+    }
+
+    free(text);
+    return n;
+}
+
+/*
+ * Function: spec_run
+ * ------------------
+ *  assembles test source, runs it and checks expected RAM values
+ *
+ *  spec: test to run
+ *  cpu: cpu to run the test on (its whole state is overwritten)
+ *  result: test outcome
+ */
+void spec_run(const spec_t *spec, cpu_t *cpu, spec_result_t *result)
+{
+    uint16_t words[CPU_ROM_SIZE];
+    double start = clock_seconds();
+    long n;
+    size_t i;
+    const spec_cell_t *cell;
+
+    result->status = SPEC_PASS;
+    result->cycles = 0;
+    result->message[0] = '\0';
+
+    if ((n = assemble_source(spec->source, words)) < 0) {
+        result->status = SPEC_ERROR;
+        snprintf(result->message, SPEC_MESSAGE_MAX,
+                "can't assemble %s", spec->source);
+        result->seconds = clock_seconds() - start;
+        return;
+    }
+
+    memset(cpu->ram, 0, sizeof(cpu->ram));
+    for (i = 0; i < spec->init_n; i++) {
+        cpu->ram[spec->init[i].address] = spec->init[i].value;
+    }
+
+    cpu_load(cpu, words, n);
+    result->cycles = cpu_run(cpu, spec->cycles);
+
+    if (spec->halt && !cpu->halted) {
+        result->status = SPEC_FAIL;
+        snprintf(result->message, SPEC_MESSAGE_MAX,
+                "program didn't halt within %llu cycles",
+                (unsigned long long) spec->cycles);
+    }
+
+    /* report only the first mismatch */
+    for (i = 0; result->status == SPEC_PASS && i < spec->expect_n; i++) {
+        cell = &spec->expect[i];
+        if (cpu->ram[cell->address] != cell->value) {
+            result->status = SPEC_FAIL;
+            snprintf(result->message, SPEC_MESSAGE_MAX,
+                    "RAM[%u] = %d, expected %d", cell->address,
+                    (int16_t) cpu->ram[cell->address], (int16_t) cell->value);
+        }
+    }
+
+    result->seconds = clock_seconds() - start;
+}
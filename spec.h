@@ -0,0 +1,98 @@
+/*
+ * File: spec.h
+ * ------------
+ *  types, constants and function declarations for spec module
+ *
+ *  reads test specifications and runs them against simulated Hack computer
+ *
+ *  spec file holds any amount of tests, one directive per line:
+ *
+ *      # comment
+ *      test Mult        starts new test with given name
+ *      source Mult.asm  assembler source (relative to spec file)
+ *      set 0 7          RAM[0] = 7 before the run
+ *      cycles 1000      cycle budget
+ *      expect 2 84      RAM[2] must be 84 after the run
+ *      halt             program must halt within cycle budget
+ *      end              closes the test
+ */
+
+#ifndef HACK_ASM_SPEC_H
+#define HACK_ASM_SPEC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+#define SPEC_DEFAULT_CYCLES 1000000
+#define SPEC_MESSAGE_MAX 256
+
+typedef struct {
+    uint16_t address;
+    uint16_t value;
+} spec_cell_t;
+
+typedef struct {
+    char *name;
+    char *file;          /* spec file the test came from */
+    char *source;        /* assembler source path */
+    spec_cell_t *init;   /* RAM state before the run */
+    size_t init_n;
+    spec_cell_t *expect; /* RAM state after the run */
+    size_t expect_n;
+    uint64_t cycles;     /* cycle budget */
+    bool halt;           /* must halt within budget */
+} spec_t;
+
+typedef enum {
+    SPEC_PASS,
+    SPEC_FAIL,
+    SPEC_ERROR
+} spec_status_t;
+
+typedef struct {
+    spec_status_t status;
+    uint64_t cycles;
+    double seconds;
+    char message[SPEC_MESSAGE_MAX];
+} spec_result_t;
+
+/*
+ * Function: spec_read
+ * -------------------
+ *  reads all tests from spec file and appends them to the list
+ *
+ *  syntax errors are reported to stderr as 'file:line: message'
+ *
+ *  path: spec file path
+ *  specs_ptr: growable list of tests (NULL for empty one)
+ *  n_ptr: amount of tests in the list
+ *
+ *  returns: true if the file is valid
+ *           false otherwise
+ */
+bool spec_read(const char *path, spec_t **specs_ptr, size_t *n_ptr);
+
+/*
+ * Function: spec_del
+ * ------------------
+ *  frees memory allocated by list of tests
+ *
+ *  specs: list of tests
+ *  n: amount of tests
+ */
+void spec_del(spec_t *specs, size_t n);
+
+/*
+ * Function: spec_run
+ * ------------------
+ *  assembles test source, runs it and checks expected RAM values
+ *
+ *  spec: test to run
+ *  cpu: cpu to run the test on (its whole state is overwritten)
+ *  result: test outcome
+ */
+void spec_run(const spec_t *spec, cpu_t *cpu, spec_result_t *result);
+
+#endif // !HACK_ASM_SPEC_H
@@ -0,0 +1,916 @@
+/*
+ * File: superopt.c
+ * ----------------
+ *  entry point for hack superoptimizer program
+ *
+ *  collects jump-free sequences of C commands from assembler sources and
+ *  searches every shorter sequence of C commands for one leaving A, D and
+ *  memory in the same state, writing the shortest found into rewrite
+ *  database for 'HackAssembler -R'
+ *
+ *  candidates are enumerated exhaustively, threads split them by their
+ *  first command; every candidate is run on a few fixed probe states and
+ *  the fingerprint of results is looked up among targets, matches are then
+ *  checked on thousands of random and edge states (equivalence is tested,
+ *  not proven); the first candidate in enumeration order wins, so the
+ *  database doesn't depend on the amount of threads
+ *
+ *  memory is assumed to change only through the commands themselves,
+ *  which doesn't hold for the keyboard register
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "code.h"
+#include "cpu.h"
+#include "ctable.h"
+#include "parser.h"
+#include "rewrite.h"
+#include "table.h"
+
+#define SUPEROPT_WINDOW 3      /* default longest target */
+#define SUPEROPT_LENGTH 2      /* default longest candidate */
+#define SUPEROPT_MAX_LENGTH 3  /* 196^4 candidates would take hours */
+#define SUPEROPT_PROBES 8      /* states fingerprinting every sequence */
+#define SUPEROPT_CHECKS 4096   /* states fingerprint matches must agree on */
+#define SUPEROPT_MAX_THREADS 64
+#define SUPEROPT_MAX_OPS (28 * 7) /* every 'comp' with every 'dest' */
+#define SUPEROPT_SEED 0x5EED5EED5EED5EEDULL
+
+typedef struct {
+    uint8_t comp; /* 7 bit 'comp' encoding */
+    uint8_t dest; /* 3 bit 'dest' encoding */
+} superopt_op_t;
+
+typedef enum {
+    MEMORY_HASHED,   /* cells hold hash of their address */
+    MEMORY_IDENTITY, /* cells hold their address */
+    MEMORY_CONSTANT  /* every cell holds the same value */
+} superopt_memory_t;
+
+typedef struct {
+    uint16_t a;
+    uint16_t d;
+    superopt_memory_t memory; /* contents of cells never written */
+    uint64_t seed;            /* hash seed or constant of the memory */
+    uint16_t addresses[REWRITE_MAX_COMMANDS]; /* distinct written cells */
+    uint16_t values[REWRITE_MAX_COMMANDS];
+    size_t writes;
+} superopt_state_t;
+
+typedef struct {
+    char *text;        /* database spelling */
+    superopt_op_t ops[REWRITE_MAX_COMMANDS];
+    size_t n;
+    size_t count;      /* occurrences in the sources */
+    uint64_t fingerprint;
+} superopt_target_t;
+
+typedef struct {
+    superopt_target_t *targets;
+    size_t n;
+    size_t *slots;     /* fingerprint hash of target index + 1, 0 is free */
+    size_t mask;
+    superopt_op_t ops[SUPEROPT_MAX_OPS]; /* every candidate command */
+    const char *comps[SUPEROPT_MAX_OPS]; /* 'comp' mnemonics of commands */
+    size_t ops_n;
+    superopt_state_t probes[SUPEROPT_PROBES];
+    superopt_state_t *checks;
+    ctable_t *best;    /* target text -> rank of its best candidate */
+} superopt_t;
+
+typedef struct {
+    superopt_t *superopt;
+    size_t length;       /* commands of every candidate */
+    size_t thread;       /* first commands of this job are thread + k * n */
+    size_t threads_n;
+    size_t indices[SUPEROPT_MAX_LENGTH];
+    superopt_op_t ops[SUPEROPT_MAX_LENGTH];
+    superopt_state_t states[SUPEROPT_MAX_LENGTH + 1][SUPEROPT_PROBES];
+    uint64_t candidates;
+    uint64_t checked;    /* fingerprint matches checked on every state */
+} superopt_job_t;
+
+/*
+ * Function: write_help_msg
+ * ------------------------
+ *  writes help message for HackSuperopt user
+ */
+static void write_help_msg(void)
+{
+    printf("\nUsage: HackSuperopt [-w window] [-l length] [-j threads] "
+           "[-o database]\n"
+           "                    source...\n\n"
+           "Find shorter equivalents of C command sequences of assembler\n"
+           "sources and write them as rewrite database for\n"
+           "HackAssembler -R.\n\n"
+           "Arguments:\n"
+           "source(required)\tassembler source (.asm) to collect sequences\n"
+           "\t\t\tfrom\n"
+           "-w window\t\tlongest sequence (default: %d, at most %d)\n"
+           "-l length\t\tlongest equivalent searched (default: %d, at\n"
+           "\t\t\tmost %d)\n"
+           "-j threads\t\tthreads enumerating equivalents (default:\n"
+           "\t\t\tcores)\n"
+           "-o database\t\twrite database to file instead of stdout\n\n",
+           SUPEROPT_WINDOW, REWRITE_MAX_COMMANDS, SUPEROPT_LENGTH,
+           SUPEROPT_MAX_LENGTH);
+}
+
+/*
+ * Function: now
+ * -------------
+ *  reads monotonic clock
+ *
+ *  returns: seconds since unspecified point
+ */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Function: mix
+ * -------------
+ *  scrambles bits of 64 bit value (splitmix64 finalizer)
+ *
+ *  x: value to scramble
+ *
+ *  returns: scrambled value
+ */
+static uint64_t mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/*
+ * Function: next_random
+ * ---------------------
+ *  advances deterministic random generator
+ *
+ *  seed_ptr: generator state
+ *
+ *  returns: next random value
+ */
+static uint64_t next_random(uint64_t *seed_ptr)
+{
+    *seed_ptr += 0x9E3779B97F4A7C15ULL;
+    return mix(*seed_ptr);
+}
+
+/*
+ * Function: random_state
+ * ----------------------
+ *  draws initial machine state, edge values of registers, equal registers
+ *  and regular memory included
+ *
+ *  state: state to fill
+ *  seed_ptr: generator state
+ */
+static void random_state(superopt_state_t *state, uint64_t *seed_ptr)
+{
+    static const uint16_t edges[] = { 0, 1, 0x7FFF, 0x8000, 0xFFFF };
+    uint64_t r = next_random(seed_ptr);
+
+    state->a = r % 4 == 0 ? edges[(r >> 2) % 5] : next_random(seed_ptr);
+    r = next_random(seed_ptr);
+    state->d = r % 4 == 0 ? edges[(r >> 2) % 5]
+        : r % 4 == 1 ? state->a : next_random(seed_ptr);
+
+    r = next_random(seed_ptr);
+    state->memory = r % 8 < 6 ? MEMORY_HASHED
+        : r % 8 == 6 ? MEMORY_IDENTITY : MEMORY_CONSTANT;
+    state->seed = next_random(seed_ptr);
+    if (state->memory == MEMORY_CONSTANT && r % 16 < 8) {
+        state->seed = r % 16 < 4 ? state->a : state->d;
+    }
+    state->writes = 0;
+}
+
+/*
+ * Function: initial
+ * -----------------
+ *  reads memory cell as it was before any command
+ *
+ *  state: machine state
+ *  address: masked cell address
+ *
+ *  returns: initial value of the cell
+ */
+static uint16_t initial(const superopt_state_t *state, uint16_t address)
+{
+    switch (state->memory) {
+        case MEMORY_HASHED:
+            return mix(state->seed ^ address);
+        case MEMORY_IDENTITY:
+            return address;
+        case MEMORY_CONSTANT:
+            break;
+    }
+    return state->seed;
+}
+
+/*
+ * Function: read_cell
+ * -------------------
+ *  reads memory cell
+ *
+ *  state: machine state
+ *  address: masked cell address
+ *
+ *  returns: current value of the cell
+ */
+static uint16_t read_cell(const superopt_state_t *state, uint16_t address)
+{
+    for (size_t i = 0; i < state->writes; i++) {
+        if (state->addresses[i] == address) {
+            return state->values[i];
+        }
+    }
+    return initial(state, address);
+}
+
+/*
+ * Function: write_cell
+ * --------------------
+ *  writes memory cell
+ *
+ *  state: machine state
+ *  address: masked cell address
+ *  value: value to write
+ */
+static void write_cell(superopt_state_t *state, uint16_t address,
+        uint16_t value)
+{
+    size_t i = 0;
+
+    while (i < state->writes && state->addresses[i] != address) {
+        i++;
+    }
+    if (i == state->writes) {
+        state->addresses[state->writes++] = address;
+    }
+    state->values[i] = value;
+}
+
+/*
+ * Function: comp_value
+ * --------------------
+ *  computes 'comp' the way the CPU does
+ *
+ *  comp: 7 bit 'comp' encoding
+ *  a: A register
+ *  d: D register
+ *  M: memory cell A points to
+ *
+ *  returns: computed value
+ */
+static uint16_t comp_value(uint8_t comp, uint16_t a, uint16_t d, uint16_t M)
+{
+    switch (comp) {
+#define SUPEROPT_COMP(name, code, value) \
+        case code:                        \
+            return (uint16_t) (value);
+        CPU_COMPS(SUPEROPT_COMP)
+#undef SUPEROPT_COMP
+    }
+    return 0;
+}
+
+/*
+ * Function: step
+ * --------------
+ *  executes single command, M is written where A pointed before it
+ *
+ *  state: machine state
+ *  op: command
+ */
+static void step(superopt_state_t *state, superopt_op_t op)
+{
+    uint16_t address = state->a & CPU_ADDRESS_MASK;
+    uint16_t value = comp_value(op.comp, state->a, state->d,
+            op.comp & 0x40 ? read_cell(state, address) : 0);
+
+    if (op.dest & 1) {
+        write_cell(state, address, value);
+    }
+    if (op.dest & 2) {
+        state->d = value;
+    }
+    if (op.dest & 4) {
+        state->a = value;
+    }
+}
+
+/*
+ * Function: run
+ * -------------
+ *  executes sequence of commands
+ *
+ *  state: machine state
+ *  ops: commands
+ *  n: amount of commands
+ */
+static void run(superopt_state_t *state, const superopt_op_t *ops, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        step(state, ops[i]);
+    }
+}
+
+/*
+ * Function: state_hash
+ * --------------------
+ *  hashes registers and changed cells, independently of write order
+ *
+ *  state: machine state
+ *
+ *  returns: hash of the state
+ */
+static uint64_t state_hash(const superopt_state_t *state)
+{
+    uint64_t h = mix(((uint64_t) state->a << 16) | state->d);
+
+    for (size_t i = 0; i < state->writes; i++) {
+        if (state->values[i] != initial(state, state->addresses[i])) {
+            h += mix(((uint64_t) state->addresses[i] << 16
+                        | state->values[i]) + 0x10000000000ULL);
+        }
+    }
+    return h;
+}
+
+/*
+ * Function: same_state
+ * --------------------
+ *  compares states reached from the same initial state
+ *
+ *  x: first state
+ *  y: second state
+ *
+ *  returns: true if registers and every cell are equal
+ */
+static bool same_state(const superopt_state_t *x, const superopt_state_t *y)
+{
+    if (x->a != y->a || x->d != y->d) {
+        return false;
+    }
+    for (size_t i = 0; i < x->writes; i++) {
+        if (read_cell(y, x->addresses[i]) != x->values[i]) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < y->writes; i++) {
+        if (read_cell(x, y->addresses[i]) != y->values[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Function: fingerprint
+ * ---------------------
+ *  combines hashes of probe states after they ran the sequence
+ *
+ *  states: probe states after the sequence
+ *
+ *  returns: fingerprint of the sequence
+ */
+static uint64_t fingerprint(const superopt_state_t *states)
+{
+    uint64_t h = 0;
+
+    for (size_t p = 0; p < SUPEROPT_PROBES; p++) {
+        h = mix(h ^ state_hash(&states[p]));
+    }
+    return h;
+}
+
+/*
+ * Function: equivalent
+ * --------------------
+ *  runs both sequences on every check state
+ *
+ *  superopt: superoptimizer state
+ *  x: first sequence
+ *  x_n: length of the first sequence
+ *  y: second sequence
+ *  y_n: length of the second sequence
+ *
+ *  returns: true if they agree on every check state
+ */
+static bool equivalent(const superopt_t *superopt, const superopt_op_t *x,
+        size_t x_n, const superopt_op_t *y, size_t y_n)
+{
+    superopt_state_t after_x, after_y;
+
+    for (size_t i = 0; i < SUPEROPT_CHECKS; i++) {
+        after_x = after_y = superopt->checks[i];
+        run(&after_x, x, x_n);
+        run(&after_y, y, y_n);
+        if (!same_state(&after_x, &after_y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Function: sequence_fingerprint
+ * ------------------------------
+ *  runs sequence on every probe state
+ *
+ *  superopt: superoptimizer state
+ *  ops: commands
+ *  n: amount of commands
+ *
+ *  returns: fingerprint of the sequence
+ */
+static uint64_t sequence_fingerprint(const superopt_t *superopt,
+        const superopt_op_t *ops, size_t n)
+{
+    superopt_state_t states[SUPEROPT_PROBES];
+
+    for (size_t p = 0; p < SUPEROPT_PROBES; p++) {
+        states[p] = superopt->probes[p];
+        run(&states[p], ops, n);
+    }
+    return fingerprint(states);
+}
+
+/*
+ * Function: rank_base
+ * -------------------
+ *  computes rank of the first candidate of given length, empty sequence
+ *  has rank 0 and longer candidates rank above shorter ones
+ *
+ *  superopt: superoptimizer state
+ *  length: candidate length
+ *
+ *  returns: rank of the first candidate
+ */
+static int32_t rank_base(const superopt_t *superopt, size_t length)
+{
+    int32_t base = 0, power = 1;
+
+    for (size_t l = 0; l < length; l++) {
+        base += power;
+        power *= superopt->ops_n;
+    }
+    return base;
+}
+
+/*
+ * Function: match
+ * ---------------
+ *  checks candidate against every target of the same fingerprint, keeping
+ *  the lowest rank of equivalent candidates
+ *
+ *  superopt: superoptimizer state
+ *  ops: candidate commands
+ *  indices: indices of candidate commands
+ *  length: amount of candidate commands
+ *  h: fingerprint of the candidate
+ *
+ *  returns: amount of fingerprint matches checked
+ */
+static uint64_t match(superopt_t *superopt, const superopt_op_t *ops,
+        const size_t *indices, size_t length, uint64_t h)
+{
+    superopt_target_t *target;
+    int32_t rank, best;
+    uint64_t checked = 0;
+
+    for (size_t slot = h & superopt->mask; superopt->slots[slot];
+            slot = (slot + 1) & superopt->mask) {
+        target = &superopt->targets[superopt->slots[slot] - 1];
+        if (target->fingerprint != h || target->n <= length) {
+            continue;
+        }
+
+        rank = rank_base(superopt, length);
+        for (size_t l = 0, power = 1; l < length; l++) {
+            rank += indices[length - 1 - l] * power;
+            power *= superopt->ops_n;
+        }
+        best = ctable_get(superopt->best, target->text);
+        if (best >= 0 && best <= rank) {
+            continue;
+        }
+
+        checked++;
+        if (equivalent(superopt, target->ops, target->n, ops, length)) {
+            ctable_put(superopt->best, target->text, rank, CTABLE_MIN);
+        }
+    }
+    return checked;
+}
+
+/*
+ * Function: search
+ * ----------------
+ *  enumerates candidates extending the prefix of the job, probe states
+ *  of every prefix are kept so each command runs once per prefix
+ *
+ *  job: superoptimizer job
+ *  depth: length of the prefix
+ */
+static void search(superopt_job_t *job, size_t depth)
+{
+    superopt_t *superopt = job->superopt;
+    size_t first = depth == 0 ? job->thread : 0;
+    size_t stride = depth == 0 ? job->threads_n : 1;
+
+    for (size_t i = first; i < superopt->ops_n; i += stride) {
+        job->indices[depth] = i;
+        job->ops[depth] = superopt->ops[i];
+        for (size_t p = 0; p < SUPEROPT_PROBES; p++) {
+            job->states[depth + 1][p] = job->states[depth][p];
+            step(&job->states[depth + 1][p], superopt->ops[i]);
+        }
+
+        if (depth + 1 < job->length) {
+            search(job, depth + 1);
+        } else {
+            job->candidates++;
+            job->checked += match(superopt, job->ops, job->indices,
+                    job->length, fingerprint(job->states[depth + 1]));
+        }
+    }
+}
+
+/*
+ * Function: search_thread
+ * -----------------------
+ *  thread routine enumerating candidates of its first commands
+ *
+ *  arg: superoptimizer job
+ *
+ *  returns: NULL
+ */
+static void *search_thread(void *arg)
+{
+    superopt_job_t *job = arg;
+
+    memcpy(job->states[0], job->superopt->probes,
+            sizeof(job->superopt->probes));
+    search(job, 0);
+    return NULL;
+}
+
+/*
+ * Function: parse_key
+ * -------------------
+ *  encodes single command spelled by rewrite_key
+ *
+ *  key: command text
+ *
+ *  returns: encoded command
+ */
+static superopt_op_t parse_key(const char *key)
+{
+    char buffer[MAXLINE];
+    char *comp;
+    superopt_op_t op = { 0, 0 };
+
+    strcpy(buffer, key);
+    if ((comp = strchr(buffer, '='))) {
+        *comp++ = '\0';
+        op.dest = encode_dest(buffer);
+    } else {
+        comp = buffer;
+    }
+    op.comp = encode_comp(comp);
+    return op;
+}
+
+/*
+ * Function: add_target
+ * --------------------
+ *  counts occurrence of the sequence, adding it on first one
+ *
+ *  superopt: superoptimizer state
+ *  seen: target text -> target index
+ *  keys: keys of the sequence commands
+ *  n: amount of commands
+ */
+static void add_target(superopt_t *superopt, table_t *seen,
+        char keys[][MAXLINE], size_t n)
+{
+    char text[REWRITE_MAX_COMMANDS * MAXLINE];
+    superopt_target_t *target;
+    int32_t found;
+
+    text[0] = '\0';
+    for (size_t i = 0; i < n; i++) {
+        strcat(strcat(text, i ? " " : ""), keys[i]);
+    }
+
+    if ((found = table_get(seen, text)) >= 0) {
+        superopt->targets[found].count++;
+        return;
+    }
+
+    superopt->targets = realloc(superopt->targets,
+            (superopt->n + 1) * sizeof(superopt_target_t));
+    target = &superopt->targets[superopt->n];
+    target->text = strdup(text);
+    target->n = n;
+    target->count = 1;
+    for (size_t i = 0; i < n; i++) {
+        target->ops[i] = parse_key(keys[i]);
+    }
+    table_add(seen, text, (int32_t) superopt->n++);
+}
+
+/*
+ * Function: collect_targets
+ * -------------------------
+ *  adds every run of up to window rewritable commands of the source
+ *
+ *  superopt: superoptimizer state
+ *  seen: target text -> target index
+ *  path: assembler source path
+ *  window: longest target
+ *
+ *  returns: false if source can't be read
+ */
+static bool collect_targets(superopt_t *superopt, table_t *seen,
+        const char *path, size_t window)
+{
+    char keys[REWRITE_MAX_COMMANDS][MAXLINE];
+    FILE *stream = fopen(path, "r");
+    asm_command_t *command;
+    size_t line = 1, run = 0;
+
+    if (!stream) {
+        return false;
+    }
+
+    /* keys hold the last commands of the current run, the newest last */
+    while ((command = get_command(stream, &line))) {
+        if (!rewrite_key(keys[run < window ? run : window - 1], command)) {
+            run = 0;
+        } else {
+            for (size_t len = 1; len <= run + 1 && len <= window; len++) {
+                add_target(superopt, seen,
+                        &keys[(run < window ? run : window - 1) + 1 - len],
+                        len);
+            }
+            if (++run >= window) {
+                memmove(keys[0], keys[1], (window - 1) * MAXLINE);
+            }
+        }
+        command_del(command);
+    }
+
+    fclose(stream);
+    return true;
+}
+
+/*
+ * Function: index_targets
+ * -----------------------
+ *  fingerprints every target and fills the fingerprint hash
+ *
+ *  superopt: superoptimizer state
+ */
+static void index_targets(superopt_t *superopt)
+{
+    size_t size = 16, slot;
+
+    while (size < 2 * superopt->n) {
+        size *= 2;
+    }
+    superopt->slots = calloc(size, sizeof(size_t));
+    superopt->mask = size - 1;
+
+    for (size_t i = 0; i < superopt->n; i++) {
+        superopt_target_t *target = &superopt->targets[i];
+        target->fingerprint = sequence_fingerprint(superopt, target->ops,
+                target->n);
+        for (slot = target->fingerprint & superopt->mask;
+                superopt->slots[slot]; slot = (slot + 1) & superopt->mask) {
+        }
+        superopt->slots[slot] = i + 1;
+    }
+}
+
+/*
+ * Function: compare_targets
+ * -------------------------
+ *  orders targets by occurrences (most frequent first), then by text
+ *
+ *  x: first target pointer
+ *  y: second target pointer
+ *
+ *  returns: negative, zero or positive as for qsort
+ */
+static int compare_targets(const void *x, const void *y)
+{
+    const superopt_target_t *tx = *(superopt_target_t * const *) x;
+    const superopt_target_t *ty = *(superopt_target_t * const *) y;
+
+    if (tx->count != ty->count) {
+        return tx->count > ty->count ? -1 : 1;
+    }
+    return strcmp(tx->text, ty->text);
+}
+
+/*
+ * Function: write_rule
+ * --------------------
+ *  writes target with its best candidate decoded from rank
+ *
+ *  stream: database stream
+ *  superopt: superoptimizer state
+ *  target: target with a candidate
+ *  rank: rank of the candidate
+ */
+static void write_rule(FILE *stream, const superopt_t *superopt,
+        const superopt_target_t *target, int32_t rank)
+{
+    size_t length = 0, indices[SUPEROPT_MAX_LENGTH];
+    while (rank >= rank_base(superopt, length + 1)) {
+        length++;
+    }
+    rank -= rank_base(superopt, length);
+    for (size_t l = length; l > 0; l--) {
+        indices[l - 1] = rank % superopt->ops_n;
+        rank /= superopt->ops_n;
+    }
+
+    fprintf(stream, "%s\t", target->text);
+    for (size_t l = 0; l < length; l++) {
+        superopt_op_t op = superopt->ops[indices[l]];
+        fprintf(stream, "%s%s=%s", l ? " " : "", dest_mnemonic(op.dest),
+                superopt->comps[indices[l]]);
+    }
+    fputc('\n', stream);
+}
+
+/*
+ * Function: main
+ * --------------
+ *  collects targets, searches their equivalents and writes the database
+ *
+ *  returns: 0 on success, 1 if a source or the database can't be opened
+ */
+int main(int argc, char **argv)
+{
+    size_t window = SUPEROPT_WINDOW, max_length = SUPEROPT_LENGTH;
+    size_t threads_n = 0, sources_n = 0, rules_n = 0;
+    superopt_job_t *jobs;
+    pthread_t threads[SUPEROPT_MAX_THREADS];
+    superopt_target_t **order;
+    const char *output = NULL;
+    superopt_t superopt;
+    uint64_t seed = SUPEROPT_SEED, candidates, checked;
+    table_t *seen;
+    FILE *stream;
+    double start;
+    const char *comp;
+    int32_t rank;
+
+    memset(&superopt, 0, sizeof(superopt_t));
+    seen = table_new();
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-w") && i + 1 < argc
+                && atoi(argv[i + 1]) > 0
+                && atoi(argv[i + 1]) <= REWRITE_MAX_COMMANDS) {
+            window = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-l") && i + 1 < argc
+                && atoi(argv[i + 1]) >= 0
+                && atoi(argv[i + 1]) <= SUPEROPT_MAX_LENGTH) {
+            max_length = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc
+                && atoi(argv[i + 1]) > 0
+                && atoi(argv[i + 1]) <= SUPEROPT_MAX_THREADS) {
+            threads_n = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (argv[i][0] != '-') {
+            if (!collect_targets(&superopt, seen, argv[i], window)) {
+                fprintf(stderr, "HackSuperopt: can't read %s\n", argv[i]);
+                exit(1);
+            }
+            sources_n++;
+        } else {
+            write_help_msg();
+            exit(1);
+        }
+    }
+    table_del(seen);
+    if (sources_n == 0) {
+        write_help_msg();
+        exit(1);
+    }
+
+    if (threads_n == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads_n = cores < 1 ? 1 : cores > SUPEROPT_MAX_THREADS
+            ? SUPEROPT_MAX_THREADS : (size_t) cores;
+    }
+
+    /* every 'comp' with every 'dest' except null one, which does nothing */
+    for (size_t c = 0; (comp = comp_mnemonic(c)); c++) {
+        for (uint8_t dest = 1; dest < 8; dest++) {
+            superopt.ops[superopt.ops_n].comp = encode_comp(comp);
+            superopt.ops[superopt.ops_n].dest = dest;
+            superopt.comps[superopt.ops_n++] = comp;
+        }
+    }
+
+    for (size_t p = 0; p < SUPEROPT_PROBES; p++) {
+        random_state(&superopt.probes[p], &seed);
+    }
+    superopt.checks = malloc(SUPEROPT_CHECKS * sizeof(superopt_state_t));
+    for (size_t i = 0; i < SUPEROPT_CHECKS; i++) {
+        random_state(&superopt.checks[i], &seed);
+    }
+    index_targets(&superopt);
+    superopt.best = ctable_new(superopt.n);
+
+    fprintf(stderr, "HackSuperopt: %zu distinct sequences of up to %zu "
+            "commands\n", superopt.n, window);
+
+    /* empty candidate needs no threads */
+    start = now();
+    checked = match(&superopt, NULL, NULL, 0,
+            sequence_fingerprint(&superopt, NULL, 0));
+    fprintf(stderr, "HackSuperopt: length 0: 1 candidate, %llu checked, "
+            "%.2f s\n", (unsigned long long) checked, now() - start);
+
+    jobs = calloc(threads_n, sizeof(superopt_job_t));
+    for (size_t length = 1; length <= max_length && length < window;
+            length++) {
+        start = now();
+        for (size_t t = 0; t < threads_n; t++) {
+            jobs[t].superopt = &superopt;
+            jobs[t].length = length;
+            jobs[t].thread = t;
+            jobs[t].threads_n = threads_n;
+            jobs[t].candidates = jobs[t].checked = 0;
+            pthread_create(&threads[t], NULL, search_thread, &jobs[t]);
+        }
+        candidates = checked = 0;
+        for (size_t t = 0; t < threads_n; t++) {
+            pthread_join(threads[t], NULL);
+            candidates += jobs[t].candidates;
+            checked += jobs[t].checked;
+        }
+        fprintf(stderr, "HackSuperopt: length %zu: %llu candidates, %llu "
+                "checked, %.2f s\n", length, (unsigned long long) candidates,
+                (unsigned long long) checked, now() - start);
+    }
+    free(jobs);
+
+    stream = output ? fopen(output, "w") : stdout;
+    if (!stream) {
+        fprintf(stderr, "HackSuperopt: can't write %s\n", output);
+        exit(1);
+    }
+
+    order = malloc((superopt.n + 1) * sizeof(superopt_target_t *));
+    for (size_t i = 0; i < superopt.n; i++) {
+        order[i] = &superopt.targets[i];
+    }
+    qsort(order, superopt.n, sizeof(superopt_target_t *), compare_targets);
+
+    fprintf(stream, "%s\n# %zu sources, window %zu, length %zu\n",
+            REWRITE_HEADER, sources_n, window, max_length);
+    for (size_t i = 0; i < superopt.n; i++) {
+        if ((rank = ctable_get(superopt.best, order[i]->text)) >= 0) {
+            write_rule(stream, &superopt, order[i], rank);
+            rules_n++;
+        }
+    }
+    if (output) {
+        fclose(stream);
+    }
+    fprintf(stderr, "HackSuperopt: %zu rules\n", rules_n);
+
+    for (size_t i = 0; i < superopt.n; i++) {
+        free(superopt.targets[i].text);
+    }
+    free(order);
+    free(superopt.targets);
+    free(superopt.slots);
+    free(superopt.checks);
+    ctable_del(superopt.best);
+    return 0;
+}
@@ -0,0 +1,691 @@
+/*
+ * File: syntax.c
+ * --------------
+ *  validates assembler source line by line without assembling it
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code.h"
+#include "expr.h"
+#include "helpers.h"
+#include "parser.h"
+#include "syntax.h"
+#include "table.h"
+
+#define SYNTAX_INIT_CAPACITY 64
+
+typedef struct syntax_frame_t {
+    const char *path;                    /* real path of checked file */
+    const struct syntax_frame_t *parent; /* file including this one */
+} syntax_frame_t;
+
+typedef struct {
+    const char *path; /* file of the definition */
+    size_t line;
+} syntax_label_t;
+
+typedef struct {
+    char *symbol;     /* symbol loaded right before a jump */
+    const char *path;
+    size_t line;
+    size_t column;
+    bool expression;  /* symbol is named by expression instead */
+} syntax_use_t;
+
+typedef struct {
+    table_t *builtins;
+    int32_t max;            /* largest value A command can load */
+    table_t *labels;        /* label -> index of its definition */
+    syntax_label_t *defs;
+    size_t defs_n;
+    size_t defs_capacity;
+    syntax_use_t *uses;
+    size_t uses_n;
+    size_t uses_capacity;
+    char **paths;           /* paths of included files */
+    size_t paths_n;
+    size_t paths_capacity;
+    size_t errors;
+} syntax_state_t;
+
+typedef struct {
+    char text[MAXLINE];      /* command with whitespace removed */
+    size_t columns[MAXLINE]; /* column of every character of text */
+    size_t n;                /* length of text */
+    const char *path;
+    size_t line;
+} syntax_line_t;
+
+typedef struct {
+    syntax_state_t *state;
+    const syntax_line_t *line; /* line holding the expression */
+    bool symbolic;             /* expression names a label */
+} syntax_expr_t;
+
+/*
+ * Function: grow
+ * --------------
+ *  makes room for one more item of growable list
+ *
+ *  items: list
+ *  capacity_ptr: capacity of the list
+ *  n: amount of items
+ *  size: size of an item
+ *
+ *  returns: list with room for one more item
+ */
+static void *grow(void *items, size_t *capacity_ptr, size_t n, size_t size)
+{
+    if (n == *capacity_ptr) {
+        *capacity_ptr = *capacity_ptr ? 2 * *capacity_ptr
+            : SYNTAX_INIT_CAPACITY;
+        items = realloc(items, *capacity_ptr * size);
+    }
+    return items;
+}
+
+/*
+ * Function: report
+ * ----------------
+ *  writes error with its position and counts it
+ *
+ *  state: checker state
+ *  path: file of the error
+ *  line: line of the error
+ *  column: column of the error
+ *  format: printf format of the message
+ */
+static void report(syntax_state_t *state, const char *path, size_t line,
+        size_t column, const char *format, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "HackAssembler: %s:%zu:%zu: ", path, line, column);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    state->errors++;
+}
+
+/*
+ * Function: column_of
+ * -------------------
+ *  finds column of the character of command text
+ *
+ *  line: lexed line
+ *  i: index of the character (may point past the text)
+ *
+ *  returns: column of the character, or the one right after the text
+ */
+static size_t column_of(const syntax_line_t *line, size_t i)
+{
+    if (i < line->n) {
+        return line->columns[i];
+    }
+    return line->n ? line->columns[line->n - 1] + 1 : 1;
+}
+
+/*
+ * Function: field
+ * ---------------
+ *  copies part of command text
+ *
+ *  line: lexed line
+ *  begin: first character of the part
+ *  end: character after the part
+ *  buffer: buffer of MAXLINE characters
+ *
+ *  returns: buffer
+ */
+static char *field(const syntax_line_t *line, size_t begin, size_t end,
+        char *buffer)
+{
+    memcpy(buffer, line->text + begin, end - begin);
+    buffer[end - begin] = '\0';
+    return buffer;
+}
+
+/*
+ * Function: find_char
+ * -------------------
+ *  finds first occurrence of the character in command text
+ *
+ *  line: lexed line
+ *  c: character to find
+ *
+ *  returns: index of the character
+ *           length of the text if there is no such character
+ */
+static size_t find_char(const syntax_line_t *line, char c)
+{
+    const char *p = memchr(line->text, c, line->n);
+
+    return p ? (size_t) (p - line->text) : line->n;
+}
+
+/*
+ * Function: add_use
+ * -----------------
+ *  records use of symbol that has to be defined as label
+ *
+ *  state: checker state
+ *  symbol: used symbol
+ *  path: file of the use
+ *  line: line of the use
+ *  column: column of the use
+ *  expression: true if symbol is named by expression
+ */
+static void add_use(syntax_state_t *state, const char *symbol,
+        const char *path, size_t line, size_t column, bool expression)
+{
+    syntax_use_t *use;
+
+    state->uses = grow(state->uses, &state->uses_capacity, state->uses_n,
+            sizeof(syntax_use_t));
+    use = &state->uses[state->uses_n++];
+    use->symbol = strdup(symbol);
+    use->path = path;
+    use->line = line;
+    use->column = column;
+    use->expression = expression;
+}
+
+/*
+ * Function: is_symbol_char
+ * ------------------------
+ *  determines whether the character may be a part of symbol
+ *
+ *  c: character to test
+ *
+ *  returns: true for letters, digits, '_', '.', '$' and ':'
+ *           false otherwise
+ */
+static bool is_symbol_char(char c)
+{
+    return isalnum((unsigned char) c) || c == '_' || c == '.' || c == '$'
+        || c == ':';
+}
+
+/*
+ * Function: check_symbol
+ * ----------------------
+ *  checks that part of command text is a symbol
+ *
+ *  state: checker state
+ *  line: lexed line
+ *  begin: first character of the symbol
+ *  end: character after the symbol
+ *  what: name of the symbol in messages
+ *
+ *  returns: true if the symbol is valid
+ *           false otherwise
+ */
+static bool check_symbol(syntax_state_t *state, const syntax_line_t *line,
+        size_t begin, size_t end, const char *what)
+{
+    if (begin == end) {
+        report(state, line->path, line->line, column_of(line, begin),
+                "missing %s", what);
+        return false;
+    }
+    if (isdigit((unsigned char) line->text[begin])) {
+        report(state, line->path, line->line, column_of(line, begin),
+                "%s can't start with a digit", what);
+        return false;
+    }
+    for (size_t i = begin; i < end; i++) {
+        if (!is_symbol_char(line->text[i])) {
+            report(state, line->path, line->line, column_of(line, i),
+                    "invalid character '%c' in %s", line->text[i], what);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Function: expression_lookup
+ * ---------------------------
+ *  takes predefined symbols at their value and records any other symbol
+ *  of expression as use of label, which is checked once every label is
+ *  known
+ *
+ *  symbol: symbol of the expression
+ *  position: offset of the symbol in the expression
+ *  arg: expression context
+ *
+ *  returns: value of predefined symbol, 1 for labels (so they can't
+ *           divide by zero)
+ */
+static int32_t expression_lookup(const char *symbol, size_t position,
+        void *arg)
+{
+    syntax_expr_t *context = arg;
+    const syntax_line_t *line = context->line;
+
+    if (table_contains(context->state->builtins, symbol)) {
+        return table_get(context->state->builtins, symbol);
+    }
+
+    add_use(context->state, symbol, line->path, line->line,
+            column_of(line, 1 + position), true);
+    context->symbolic = true;
+    return 1;
+}
+
+/*
+ * Function: check_expression
+ * --------------------------
+ *  checks A command expression: its form, and its value if it names no
+ *  label
+ *
+ *  state: checker state
+ *  line: lexed line holding A command
+ *  operand: A command operand
+ */
+static void check_expression(syntax_state_t *state,
+        const syntax_line_t *line, const char *operand)
+{
+    syntax_expr_t context = { state, line, false };
+    expr_status_t status;
+    size_t position;
+    int64_t value;
+
+    status = expr_eval(operand, expression_lookup, &context, &value,
+            &position);
+
+    /* value of labels is unknown, so only the form of such expression
+     * can be wrong */
+    if (status == EXPR_SYNTAX || (status != EXPR_OK && !context.symbolic)) {
+        report(state, line->path, line->line, column_of(line, 1 + position),
+                "%s", expr_message(status));
+    } else if (status == EXPR_OK && !context.symbolic
+            && (value < 0 || value > state->max)) {
+        report(state, line->path, line->line, column_of(line, 1),
+                "value %lld of expression is out of range (max %d)",
+                (long long) value, state->max);
+    }
+}
+
+/*
+ * Function: check_addr
+ * --------------------
+ *  checks A command: operand is either a constant the command can load
+ *  or a symbol
+ *
+ *  state: checker state
+ *  line: lexed line holding A command
+ *
+ *  returns: true if operand is a symbol that has to be a label when it is
+ *           jumped to (neither a constant nor predefined symbol)
+ *           false otherwise
+ */
+static bool check_addr(syntax_state_t *state, const syntax_line_t *line)
+{
+    char operand[MAXLINE];
+    int64_t value = 0;
+    size_t i;
+
+    field(line, 1, line->n, operand);
+    if (expr_is_expression(operand)) {
+        check_expression(state, line, operand);
+        return false;
+    }
+    if (operand[0] == '\0' || !str_isnum(operand)) {
+        return check_symbol(state, line, 1, line->n, "A command operand")
+            && !table_contains(state->builtins, operand);
+    }
+
+    for (i = 0; operand[i] && value <= state->max; i++) {
+        value = 10 * value + (operand[i] - '0');
+    }
+    if (value > state->max) {
+        report(state, line->path, line->line, column_of(line, 1),
+                "constant %s is out of range (max %d)", operand, state->max);
+    }
+    return false;
+}
+
+/*
+ * Function: check_label
+ * ---------------------
+ *  checks label definition and records it, reporting duplicates
+ *
+ *  state: checker state
+ *  line: lexed line holding label
+ */
+static void check_label(syntax_state_t *state, const syntax_line_t *line)
+{
+    char symbol[MAXLINE];
+    int32_t def;
+
+    if (line->text[line->n - 1] != ')') {
+        report(state, line->path, line->line, column_of(line, line->n),
+                "missing ')' after label");
+        return;
+    }
+    if (!check_symbol(state, line, 1, line->n - 1, "label")) {
+        return;
+    }
+
+    field(line, 1, line->n - 1, symbol);
+    if ((def = table_get(state->labels, symbol)) >= 0) {
+        report(state, line->path, line->line, column_of(line, 1),
+                "label %s is already defined at %s:%zu", symbol,
+                state->defs[def].path, state->defs[def].line);
+        return;
+    }
+
+    state->defs = grow(state->defs, &state->defs_capacity, state->defs_n,
+            sizeof(syntax_label_t));
+    state->defs[state->defs_n].path = line->path;
+    state->defs[state->defs_n].line = line->line;
+    table_add(state->labels, symbol, state->defs_n++);
+}
+
+/*
+ * Function: check_part
+ * --------------------
+ *  checks dest, comp or jump part of C command against code tables
+ *
+ *  state: checker state
+ *  line: lexed line holding C command
+ *  begin: first character of the part
+ *  end: character after the part
+ *  what: name of the part
+ *  valid: mnemonic check of the part
+ */
+static void check_part(syntax_state_t *state, const syntax_line_t *line,
+        size_t begin, size_t end, const char *what,
+        bool (*valid)(const char *))
+{
+    char mnemonic[MAXLINE];
+
+    if (begin == end) {
+        report(state, line->path, line->line, column_of(line, begin),
+                "missing %s", what);
+    } else if (!valid(field(line, begin, end, mnemonic))) {
+        report(state, line->path, line->line, column_of(line, begin),
+                "invalid %s '%s'", what, mnemonic);
+    }
+}
+
+/*
+ * Function: check_comp
+ * --------------------
+ *  checks C command split the way the parser splits it: 'dest=comp',
+ *  'comp;jump' or bare 'comp'
+ *
+ *  state: checker state
+ *  line: lexed line holding C command
+ *
+ *  returns: true if command is 'comp;jump'
+ *           false otherwise
+ */
+static bool check_comp(syntax_state_t *state, const syntax_line_t *line)
+{
+    size_t eq = find_char(line, '='), semi = find_char(line, ';');
+
+    if (eq < line->n) {
+        check_part(state, line, 0, eq, "dest", valid_dest);
+        /* the parser takes whole rest as comp and would encode it wrong */
+        if (semi > eq && semi < line->n) {
+            check_part(state, line, eq + 1, semi, "comp", valid_comp);
+            report(state, line->path, line->line, column_of(line, semi),
+                    "jump after 'dest=comp' is not supported");
+        } else {
+            check_part(state, line, eq + 1, line->n, "comp", valid_comp);
+        }
+        return false;
+    }
+
+    check_part(state, line, 0, semi, "comp", valid_comp);
+    if (semi == line->n) {
+        return false;
+    }
+    check_part(state, line, semi + 1, line->n, "jump", valid_jump);
+    return true;
+}
+
+static void check_file(syntax_state_t *state, FILE *stream,
+        const char *path, const syntax_frame_t *parent);
+
+/*
+ * Function: check_include
+ * -----------------------
+ *  checks include directive and the included file
+ *
+ *  state: checker state
+ *  line: lexed line holding include directive
+ *  frame: frame of the including file
+ */
+static void check_include(syntax_state_t *state, const syntax_line_t *line,
+        const syntax_frame_t *frame)
+{
+    size_t begin = strlen(INCLUDE_DIRECTIVE), end = line->n;
+    char path[MAXLINE], real[PATH_MAX];
+    char close, *joined;
+    syntax_frame_t child;
+    FILE *stream;
+
+    if (begin == end) {
+        report(state, line->path, line->line, column_of(line, begin),
+                "missing include path");
+        return;
+    }
+    if (line->text[begin] == '"' || line->text[begin] == '<') {
+        close = line->text[begin] == '"' ? '"' : '>';
+        end = begin + 1;
+        while (end < line->n && line->text[end] != close) {
+            end++;
+        }
+        if (end == line->n) {
+            report(state, line->path, line->line, column_of(line, begin),
+                    "unterminated include path");
+            return;
+        }
+        if (end + 1 < line->n) {
+            report(state, line->path, line->line, column_of(line, end + 1),
+                    "unexpected '%c' after include path",
+                    line->text[end + 1]);
+            return;
+        }
+        begin++;
+    }
+
+    joined = join_path(line->path, field(line, begin, end, path));
+    if (!(stream = fopen(joined, "r")) || !realpath(joined, real)) {
+        report(state, line->path, line->line, column_of(line, begin),
+                "can't include %s", joined);
+        free(joined);
+        if (stream) {
+            fclose(stream);
+        }
+        return;
+    }
+
+    for (const syntax_frame_t *p = frame; p; p = p->parent) {
+        if (!strcmp(p->path, real)) {
+            report(state, line->path, line->line, column_of(line, begin),
+                    "include cycle through %s", joined);
+            free(joined);
+            fclose(stream);
+            return;
+        }
+    }
+
+    /* definitions and uses of included file keep pointing to its path */
+    state->paths = grow(state->paths, &state->paths_capacity,
+            state->paths_n, sizeof(char *));
+    state->paths[state->paths_n++] = joined;
+
+    child.path = real;
+    child.parent = frame;
+    check_file(state, stream, joined, &child);
+    fclose(stream);
+}
+
+/*
+ * Function: lex_line
+ * ------------------
+ *  removes whitespace of source line the way the parser does, keeping
+ *  column of every remaining character
+ *
+ *  state: checker state
+ *  raw: source line
+ *  line: lexed line with path and line number set
+ *
+ *  returns: true if line holds a command
+ *           false for empty, commented and overlong lines
+ */
+static bool lex_line(syntax_state_t *state, const char *raw,
+        syntax_line_t *line)
+{
+    size_t i = 0, comment;
+
+    while (isspace((unsigned char) raw[i])) {
+        i++;
+    }
+    /* the parser takes any line starting with '/' for a comment */
+    if (raw[i] == '\0' || raw[i] == '/') {
+        return false;
+    }
+
+    line->n = 0;
+    for (; raw[i]; i++) {
+        if (isspace((unsigned char) raw[i])) {
+            continue;
+        }
+        if (line->n == MAXLINE - 1) {
+            report(state, line->path, line->line, line->columns[0],
+                    "command is longer than %d characters", MAXLINE - 1);
+            return false;
+        }
+        line->text[line->n] = raw[i];
+        line->columns[line->n++] = i + 1;
+    }
+    line->text[line->n] = '\0';
+
+    /* the parser keeps trailing comment as a part of the command */
+    comment = strstr(line->text, "//") ? strstr(line->text, "//") - line->text
+        : line->n;
+    if (comment < line->n && strncmp(line->text, INCLUDE_DIRECTIVE,
+                strlen(INCLUDE_DIRECTIVE)) && strncmp(line->text,
+                INCLUDE_DIRECTIVE_ALT, strlen(INCLUDE_DIRECTIVE_ALT))) {
+        report(state, line->path, line->line, column_of(line, comment),
+                "comment after command is not supported");
+        line->n = comment;
+        line->text[comment] = '\0';
+    }
+    return true;
+}
+
+/*
+ * Function: check_file
+ * --------------------
+ *  checks every line of the file, following its includes
+ *
+ *  state: checker state
+ *  stream: source stream
+ *  path: path of the file
+ *  parent: frame of the file (NULL if its real path is unknown)
+ */
+static void check_file(syntax_state_t *state, FILE *stream,
+        const char *path, const syntax_frame_t *parent)
+{
+    syntax_line_t line;
+    char *raw = NULL, symbol[MAXLINE];
+    size_t raw_capacity = 0;
+    bool loaded = false; /* previous command loads label candidate */
+    size_t loaded_line = 0, loaded_column = 0;
+
+    line.path = path;
+    line.line = 0;
+    while (getline(&raw, &raw_capacity, stream) != -1) {
+        line.line++;
+        if (!lex_line(state, raw, &line)) {
+            continue;
+        }
+
+        if (line.text[0] == '@') {
+            loaded = check_addr(state, &line);
+            if (loaded) {
+                field(&line, 1, line.n, symbol);
+                loaded_line = line.line;
+                loaded_column = column_of(&line, 1);
+            }
+            continue;
+        }
+
+        if (line.text[0] == '(') {
+            check_label(state, &line);
+        } else if (!strncmp(line.text, INCLUDE_DIRECTIVE,
+                    strlen(INCLUDE_DIRECTIVE)) || !strncmp(line.text,
+                    INCLUDE_DIRECTIVE_ALT, strlen(INCLUDE_DIRECTIVE_ALT))) {
+            check_include(state, &line, parent);
+        } else if (line.n > 0 && check_comp(state, &line) && loaded) {
+            add_use(state, symbol, path, loaded_line, loaded_column, false);
+        }
+        loaded = false;
+    }
+
+    free(raw);
+}
+
+/*
+ * Function: syntax_check
+ * ----------------------
+ *  checks every line of the source and its includes, reporting every
+ *  error to stderr
+ *
+ *  stream: assembler source stream
+ *  path: source path (includes are relative to it)
+ *  builtins: predefined symbols
+ *  max: largest value A command can load
+ *
+ *  returns: amount of errors
+ */
+size_t syntax_check(FILE *stream, const char *path, table_t *builtins,
+        int32_t max)
+{
+    syntax_state_t state;
+    char real[PATH_MAX];
+    syntax_frame_t root = { real, NULL };
+
+    memset(&state, 0, sizeof(syntax_state_t));
+    state.builtins = builtins;
+    state.max = max;
+    state.labels = table_new();
+
+    /* source itself takes part in cycle detection */
+    check_file(&state, stream, path, realpath(path, real) ? &root : NULL);
+
+    /* labels may be defined after their uses, so these go last */
+    for (size_t i = 0; i < state.uses_n; i++) {
+        if (!table_contains(state.labels, state.uses[i].symbol)) {
+            report(&state, state.uses[i].path, state.uses[i].line,
+                    state.uses[i].column, state.uses[i].expression
+                    ? "undefined symbol %s in expression"
+                    : "undefined label %s", state.uses[i].symbol);
+        }
+        free(state.uses[i].symbol);
+    }
+
+    for (size_t i = 0; i < state.paths_n; i++) {
+        free(state.paths[i]);
+    }
+    free(state.paths);
+    free(state.uses);
+    free(state.defs);
+    table_del(state.labels);
+    return state.errors;
+}
@@ -0,0 +1,45 @@
+/*
+ * File: syntax.h
+ * --------------
+ *  function declarations for syntax module
+ *
+ *  validates assembler source line by line without assembling it, so
+ *  editors and hooks learn every error of the file at once: form of A
+ *  command operands (expressions included) and labels, dest, comp and
+ *  jump mnemonics of C commands, include directives (included files are
+ *  checked as well), duplicate labels and undefined labels
+ *
+ *  symbol loaded right before a jump is taken for a label, since jumping
+ *  to address of a variable is never meant, so it is undefined unless
+ *  some label or predefined symbol has its name; symbols of expressions
+ *  have to be labels or predefined symbols as well
+ *
+ *  errors are written as 'HackAssembler: path:line:column: message',
+ *  columns count bytes from 1
+ */
+
+#ifndef HACK_ASM_SYNTAX_H
+#define HACK_ASM_SYNTAX_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "table.h"
+
+/*
+ * Function: syntax_check
+ * ----------------------
+ *  checks every line of the source and its includes, reporting every
+ *  error to stderr
+ *
+ *  stream: assembler source stream
+ *  path: source path (includes are relative to it)
+ *  builtins: predefined symbols
+ *  max: largest value A command can load
+ *
+ *  returns: amount of errors
+ */
+size_t syntax_check(FILE *stream, const char *path, table_t *builtins,
+        int32_t max);
+
+#endif // !HACK_ASM_SYNTAX_H
@@ -2,37 +2,94 @@
  * File: table.c
  * -------------
  *  dictionary ADT for storing symbol-address mappings
+ *
+ *  snapshots are mapped once per process, keyed by real path and
+ *  validated by modification time and size, so every table loading the
+ *  same unchanged snapshot shares one checked mapping
  */
 
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "table.h"
 
+#define SNAPSHOT_HEADER_LEN (5 * sizeof(uint32_t))
+#define SNAPSHOT_ENTRY_LEN (sizeof(uint32_t) + sizeof(int32_t))
+
+typedef struct {
+    char *path; /* real path */
+    size_t len;
+    struct timespec mtime;
+    const char *data;
+} snapshot_t;
+
+typedef struct {
+    const char *key;
+    int32_t val;
+} saved_entry_t;
+
+static snapshot_t **snapshots = NULL;
+static size_t snapshots_n = 0;
+static pthread_mutex_t snapshots_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Function: hash
  * --------------
  *  hashing function for string keys
  *
  *  s: key to hash
+ *  buckets_n: amount of buckets (at least 2)
  *
- *  returns: integer hash code of the given key
+ *  returns: bucket of the given key
  */
-static int hash(const char *s)
+static size_t hash(const char *s, size_t buckets_n)
 {
-    int h = 0;
-    int a = 31415;
-    int b = 27831;
+    uint64_t h = 0;
+    uint64_t a = 31415;
+    uint64_t b = 27831;
 
-    for (char *p = (char *) s; *p; p++) {
-        h = (a * h + *p) % TABLE_BUCKETS_N;
-        a = a * b % (TABLE_BUCKETS_N - 1);
+    /* both factors stay below 2^32, so products never wrap */
+    for (const unsigned char *p = (const unsigned char *) s; *p; p++) {
+        h = (a * h + *p) % buckets_n;
+        a = a * b % (buckets_n - 1);
     }
 
     return h;
 }
 
+/*
+ * Function: buckets_for
+ * ---------------------
+ *  picks amount of buckets for the given amount of entries
+ *
+ *  size: amount of entries
+ *
+ *  returns: first prime not below size and TABLE_BUCKETS_N
+ */
+static size_t buckets_for(size_t size)
+{
+    size_t n = size > TABLE_BUCKETS_N ? size : TABLE_BUCKETS_N;
+    bool prime = false;
+
+    for (n |= 1; !prime; n += prime ? 0 : 2) {
+        prime = true;
+        for (size_t d = 3; prime && d * d <= n; d += 2) {
+            prime = n % d != 0;
+        }
+    }
+
+    return n;
+}
+
 /*
  * Function: node_new
  * ------------------
@@ -45,7 +102,7 @@ static int hash(const char *s)
  *  returns: pointer to newly allocated table entry
  */
 static table_node_t *node_new(const char *key,
-        short val, table_node_t *next_ptr)
+        int32_t val, table_node_t *next_ptr)
 {
     table_node_t *node = malloc(sizeof(table_node_t));
     node->key = strdup(key);
@@ -67,6 +124,235 @@ static void node_del(table_node_t *node)
     free(node);
 }
 
+/*
+ * Function: load_u32
+ * ------------------
+ *  reads 32 bit integer at the given offset of the snapshot
+ */
+static uint32_t load_u32(const char *snapshot, size_t offset)
+{
+    uint32_t v;
+    memcpy(&v, snapshot + offset, sizeof(v));
+    return v;
+}
+
+/*
+ * Function: snapshot_find
+ * -----------------------
+ *  searches for the entry of snapshot layer with the given key
+ *
+ *  table: table to search in
+ *  h: hash of the key
+ *  symbol: target key
+ *
+ *  returns: offset of the entry
+ *           0 if symbol is not found (or table has no snapshot)
+ */
+static size_t snapshot_find(table_t *table, size_t h, const char *symbol)
+{
+    const char *snapshot = table->snapshot;
+    size_t offset;
+
+    if (!snapshot) {
+        return 0;
+    }
+
+    offset = load_u32(snapshot, SNAPSHOT_HEADER_LEN + h * sizeof(uint32_t));
+    while (offset) {
+        if (!strcmp(snapshot + offset + SNAPSHOT_ENTRY_LEN, symbol)) {
+            return offset;
+        }
+        offset = load_u32(snapshot, offset);
+    }
+
+    return 0;
+}
+
+/*
+ * Function: snapshot_val
+ * ----------------------
+ *  reads value of the snapshot entry
+ *
+ *  table: table owning the snapshot
+ *  offset: offset of the entry (0 for missing one)
+ *
+ *  returns: value of the entry
+ *           -1 if entry is missing
+ */
+static int32_t snapshot_val(table_t *table, size_t offset)
+{
+    int32_t val;
+
+    if (!offset) {
+        return -1;
+    }
+    memcpy(&val, table->snapshot + offset + sizeof(uint32_t), sizeof(val));
+    return val;
+}
+
+/*
+ * Function: snapshot_valid
+ * ------------------------
+ *  checks that every chain of the snapshot stays inside of it and that
+ *  chains hold as many entries as header says, so later lookups don't
+ *  need any bounds checks
+ *
+ *  snapshot: mapped snapshot
+ *  len: snapshot length
+ *
+ *  returns: true if the snapshot is well formed
+ *           false otherwise
+ */
+static bool snapshot_valid(const char *snapshot, size_t len)
+{
+    size_t buckets_n, entries_start, offset, key_start, size = 0;
+
+    if (len < SNAPSHOT_HEADER_LEN
+            || memcmp(snapshot, TABLE_SNAPSHOT_MAGIC, 4)
+            || load_u32(snapshot, 4) != TABLE_SNAPSHOT_MARK) {
+        return false;
+    }
+    buckets_n = load_u32(snapshot, 8);
+    entries_start = SNAPSHOT_HEADER_LEN + buckets_n * sizeof(uint32_t);
+    if (buckets_n < 2 || len < entries_start) {
+        return false;
+    }
+
+    for (size_t i = 0; i < buckets_n; i++) {
+        offset = load_u32(snapshot, SNAPSHOT_HEADER_LEN + i * sizeof(uint32_t));
+
+        /* chains only go forward, so walking them always terminates */
+        for (size_t prev = 0; offset; offset = load_u32(snapshot, offset)) {
+            key_start = offset + SNAPSHOT_ENTRY_LEN;
+            if (offset <= prev || offset < entries_start || key_start >= len
+                    || !memchr(snapshot + key_start, '\0', len - key_start)) {
+                return false;
+            }
+            prev = offset;
+            size++;
+        }
+    }
+
+    return size == load_u32(snapshot, 12);
+}
+
+/*
+ * Function: snapshot_map
+ * ----------------------
+ *  maps and validates snapshot file
+ *
+ *  path: real path of the snapshot
+ *  st: status of the file
+ *
+ *  returns: pointer to allocated snapshot
+ *           NULL if file can't be mapped or isn't valid snapshot
+ */
+static snapshot_t *snapshot_map(const char *path, const struct stat *st)
+{
+    snapshot_t *snapshot;
+    char *data;
+    int fd;
+
+    if (st->st_size == 0 || (fd = open(path, O_RDONLY)) < 0) {
+        return NULL;
+    }
+    data = mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (!snapshot_valid(data, st->st_size)) {
+        munmap(data, st->st_size);
+        return NULL;
+    }
+
+    snapshot = malloc(sizeof(snapshot_t));
+    snapshot->path = strdup(path);
+    snapshot->len = st->st_size;
+    snapshot->mtime = st->st_mtim;
+    snapshot->data = data;
+    return snapshot;
+}
+
+/*
+ * Function: snapshot_lookup
+ * -------------------------
+ *  finds mapping of the snapshot, mapping it only if the process doesn't
+ *  hold its current version yet (thread safe)
+ *
+ *  mapping lives until the end of the process
+ *
+ *  path: snapshot file path
+ *
+ *  returns: pointer to shared snapshot
+ *           NULL if file can't be mapped or isn't valid snapshot
+ */
+static const snapshot_t *snapshot_lookup(const char *path)
+{
+    char real[PATH_MAX];
+    struct stat st;
+    snapshot_t *snapshot = NULL;
+
+    if (!realpath(path, real) || stat(real, &st)) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&snapshots_lock);
+
+    /* newest version of the file is the last one */
+    for (size_t i = snapshots_n; i-- > 0;) {
+        if (!strcmp(snapshots[i]->path, real)) {
+            snapshot = snapshots[i];
+            break;
+        }
+    }
+
+    /* stale mappings are kept alive, tables may still read them */
+    if (!snapshot || snapshot->len != (size_t) st.st_size
+            || snapshot->mtime.tv_sec != st.st_mtim.tv_sec
+            || snapshot->mtime.tv_nsec != st.st_mtim.tv_nsec) {
+        if ((snapshot = snapshot_map(real, &st))) {
+            snapshots = realloc(snapshots,
+                    (snapshots_n + 1) * sizeof(snapshot_t *));
+            snapshots[snapshots_n++] = snapshot;
+        }
+    }
+
+    pthread_mutex_unlock(&snapshots_lock);
+    return snapshot;
+}
+
+/*
+ * Function: snapshot_put
+ * ----------------------
+ *  appends entry to snapshot being built, entry is aligned to 4 bytes
+ *
+ *  buffer: snapshot being built
+ *  len_ptr: length of the snapshot
+ *  key: key of the entry
+ *  val: value of the entry
+ *
+ *  returns: offset of the entry
+ */
+static size_t snapshot_put(char **buffer, size_t *len_ptr,
+        const char *key, int32_t val)
+{
+    size_t offset = *len_ptr;
+    size_t key_len = strlen(key) + 1;
+    size_t entry_len = (SNAPSHOT_ENTRY_LEN + key_len + 3) & ~(size_t) 3;
+    uint32_t next = 0;
+
+    *buffer = realloc(*buffer, offset + entry_len);
+    memset(*buffer + offset, 0, entry_len);
+    memcpy(*buffer + offset, &next, sizeof(next));
+    memcpy(*buffer + offset + sizeof(next), &val, sizeof(val));
+    memcpy(*buffer + offset + SNAPSHOT_ENTRY_LEN, key, key_len);
+
+    *len_ptr += entry_len;
+    return offset;
+}
+
 /* Function: table_new
  * -------------------
  *  create new symbol table
@@ -76,11 +362,12 @@ static void node_del(table_node_t *node)
 table_t *table_new(void)
 {
     table_t *table = malloc(sizeof(table_t));
+    table->data = calloc(TABLE_BUCKETS_N, sizeof(table_node_t *));
+    table->buckets_n = TABLE_BUCKETS_N;
     table->size = 0;
-
-    for (int i = 0; i < TABLE_BUCKETS_N; i++) {
-        table->data[i] = NULL;
-    }
+    table->free_address = 0;
+    table->snapshot = NULL;
+    table->snapshot_len = 0;
 
     return table;
 }
@@ -96,13 +383,15 @@ void table_del(table_t *table)
 {
     table_node_t *p, *q;
 
-    for (int i = 0; i < TABLE_BUCKETS_N; i++) {
+    for (size_t i = 0; i < table->buckets_n; i++) {
         for (p = table->data[i]; p; p = q) {
             q = p->next;
             node_del(p);
         }
     }
 
+    /* snapshot mapping is shared, it lives until the end of the process */
+    free(table->data);
     free(table);
 }
 
@@ -115,9 +404,9 @@ void table_del(table_t *table)
  *  symbol: key of new entry
  *  address: value of new entry
  */
-void table_add(table_t *table, const char *symbol, short address)
+void table_add(table_t *table, const char *symbol, int32_t address)
 {
-    int h = hash(symbol);
+    size_t h = hash(symbol, table->buckets_n);
     table_node_t *node = node_new(symbol, address, table->data[h]);
     table->data[h] = node;
     table->size++;
@@ -136,7 +425,7 @@ void table_add(table_t *table, const char *symbol, short address)
  */
 bool table_contains(table_t *table, const char *symbol)
 {
-    int h = hash(symbol);
+    size_t h = hash(symbol, table->buckets_n);
 
     for (table_node_t *p = table->data[h]; p; p = p->next) {
         if (!strcmp(p->key, symbol)) {
@@ -144,7 +433,7 @@ bool table_contains(table_t *table, const char *symbol)
         }
     }
 
-    return false;
+    return snapshot_find(table, h, symbol) != 0;
 }
 
 /*
@@ -158,9 +447,9 @@ bool table_contains(table_t *table, const char *symbol)
  *  returns: address associated with symbol key
  *           -1 if symbol is not found
  */
-short table_get(table_t *table, const char *symbol)
+int32_t table_get(table_t *table, const char *symbol)
 {
-    int h = hash(symbol);
+    size_t h = hash(symbol, table->buckets_n);
 
     for (table_node_t *p = table->data[h]; p; p = p->next) {
         if (!strcmp(p->key, symbol)) {
@@ -168,5 +457,131 @@ short table_get(table_t *table, const char *symbol)
         }
     }
 
-    return -1;
+    return snapshot_val(table, snapshot_find(table, h, symbol));
+}
+
+/*
+ * Function: table_save
+ * --------------------
+ *  writes all entries of the table (including its snapshot layer) and
+ *  its free address as snapshot that can be loaded with table_load
+ *
+ *  table: table to save
+ *  path: snapshot file path
+ *
+ *  returns: true if the snapshot is written
+ *           false otherwise
+ */
+bool table_save(table_t *table, const char *path)
+{
+    size_t capacity = table->size + (table->snapshot
+            ? load_u32(table->snapshot, 12) : 0);
+    saved_entry_t *entries = malloc((capacity + 1) * sizeof(saved_entry_t));
+    uint32_t header[5] = { 0, TABLE_SNAPSHOT_MARK, 0, 0, 0 };
+    size_t n = 0, buckets_n, len, h, offset, snapshot_offset, *links;
+    table_node_t *p, *q;
+    const char *key;
+    char *buffer;
+    FILE *stream;
+    uint32_t at;
+    bool written;
+
+    /* own entries and snapshot layer share buckets of the table */
+    for (size_t i = 0; i < table->buckets_n; i++) {
+        /* own entries shadow equal keys added earlier and snapshot ones */
+        for (p = table->data[i]; p; p = p->next) {
+            for (q = table->data[i]; q != p && strcmp(q->key, p->key);
+                    q = q->next)
+                ;
+            if (q == p) {
+                entries[n++] = (saved_entry_t) { p->key, p->val };
+            }
+        }
+
+        snapshot_offset = table->snapshot ? load_u32(table->snapshot,
+                SNAPSHOT_HEADER_LEN + i * sizeof(uint32_t)) : 0;
+        for (; snapshot_offset; snapshot_offset =
+                load_u32(table->snapshot, snapshot_offset)) {
+            key = table->snapshot + snapshot_offset + SNAPSHOT_ENTRY_LEN;
+            for (p = table->data[i]; p && strcmp(p->key, key); p = p->next)
+                ;
+            if (!p) {
+                entries[n++] = (saved_entry_t) { key,
+                    snapshot_val(table, snapshot_offset) };
+            }
+        }
+    }
+
+    buckets_n = buckets_for(n);
+    len = SNAPSHOT_HEADER_LEN + buckets_n * sizeof(uint32_t);
+    buffer = calloc(len, 1);
+
+    /* offsets of the words pointing to the next entry of every chain,
+       entries are appended, so chains only go forward */
+    links = malloc(buckets_n * sizeof(size_t));
+    for (size_t i = 0; i < buckets_n; i++) {
+        links[i] = SNAPSHOT_HEADER_LEN + i * sizeof(uint32_t);
+    }
+    for (size_t i = 0; i < n; i++) {
+        h = hash(entries[i].key, buckets_n);
+        offset = snapshot_put(&buffer, &len, entries[i].key, entries[i].val);
+        at = offset;
+        memcpy(buffer + links[h], &at, sizeof(at));
+        links[h] = offset;
+    }
+    free(links);
+    free(entries);
+
+    header[2] = buckets_n;
+    header[3] = n;
+    header[4] = table->free_address;
+    memcpy(buffer, header, sizeof(header));
+    memcpy(buffer, TABLE_SNAPSHOT_MAGIC, 4);
+
+    if (!(stream = fopen(path, "wb"))) {
+        free(buffer);
+        return false;
+    }
+    written = fwrite(buffer, 1, len, stream) == len;
+    written = !fclose(stream) && written;
+
+    free(buffer);
+    return written;
+}
+
+/*
+ * Function: table_load
+ * --------------------
+ *  maps snapshot file as read only layer of the table, own entries of
+ *  the table shadow entries of the snapshot, free address of the table
+ *  becomes the saved one
+ *
+ *  snapshot is mapped and validated once per process and shared by every
+ *  table loading it, until the file changes (thread safe)
+ *
+ *  table: empty table without snapshot layer
+ *  path: snapshot file path
+ *
+ *  returns: true if the snapshot is valid and mapped
+ *           false otherwise
+ */
+bool table_load(table_t *table, const char *path)
+{
+    const snapshot_t *snapshot = snapshot_lookup(path);
+    size_t buckets_n;
+
+    if (!snapshot) {
+        return false;
+    }
+
+    /* own entries are hashed the way the snapshot is */
+    buckets_n = load_u32(snapshot->data, 8);
+    free(table->data);
+    table->data = calloc(buckets_n, sizeof(table_node_t *));
+    table->buckets_n = buckets_n;
+
+    table->free_address = load_u32(snapshot->data, 16);
+    table->snapshot = snapshot->data;
+    table->snapshot_len = snapshot->len;
+    return true;
 }
@@ -10,18 +10,40 @@
 #define HACK_ASM_TABLE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-#define TABLE_BUCKETS_N 127
+#define TABLE_BUCKETS_N 127 /* buckets of table without snapshot */
+
+/*
+ * snapshot layout (native byte order, offsets are relative to file start,
+ * so the file can be mapped anywhere):
+ *
+ *      "HSY3" u32 TABLE_SNAPSHOT_MARK u32 buckets_n u32 size
+ *      i32 free_address
+ *      u32 bucket_offset * buckets_n        (0 for empty bucket)
+ *      (u32 next_offset  i32 val  key '\0'  padding to 4 bytes) * size
+ *
+ *  buckets_n is the first prime not below size (and TABLE_BUCKETS_N), so
+ *  chains stay short however many symbols the snapshot holds
+ */
+#define TABLE_SNAPSHOT_MAGIC "HSY3" /* 3rd layout: free RAM address */
+#define TABLE_SNAPSHOT_MARK 0x01020304
 
 typedef struct table_node_t {
     char *key;
-    short val;
+    int32_t val;
     struct table_node_t *next;
 } table_node_t;
 
 typedef struct {
-    table_node_t *data[TABLE_BUCKETS_N];
+    table_node_t **data;
+    size_t buckets_n;
     size_t size;
+    int32_t free_address; /* first RAM address past variables (0 if none
+                             were allocated), saved with snapshot */
+    const char *snapshot; /* read only layer below own entries (or NULL) */
+    size_t snapshot_len;
 } table_t;
 
 /* Function: table_new
@@ -50,7 +72,7 @@ void table_del(table_t *table);
  *  symbol: key of new entry
  *  address: value of new entry
  */
-void table_add(table_t *table, const char *symbol, short address);
+void table_add(table_t *table, const char *symbol, int32_t address);
 
 /*
  * Function: table_contains
@@ -76,6 +98,38 @@ bool table_contains(table_t *table, const char *symbol);
  *  returns: address associated with symbol key
  *           -1 if symbol is not found
  */
-short table_get(table_t *table, const char *symbol);
+int32_t table_get(table_t *table, const char *symbol);
+
+/*
+ * Function: table_save
+ * --------------------
+ *  writes all entries of the table (including its snapshot layer) and
+ *  its free address as snapshot that can be loaded with table_load
+ *
+ *  table: table to save
+ *  path: snapshot file path
+ *
+ *  returns: true if the snapshot is written
+ *           false otherwise
+ */
+bool table_save(table_t *table, const char *path);
+
+/*
+ * Function: table_load
+ * --------------------
+ *  maps snapshot file as read only layer of the table, own entries of
+ *  the table shadow entries of the snapshot, free address of the table
+ *  becomes the saved one
+ *
+ *  snapshot is mapped and validated once per process and shared by every
+ *  table loading it, until the file changes (thread safe)
+ *
+ *  table: empty table without snapshot layer
+ *  path: snapshot file path
+ *
+ *  returns: true if the snapshot is valid and mapped
+ *           false otherwise
+ */
+bool table_load(table_t *table, const char *path);
 
 #endif // !HACK_ASM_TABLE_H
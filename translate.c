@@ -0,0 +1,281 @@
+/*
+ * File: translate.c
+ * -----------------
+ *  statically translates binary hack encodings into C source file which
+ *  runs the program natively once compiled
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cpu.h"
+#include "translate.h"
+
+/* runtime shared by every translated program, jump table and blocks are
+ * written between prologue and epilogue */
+static const char *prologue =
+    "/* generated by HackTranslator */\n"
+    "\n"
+    "#include <stdint.h>\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "#define ROM_SIZE %zu\n"
+    "#define RAM_SIZE 32768\n"
+    "#define M ram[a & 0x7FFF]\n"
+    "\n"
+    "/* budget is checked on every taken jump, so the run stops past it\n"
+    " * by at most the straight line code leading to the next one */\n"
+    "#define JUMP(t) \\\n"
+    "    do { \\\n"
+    "        if (cycles >= max_cycles) { \\\n"
+    "            goto out; \\\n"
+    "        } \\\n"
+    "        goto *rom[((t) & 0x7FFF) < ROM_SIZE ? ((t) & 0x7FFF) : ROM_SIZE]; \\\n"
+    "    } while (0)\n"
+    "\n"
+    "/* same as JUMP when target address is likely known at compile time */\n"
+    "#define JUMP_TO(t, k, label) \\\n"
+    "    do { \\\n"
+    "        if (cycles >= max_cycles) { \\\n"
+    "            goto out; \\\n"
+    "        } \\\n"
+    "        if ((t) == (k)) { \\\n"
+    "            goto label; \\\n"
+    "        } \\\n"
+    "        JUMP(t); \\\n"
+    "    } while (0)\n"
+    "\n"
+    "static uint16_t ram[RAM_SIZE];\n"
+    "\n"
+    "static inline uint16_t alu(uint16_t x, uint16_t y, unsigned c)\n"
+    "{\n"
+    "    uint16_t out;\n"
+    "\n"
+    "    x = (c & 0x20) ? 0 : x;\n"
+    "    x = (c & 0x10) ? ~x : x;\n"
+    "    y = (c & 0x08) ? 0 : y;\n"
+    "    y = (c & 0x04) ? ~y : y;\n"
+    "    out = (c & 0x02) ? x + y : x & y;\n"
+    "    return (c & 0x01) ? ~out : out;\n"
+    "}\n"
+    "\n"
+    "int main(int argc, char **argv)\n"
+    "{\n"
+    "    uint16_t a = 0, d = 0, v = 0, t = 0;\n"
+    "    uint64_t cycles = 0, max_cycles = UINT64_MAX;\n"
+    "    long dump = 16, address, value;\n"
+    "    int halted = 0;\n"
+    "    char end;\n"
+    "\n"
+    "    for (int i = 1; i + 1 < argc; i += 2) {\n"
+    "        if (!strcmp(argv[i], \"-n\")) {\n"
+    "            max_cycles = strtoull(argv[i + 1], NULL, 10);\n"
+    "        } else if (!strcmp(argv[i], \"-d\")) {\n"
+    "            dump = atol(argv[i + 1]);\n"
+    "        } else if (!strcmp(argv[i], \"-s\") && sscanf(argv[i + 1],\n"
+    "                \"%%ld=%%ld%%c\", &address, &value, &end) == 2\n"
+    "                && address >= 0 && address < RAM_SIZE) {\n"
+    "            ram[address] = (uint16_t) value;\n"
+    "        } else {\n"
+    "            fprintf(stderr, \"usage: %%s [-n cycles] [-d words] \"\n"
+    "                    \"[-s address=value]...\\n\", argv[0]);\n"
+    "            return 1;\n"
+    "        }\n"
+    "    }\n"
+    "    if (argc %% 2 == 0 || dump < 0 || dump > RAM_SIZE) {\n"
+    "        fprintf(stderr, \"usage: %%s [-n cycles] [-d words] \"\n"
+    "                \"[-s address=value]...\\n\", argv[0]);\n"
+    "        return 1;\n"
+    "    }\n"
+    "\n";
+
+static const char *epilogue =
+    "    goto halt;\n"
+    "\n"
+    "halt:\n"
+    "    halted = 1;\n"
+    "out:\n"
+    "    (void) v;\n"
+    "    (void) t;\n"
+    "    for (long i = 0; i < dump; i++) {\n"
+    "        printf(\"RAM[%ld] = %d\\n\", i, (int16_t) ram[i]);\n"
+    "    }\n"
+    "    fprintf(stderr, \"%s after %llu cycles\\n\",\n"
+    "            halted ? \"halted\" : \"stopped\", (unsigned long long) cycles);\n"
+    "    return 0;\n"
+    "}\n";
+
+/*
+ * Function: comp_expr
+ * -------------------
+ *  finds C expression computing 'comp' mnemonic
+ *
+ *  comp: 7 bit 'comp' code
+ *
+ *  returns: C expression over 'a', 'd' and 'M'
+ *           NULL if 'comp' is not a standard mnemonic
+ */
+static const char *comp_expr(uint8_t comp)
+{
+#define TRANSLATE_COMP(name, code, expr)  \
+    if (comp == (code)) {                 \
+        return #expr;                     \
+    }
+    CPU_COMPS(TRANSLATE_COMP)
+#undef TRANSLATE_COMP
+
+    return NULL;
+}
+
+/*
+ * Function: jump_cond
+ * -------------------
+ *  finds C condition over ALU output 'v' for conditional 'jump' bits
+ *
+ *  jump: 3 bit 'jump' code (between 1 and 6)
+ *
+ *  returns: C condition
+ */
+static const char *jump_cond(uint8_t jump)
+{
+    static const char *conds[] = {
+        [1] = "(int16_t) v > 0",  /* JGT */
+        [2] = "v == 0",           /* JEQ */
+        [3] = "(int16_t) v >= 0", /* JGE */
+        [4] = "(int16_t) v < 0",  /* JLT */
+        [5] = "v != 0",           /* JNE */
+        [6] = "(int16_t) v <= 0", /* JLE */
+    };
+
+    return conds[jump];
+}
+
+/*
+ * Function: write_jump
+ * --------------------
+ *  writes jump to the address held in 't'
+ *
+ *  stream: writable C source stream
+ *  words: hack commands encoded by code module
+ *  n: amount of words
+ *  address: ROM address of jumping C command
+ */
+static void write_jump(FILE *stream, const uint16_t *words,
+        size_t n, size_t address)
+{
+    uint16_t target;
+
+    /* '@k' right before the jump most likely still holds the target */
+    if (address > 0 && !(words[address - 1] & 0x8000)) {
+        target = words[address - 1];
+        if (target < n) {
+            fprintf(stream, "JUMP_TO(t, %u, L%u);", target, target);
+        } else {
+            fprintf(stream, "JUMP_TO(t, %u, halt);", target);
+        }
+        return;
+    }
+
+    fprintf(stream, "JUMP(t);");
+}
+
+/*
+ * Function: write_c_block
+ * -----------------------
+ *  writes translation of C command
+ *
+ *  stream: writable C source stream
+ *  words: hack commands encoded by code module
+ *  n: amount of words
+ *  address: ROM address of C command
+ */
+static void write_c_block(FILE *stream, const uint16_t *words,
+        size_t n, size_t address)
+{
+    uint8_t comp = (words[address] >> 6) & 0x7F;
+    uint8_t dest = (words[address] >> 3) & 0x07;
+    uint8_t jump = words[address] & 0x07;
+    const char *expr = comp_expr(comp);
+
+    if (expr) {
+        fprintf(stream, " v = (uint16_t) (%s);", expr);
+    } else {
+        fprintf(stream, " v = alu(d, %s, 0x%02X);",
+                (comp & 0x40) ? "M" : "a", comp & 0x3F);
+    }
+
+    /* jump target and M address are A before the command */
+    if (jump) {
+        fprintf(stream, " t = a;");
+    }
+    if (dest & 1) {
+        fprintf(stream, " M = v;");
+    }
+    if (dest & 2) {
+        fprintf(stream, " d = v;");
+    }
+    if (dest & 4) {
+        fprintf(stream, " a = v;");
+    }
+
+    if (jump == 7) {
+        fprintf(stream, " ");
+        write_jump(stream, words, n, address);
+    } else if (jump) {
+        fprintf(stream, " if (%s) { ", jump_cond(jump));
+        write_jump(stream, words, n, address);
+        fprintf(stream, " }");
+    }
+}
+
+/*
+ * Function: translate_program
+ * ---------------------------
+ *  writes C translation of the program to the stream
+ *
+ *  every ROM address becomes a labeled block, A, D registers are local
+ *  variables and computed jumps go through dense jump table; compiled
+ *  program accepts the same '-n', '-d' and '-s' options as HackSimulator,
+ *  its cycle budget is checked on taken jumps only, so it may run past
+ *  the budget by the straight line code leading to the next taken jump
+ *
+ *  stream: writable C source stream
+ *  words: hack commands encoded by code module
+ *  n: amount of words
+ */
+void translate_program(FILE *stream, const uint16_t *words, size_t n)
+{
+    size_t i;
+
+    fprintf(stream, prologue, n);
+
+    /* dense jump table, last slot catches addresses past the program */
+    fprintf(stream, "    static const void *rom[ROM_SIZE + 1] = {\n");
+    for (i = 0; i < n; i++) {
+        fprintf(stream, "        &&L%zu,\n", i);
+    }
+    fprintf(stream, "        &&halt\n    };\n\n");
+    fprintf(stream, "    goto *rom[0];\n\n");
+
+    for (i = 0; i < n; i++) {
+        fprintf(stream, "L%zu:", i);
+
+        if (cpu_is_halt(words, n, i)) {
+            fprintf(stream, " goto halt;\n");
+            continue;
+        }
+
+        fprintf(stream, " cycles++;");
+        if (!(words[i] & 0x8000)) {
+            fprintf(stream, " a = %u;", words[i]);
+        } else {
+            write_c_block(stream, words, n, i);
+        }
+        fprintf(stream, "\n");
+    }
+
+    fputs(epilogue, stream);
+}
@@ -0,0 +1,33 @@
+/*
+ * File: translate.h
+ * -----------------
+ *  function declarations for translate module
+ *
+ *  statically translates binary hack encodings into C source file which
+ *  runs the program natively once compiled
+ */
+
+#ifndef HACK_ASM_TRANSLATE_H
+#define HACK_ASM_TRANSLATE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Function: translate_program
+ * ---------------------------
+ *  writes C translation of the program to the stream
+ *
+ *  every ROM address becomes a labeled block, A, D registers are local
+ *  variables and computed jumps go through dense jump table; compiled
+ *  program accepts the same '-n', '-d' and '-s' options as HackSimulator,
+ *  its cycle budget is checked on taken jumps only, so it may run past
+ *  the budget by the straight line code leading to the next taken jump
+ *
+ *  stream: writable C source stream
+ *  words: hack commands encoded by code module
+ *  n: amount of words
+ */
+void translate_program(FILE *stream, const uint16_t *words, size_t n);
+
+#endif // !HACK_ASM_TRANSLATE_H
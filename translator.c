@@ -0,0 +1,80 @@
+/*
+ * File: translator.c
+ * ------------------
+ *  entry point for hack translator program
+ *
+ *  translates assembled program into C source file placed next to it
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "helpers.h"
+#include "translate.h"
+
+#define TRANSLATION_SUFFIX ".c"
+
+/*
+ * Function: write_help_msg
+ * ------------------------
+ *  writes help message for HackTranslator user
+ */
+static void write_help_msg(void)
+{
+    printf("\nUsage: HackTranslator program\n\n"
+           "Translate assembled HACK program into C source file.\n\n"
+           "Arguments:\n"
+           "program(required)\tprogram file path (must have .hack suffix)\n\n");
+}
+
+int main(int argc, char **argv)
+{
+    char *output;
+    size_t prefix_len;
+    FILE *input_stream, *output_stream;
+    uint16_t *words;
+    long n;
+
+    if (argc != 2 || !str_ends_with(argv[1], OUTPUT_SUFFIX)) {
+        write_help_msg();
+        exit(1);
+    }
+
+    if (!(input_stream = fopen(argv[1], "r"))) {
+        fprintf(stderr, "HackTranslator: can't open %s\n", argv[1]);
+        exit(1);
+    }
+
+    words = malloc(CPU_ROM_SIZE * sizeof(uint16_t));
+    n = cpu_read_hack(input_stream, words);
+    fclose(input_stream);
+
+    if (n < 0) {
+        fprintf(stderr, "HackTranslator: %s is not a valid program\n", argv[1]);
+        exit(1);
+    }
+
+    /* replace .hack suffix with .c one */
+    prefix_len = strlen(argv[1]) - strlen(OUTPUT_SUFFIX);
+    output = malloc(prefix_len + strlen(TRANSLATION_SUFFIX) + 1);
+    memcpy(output, argv[1], prefix_len);
+    strcpy(output + prefix_len, TRANSLATION_SUFFIX);
+
+    if (!(output_stream = fopen(output, "w"))) {
+        fprintf(stderr, "HackTranslator: can't open %s\n", output);
+        exit(1);
+    }
+
+    translate_program(output_stream, words, n);
+
+    /* cleanup */
+    free(words);
+    free(output);
+    fclose(output_stream);
+
+    return 0;
+}
@@ -0,0 +1,993 @@
+/*
+ * File: vm.c
+ * ----------
+ *  translates stack VM code straight into encoded assembler commands
+ */
+
+#include <dirent.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "assembler.h"
+#include "code.h"
+#include "decompress.h"
+#include "helpers.h"
+#include "parser.h"
+#include "table.h"
+#include "vm.h"
+
+/* segments addressed through base pointer */
+static const struct {
+    const char *name;
+    int32_t base;
+} pointer_segments[] = {
+    { "local", VM_LCL },
+    { "argument", VM_ARG },
+    { "this", VM_THIS },
+    { "that", VM_THAT },
+};
+
+/* binary operators combine y in D with x in M */
+static const char *binary_ops[][2] = {
+    { "add", "M=D+M" },
+    { "sub", "M=M-D" },
+    { "and", "M=D&M" },
+    { "or", "M=D|M" },
+};
+
+static const char *unary_ops[][2] = {
+    { "neg", "M=-M" },
+    { "not", "M=!M" },
+};
+
+static const char *compare_ops[][2] = {
+    { "eq", "D;JEQ" },
+    { "gt", "D;JGT" },
+    { "lt", "D;JLT" },
+};
+
+/* saved by call in this order, restored by return in reverse */
+static const int32_t frame_pointers[] = { VM_LCL, VM_ARG, VM_THIS, VM_THAT };
+
+/*
+ * Function: format_name
+ * ---------------------
+ *  formats symbol name
+ *
+ *  format: printf format
+ *
+ *  returns: allocated name
+ */
+static char *format_name(const char *format, ...)
+{
+    va_list args;
+    char *name;
+    int len;
+
+    va_start(args, format);
+    len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    name = malloc(len + 1);
+    va_start(args, format);
+    vsnprintf(name, len + 1, format, args);
+    va_end(args);
+    return name;
+}
+
+/*
+ * Function: vm_error
+ * ------------------
+ *  reports invalid VM command and marks translation failed, only the
+ *  first error is reported (later ones may follow from it)
+ *
+ *  vm: translator
+ *  format: printf format of the message
+ */
+static void vm_error(vm_translator_t *vm, const char *format, ...)
+{
+    va_list args;
+
+    if (vm->failed) {
+        return;
+    }
+    vm->failed = true;
+    fprintf(stderr, "HackAssembler: %s:%zu: ", vm->path, vm->line);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+/*
+ * Function: vm_append
+ * -------------------
+ *  appends command taking ROM word
+ *  fails translation if the word lands past ROM
+ *
+ *  vm: translator
+ *  command: A or C command
+ */
+static void vm_append(vm_translator_t *vm, asm_command_t *command)
+{
+    if (vm->words > vm->limit) {
+        vm_error(vm, "program doesn't fit into ROM of %lld words%s",
+                (long long) vm->limit + 1,
+                vm->limit < HACK_EXTENDED_MAX_ADDRESS ? " (see -X)" : "");
+    }
+    if (vm->n == vm->capacity) {
+        vm->capacity = vm->capacity
+            ? 2 * vm->capacity : COMMANDS_INIT_CAPACITY;
+        vm->commands = realloc(vm->commands,
+                vm->capacity * sizeof(asm_command_t *));
+    }
+    command->file = vm->file;
+    vm->commands[vm->n++] = command;
+    vm->words++;
+}
+
+/*
+ * Function: emit_a
+ * ----------------
+ *  appends A command
+ *
+ *  vm: translator
+ *  symbol: allocated operand
+ */
+static void emit_a(vm_translator_t *vm, char *symbol)
+{
+    vm_append(vm, command_new_from(A_COMMAND, symbol, NULL, NULL, NULL,
+                vm->line));
+}
+
+/*
+ * Function: emit_at
+ * -----------------
+ *  appends A command loading symbol
+ */
+static void emit_at(vm_translator_t *vm, const char *symbol)
+{
+    emit_a(vm, strdup(symbol));
+}
+
+/*
+ * Function: emit_at_number
+ * ------------------------
+ *  appends A command loading number
+ */
+static void emit_at_number(vm_translator_t *vm, int32_t value)
+{
+    emit_a(vm, format_name("%d", value));
+}
+
+/*
+ * Function: emit_forward
+ * ----------------------
+ *  appends A command loading address of code generated later, so it
+ *  needs no label
+ *
+ *  vm: translator
+ *
+ *  returns: index of the command for 'bind_forward'
+ */
+static size_t emit_forward(vm_translator_t *vm)
+{
+    emit_a(vm, NULL);
+    return vm->n - 1;
+}
+
+/*
+ * Function: bind_forward
+ * ----------------------
+ *  makes A command appended by 'emit_forward' load ROM address of the
+ *  next command
+ *  fails translation if the address is past ROM
+ *
+ *  vm: translator
+ *  index: index of the command
+ */
+static void bind_forward(vm_translator_t *vm, size_t index)
+{
+    if (vm->words > vm->limit) {
+        vm_error(vm, "jump target %lld is out of range",
+                (long long) vm->words);
+    }
+    vm->commands[index]->symbol = format_name("%lld", (long long) vm->words);
+}
+
+/*
+ * Function: emit_c
+ * ----------------
+ *  appends C command, encoded right away
+ *
+ *  vm: translator
+ *  text: whitespace stripped C command
+ */
+static void emit_c(vm_translator_t *vm, const char *text)
+{
+    asm_command_t *command = command_new_from(C_COMMAND, NULL, NULL, NULL,
+            NULL, vm->line);
+
+    command->code = encode_cached(text)->code;
+    vm_append(vm, command);
+}
+
+/*
+ * Function: add_site
+ * ------------------
+ *  records the line being translated
+ *
+ *  vm: translator
+ *
+ *  returns: index of the site
+ */
+static int32_t add_site(vm_translator_t *vm)
+{
+    vm->sites = realloc(vm->sites, (vm->sites_n + 1) * sizeof(vm_site_t));
+    vm->sites[vm->sites_n].path = vm->path;
+    vm->sites[vm->sites_n].line = vm->line;
+    return vm->sites_n++;
+}
+
+/*
+ * Function: define_label
+ * ----------------------
+ *  binds label to ROM address of the next command
+ *  fails translation if the label is already defined or the address is
+ *  past ROM
+ *
+ *  vm: translator
+ *  label: allocated label name (freed)
+ */
+static void define_label(vm_translator_t *vm, char *label)
+{
+    int32_t site = table_get(vm->labels, label);
+
+    if (site >= 0) {
+        vm_error(vm, "%s is already defined at %s:%zu", label,
+                vm->sites[site].path, vm->sites[site].line);
+    } else if (vm->words > vm->limit) {
+        vm_error(vm, "label %s at ROM address %lld is out of range", label,
+                (long long) vm->words);
+    } else {
+        table_add(vm->labels, label, add_site(vm));
+        table_add(vm->table, label, vm->words);
+    }
+    free(label);
+}
+
+/*
+ * Function: use_label
+ * -------------------
+ *  records 'goto' target, so it can be checked once every label is
+ *  defined
+ *
+ *  vm: translator
+ *  label: label name
+ */
+static void use_label(vm_translator_t *vm, const char *label)
+{
+    if (!table_contains(vm->jumps, label)) {
+        table_add(vm->jumps, label, add_site(vm));
+    }
+}
+
+/*
+ * Function: scoped_label
+ * ----------------------
+ *  names label of the current function (or file outside of functions)
+ *
+ *  vm: translator
+ *  label: label as written in VM code
+ *
+ *  returns: allocated label name
+ */
+static char *scoped_label(const vm_translator_t *vm, const char *label)
+{
+    return format_name("%s$%s", vm->function ? vm->function : vm->module,
+            label);
+}
+
+/*
+ * Function: push_d
+ * ----------------
+ *  appends commands pushing D on the stack
+ */
+static void push_d(vm_translator_t *vm)
+{
+    emit_at_number(vm, VM_SP);
+    emit_c(vm, "AM=M+1");
+    emit_c(vm, "A=A-1");
+    emit_c(vm, "M=D");
+}
+
+/*
+ * Function: pop_d
+ * ---------------
+ *  appends commands popping top of the stack into D, A points to the
+ *  popped slot afterwards
+ */
+static void pop_d(vm_translator_t *vm)
+{
+    emit_at_number(vm, VM_SP);
+    emit_c(vm, "AM=M-1");
+    emit_c(vm, "D=M");
+}
+
+/*
+ * Function: parse_index
+ * ---------------------
+ *  converts segment index
+ *  terminates program if it isn't a number below 'size'
+ *
+ *  vm: translator
+ *  index: index as written in VM code
+ *  size: size of the segment
+ *
+ *  returns: value of the index
+ */
+static int32_t parse_index(vm_translator_t *vm, const char *index,
+        int32_t size)
+{
+    int32_t value = 0;
+
+    if (!index || !*index || !str_isnum(index)) {
+        vm_error(vm, "invalid segment index %s", index ? index : "");
+        return 0;
+    }
+    for (const char *p = index; *p; p++) {
+        value = 10 * value + (*p - '0');
+        if (value >= size) {
+            vm_error(vm, "segment index %s is out of range (max %d)",
+                    index, size - 1);
+            return 0;
+        }
+    }
+    return value;
+}
+
+/*
+ * Function: direct_symbol
+ * -----------------------
+ *  names RAM word of temp, pointer or static segment entry
+ *
+ *  vm: translator
+ *  segment: segment name
+ *  index: index as written in VM code
+ *
+ *  returns: allocated symbol
+ *           NULL if segment isn't addressed directly
+ */
+static char *direct_symbol(vm_translator_t *vm, const char *segment,
+        const char *index)
+{
+    if (!strcmp(segment, "temp")) {
+        return format_name("%d",
+                VM_TEMP_BASE + parse_index(vm, index, VM_TEMP_SIZE));
+    }
+    if (!strcmp(segment, "pointer")) {
+        return format_name("%d",
+                VM_POINTER_BASE + parse_index(vm, index, VM_POINTER_SIZE));
+    }
+    if (!strcmp(segment, "static")) {
+        return format_name("%s.%d", vm->module,
+                parse_index(vm, index, HACK_ROM_SIZE));
+    }
+    return NULL;
+}
+
+/*
+ * Function: base_pointer
+ * ----------------------
+ *  finds base pointer of local, argument, this or that segment
+ *
+ *  segment: segment name
+ *
+ *  returns: address of base pointer
+ *           -1 if segment isn't addressed through base pointer
+ */
+static int32_t base_pointer(const char *segment)
+{
+    for (size_t i = 0; i < sizeof(pointer_segments)
+            / sizeof(pointer_segments[0]); i++) {
+        if (!strcmp(segment, pointer_segments[i].name)) {
+            return pointer_segments[i].base;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Function: translate_push
+ * ------------------------
+ *  appends commands of 'push segment index'
+ */
+static void translate_push(vm_translator_t *vm, const char *segment,
+        const char *index)
+{
+    int32_t base = base_pointer(segment);
+    char *symbol;
+    int32_t value;
+
+    if (!strcmp(segment, "constant")) {
+        value = parse_index(vm, index, HACK_ROM_SIZE);
+        /* 0 and 1 are stored without passing through D */
+        if (value <= 1) {
+            emit_at_number(vm, VM_SP);
+            emit_c(vm, "AM=M+1");
+            emit_c(vm, "A=A-1");
+            emit_c(vm, value ? "M=1" : "M=0");
+            return;
+        }
+        emit_at_number(vm, value);
+        emit_c(vm, "D=A");
+    } else if (base >= 0) {
+        value = parse_index(vm, index, HACK_ROM_SIZE);
+        if (value == 0) {
+            emit_at_number(vm, base);
+            emit_c(vm, "A=M");
+        } else {
+            emit_at_number(vm, value);
+            emit_c(vm, "D=A");
+            emit_at_number(vm, base);
+            emit_c(vm, "A=D+M");
+        }
+        emit_c(vm, "D=M");
+    } else if ((symbol = direct_symbol(vm, segment, index))) {
+        emit_a(vm, symbol);
+        emit_c(vm, "D=M");
+    } else {
+        vm_error(vm, "unknown segment %s", segment);
+    }
+    push_d(vm);
+}
+
+/*
+ * Function: translate_pop
+ * -----------------------
+ *  appends commands of 'pop segment index'
+ */
+static void translate_pop(vm_translator_t *vm, const char *segment,
+        const char *index)
+{
+    int32_t base = base_pointer(segment);
+    char *symbol;
+    int32_t value;
+
+    if (base >= 0) {
+        value = parse_index(vm, index, HACK_ROM_SIZE);
+        if (value == 0) {
+            pop_d(vm);
+            emit_at_number(vm, base);
+            emit_c(vm, "A=M");
+            emit_c(vm, "M=D");
+            return;
+        }
+        /* target address waits in R13 while the stack is popped */
+        emit_at_number(vm, value);
+        emit_c(vm, "D=A");
+        emit_at_number(vm, base);
+        emit_c(vm, "D=D+M");
+        emit_at_number(vm, VM_R13);
+        emit_c(vm, "M=D");
+        pop_d(vm);
+        emit_at_number(vm, VM_R13);
+        emit_c(vm, "A=M");
+        emit_c(vm, "M=D");
+    } else if ((symbol = direct_symbol(vm, segment, index))) {
+        pop_d(vm);
+        emit_a(vm, symbol);
+        emit_c(vm, "M=D");
+    } else {
+        vm_error(vm, "can't pop into segment %s", segment);
+    }
+}
+
+/*
+ * Function: translate_operator
+ * ----------------------------
+ *  appends commands of arithmetic or logical command
+ *
+ *  vm: translator
+ *  name: command name
+ *
+ *  returns: true if the name is an operator
+ *           false otherwise
+ */
+static bool translate_operator(vm_translator_t *vm, const char *name)
+{
+    for (size_t i = 0; i < sizeof(binary_ops) / sizeof(binary_ops[0]); i++) {
+        if (!strcmp(name, binary_ops[i][0])) {
+            pop_d(vm);
+            emit_c(vm, "A=A-1");
+            emit_c(vm, binary_ops[i][1]);
+            return true;
+        }
+    }
+    for (size_t i = 0; i < sizeof(unary_ops) / sizeof(unary_ops[0]); i++) {
+        if (!strcmp(name, unary_ops[i][0])) {
+            emit_at_number(vm, VM_SP);
+            emit_c(vm, "A=M-1");
+            emit_c(vm, unary_ops[i][1]);
+            return true;
+        }
+    }
+    for (size_t i = 0; i < sizeof(compare_ops) / sizeof(compare_ops[0]);
+            i++) {
+        if (!strcmp(name, compare_ops[i][0])) {
+            /* x is assumed true and cleared unless the jump skips it */
+            size_t skip;
+
+            pop_d(vm);
+            emit_c(vm, "A=A-1");
+            emit_c(vm, "D=M-D");
+            emit_c(vm, "M=-1");
+            skip = emit_forward(vm);
+            emit_c(vm, compare_ops[i][1]);
+            emit_at_number(vm, VM_SP);
+            emit_c(vm, "A=M-1");
+            emit_c(vm, "M=0");
+            bind_forward(vm, skip);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Function: translate_call
+ * ------------------------
+ *  appends commands of 'call function args': saves frame of the caller
+ *  and jumps to the function
+ */
+static void translate_call(vm_translator_t *vm, const char *function,
+        const char *args)
+{
+    int32_t n = parse_index(vm, args, HACK_ROM_SIZE - VM_FRAME_SIZE);
+    size_t ret;
+
+    ret = emit_forward(vm);
+    emit_c(vm, "D=A");
+    push_d(vm);
+    for (size_t i = 0; i < sizeof(frame_pointers) / sizeof(frame_pointers[0]);
+            i++) {
+        emit_at_number(vm, frame_pointers[i]);
+        emit_c(vm, "D=M");
+        push_d(vm);
+    }
+
+    /* ARG = SP - args - frame, LCL = SP */
+    emit_at_number(vm, VM_SP);
+    emit_c(vm, "D=M");
+    emit_at_number(vm, n + VM_FRAME_SIZE);
+    emit_c(vm, "D=D-A");
+    emit_at_number(vm, VM_ARG);
+    emit_c(vm, "M=D");
+    emit_at_number(vm, VM_SP);
+    emit_c(vm, "D=M");
+    emit_at_number(vm, VM_LCL);
+    emit_c(vm, "M=D");
+    emit_at(vm, function);
+    emit_c(vm, "0;JMP");
+    bind_forward(vm, ret);
+
+    table_add(vm->calls, function, 1);
+}
+
+/*
+ * Function: translate_return
+ * --------------------------
+ *  appends commands of 'return': moves return value to the caller's top
+ *  of the stack, restores its frame and jumps back
+ */
+static void translate_return(vm_translator_t *vm)
+{
+    /* R13 = frame, R14 = return address */
+    emit_at_number(vm, VM_LCL);
+    emit_c(vm, "D=M");
+    emit_at_number(vm, VM_R13);
+    emit_c(vm, "M=D");
+    emit_at_number(vm, VM_FRAME_SIZE);
+    emit_c(vm, "A=D-A");
+    emit_c(vm, "D=M");
+    emit_at_number(vm, VM_R14);
+    emit_c(vm, "M=D");
+
+    /* *ARG = pop(), SP = ARG + 1 */
+    pop_d(vm);
+    emit_at_number(vm, VM_ARG);
+    emit_c(vm, "A=M");
+    emit_c(vm, "M=D");
+    emit_at_number(vm, VM_ARG);
+    emit_c(vm, "D=M+1");
+    emit_at_number(vm, VM_SP);
+    emit_c(vm, "M=D");
+
+    for (size_t i = sizeof(frame_pointers) / sizeof(frame_pointers[0]);
+            i-- > 0;) {
+        emit_at_number(vm, VM_R13);
+        emit_c(vm, "AM=M-1");
+        emit_c(vm, "D=M");
+        emit_at_number(vm, frame_pointers[i]);
+        emit_c(vm, "M=D");
+    }
+
+    emit_at_number(vm, VM_R14);
+    emit_c(vm, "A=M");
+    emit_c(vm, "0;JMP");
+}
+
+/*
+ * Function: translate_function
+ * ----------------------------
+ *  defines function label and appends commands clearing its locals
+ */
+static void translate_function(vm_translator_t *vm, const char *function,
+        const char *locals)
+{
+    int32_t n = parse_index(vm, locals, HACK_ROM_SIZE);
+
+    free(vm->function);
+    vm->function = strdup(function);
+    define_label(vm, strdup(function));
+
+    for (int32_t i = 0; i < n; i++) {
+        emit_at_number(vm, VM_SP);
+        emit_c(vm, "AM=M+1");
+        emit_c(vm, "A=A-1");
+        emit_c(vm, "M=0");
+    }
+}
+
+/*
+ * Function: translate_command
+ * ---------------------------
+ *  appends commands of single VM command
+ *  fails translation if the command is invalid
+ *
+ *  vm: translator
+ *  args: command name followed by its arguments
+ *  n: amount of words in 'args'
+ */
+static void translate_command(vm_translator_t *vm, char **args, int n)
+{
+    static const struct {
+        const char *name;
+        int args;
+    } arities[] = {
+        { "push", 2 }, { "pop", 2 }, { "label", 1 }, { "goto", 1 },
+        { "if-goto", 1 }, { "function", 2 }, { "call", 2 }, { "return", 0 },
+    };
+    char *label;
+
+    for (size_t i = 0; i < sizeof(arities) / sizeof(arities[0]); i++) {
+        if (!strcmp(args[0], arities[i].name) && n != arities[i].args + 1) {
+            vm_error(vm, "%s takes %d argument%s", args[0], arities[i].args,
+                    arities[i].args == 1 ? "" : "s");
+            return;
+        }
+    }
+
+    if (!strcmp(args[0], "push")) {
+        translate_push(vm, args[1], args[2]);
+    } else if (!strcmp(args[0], "pop")) {
+        translate_pop(vm, args[1], args[2]);
+    } else if (!strcmp(args[0], "label")) {
+        define_label(vm, scoped_label(vm, args[1]));
+    } else if (!strcmp(args[0], "goto")) {
+        label = scoped_label(vm, args[1]);
+        use_label(vm, label);
+        emit_a(vm, label);
+        emit_c(vm, "0;JMP");
+    } else if (!strcmp(args[0], "if-goto")) {
+        label = scoped_label(vm, args[1]);
+        use_label(vm, label);
+        pop_d(vm);
+        emit_a(vm, label);
+        emit_c(vm, "D;JNE");
+    } else if (!strcmp(args[0], "function")) {
+        translate_function(vm, args[1], args[2]);
+    } else if (!strcmp(args[0], "call")) {
+        translate_call(vm, args[1], args[2]);
+    } else if (!strcmp(args[0], "return")) {
+        translate_return(vm);
+    } else if (!translate_operator(vm, args[0])) {
+        vm_error(vm, "unknown VM command %s", args[0]);
+    } else if (n > 1) {
+        vm_error(vm, "%s takes no arguments", args[0]);
+    }
+}
+
+/*
+ * Function: module_name
+ * ---------------------
+ *  strips directory, compression suffix and '.vm' suffix of the path
+ *
+ *  path: VM file path
+ *
+ *  returns: allocated module name
+ */
+static char *module_name(const char *path)
+{
+    const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    size_t len = strlen(base) - decompress_suffix_len(base);
+
+    if (len >= strlen(VM_SUFFIX)
+            && !strncmp(base + len - strlen(VM_SUFFIX), VM_SUFFIX,
+                strlen(VM_SUFFIX))) {
+        len -= strlen(VM_SUFFIX);
+    }
+    return strndup(base, len);
+}
+
+/*
+ * Function: vm_is_project
+ * -----------------------
+ *  checks wether the path names VM project directory
+ *
+ *  path: file path
+ *
+ *  returns: true if path is directory
+ *           false otherwise
+ */
+bool vm_is_project(const char *path)
+{
+    struct stat st;
+
+    return !stat(path, &st) && S_ISDIR(st.st_mode);
+}
+
+/*
+ * Function: vm_is_source
+ * ----------------------
+ *  checks wether the path names VM code: '.vm' file (plain or compressed
+ *  with format supported by this build) or project directory
+ *
+ *  path: file path
+ *
+ *  returns: true if path is VM file or directory
+ *           false otherwise
+ */
+bool vm_is_source(const char *path)
+{
+    size_t len = strlen(path);
+    char *plain;
+    bool ok;
+
+    if (str_ends_with(path, VM_SUFFIX)) {
+        return true;
+    }
+    if (decompress_supported(path)) {
+        plain = strndup(path, len - decompress_suffix_len(path));
+        ok = str_ends_with(plain, VM_SUFFIX);
+        free(plain);
+        return ok;
+    }
+    return vm_is_project(path);
+}
+
+/*
+ * Function: vm_translator_new
+ * ---------------------------
+ *  creates translator placing labels into given table
+ *
+ *  table: symbol table (builtins already added)
+ *  limit: largest valid ROM address
+ *
+ *  returns: pointer to allocated translator
+ */
+vm_translator_t *vm_translator_new(table_t *table, int32_t limit)
+{
+    vm_translator_t *vm = calloc(1, sizeof(vm_translator_t));
+
+    vm->table = table;
+    vm->limit = limit;
+    vm->calls = table_new();
+    vm->labels = table_new();
+    vm->jumps = table_new();
+    return vm;
+}
+
+/*
+ * Function: vm_translate
+ * ----------------------
+ *  translates every VM command of the stream, stopping at the first
+ *  invalid one (translation is failed then)
+ *
+ *  vm: translator
+ *  stream: VM code stream
+ *  path: path of VM file (names its static variables)
+ *  file: file recorded in generated commands (NULL for the source itself)
+ */
+void vm_translate(vm_translator_t *vm, FILE *stream, const char *path,
+        const char *file)
+{
+    char line[VM_MAXLINE], *args[4], *comment, *save;
+    int n;
+
+    free(vm->module);
+    free(vm->function);
+    vm->module = module_name(path);
+    vm->function = NULL;
+    vm->path = path;
+    vm->file = file;
+    vm->line = 0;
+
+    while (!vm->failed && fgets(line, sizeof(line), stream)) {
+        vm->line++;
+        if ((comment = strstr(line, "//"))) {
+            *comment = '\0';
+        }
+
+        n = 0;
+        for (char *word = strtok_r(line, " \t\r\n", &save); word;
+                word = strtok_r(NULL, " \t\r\n", &save)) {
+            if (n == 3) {
+                vm_error(vm, "too many arguments of %s", args[0]);
+                break;
+            }
+            args[n++] = word;
+        }
+        if (n > 0 && !vm->failed) {
+            args[n] = NULL;
+            translate_command(vm, args, n);
+        }
+    }
+}
+
+/*
+ * Function: compare_names
+ * -----------------------
+ *  orders file names for 'qsort'
+ */
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/*
+ * Function: vm_translate_project
+ * ------------------------------
+ *  translates every '.vm' file of the directory in name order, after
+ *  bootstrap code if there is 'Sys.vm' among them
+ *  fails translation if any file can't be read or is invalid
+ *
+ *  vm: translator
+ *  dir: project directory
+ */
+void vm_translate_project(vm_translator_t *vm, const char *dir)
+{
+    DIR *stream = opendir(dir);
+    struct dirent *entry;
+    size_t first = vm->files_n;
+    bool bootstrap = false;
+    FILE *file;
+
+    if (!stream) {
+        fprintf(stderr, "HackAssembler: can't open %s\n", dir);
+        vm->failed = true;
+        return;
+    }
+    while ((entry = readdir(stream))) {
+        if (!str_ends_with(entry->d_name, VM_SUFFIX)) {
+            continue;
+        }
+        bootstrap = bootstrap || !strcmp(entry->d_name, VM_ENTRY_FILE);
+        vm->files = realloc(vm->files, (vm->files_n + 1) * sizeof(char *));
+        vm->files[vm->files_n++] = format_name("%s/%s", dir, entry->d_name);
+    }
+    closedir(stream);
+
+    if (vm->files_n == first) {
+        fprintf(stderr, "HackAssembler: no VM files in %s\n", dir);
+        vm->failed = true;
+        return;
+    }
+    qsort(vm->files + first, vm->files_n - first, sizeof(char *),
+            compare_names);
+
+    /* SP = 256, call Sys.init 0 */
+    if (bootstrap) {
+        vm->path = dir;
+        vm->file = NULL;
+        vm->line = 0;
+        free(vm->module);
+        vm->module = strdup("");
+        emit_at_number(vm, VM_STACK_BASE);
+        emit_c(vm, "D=A");
+        emit_at_number(vm, VM_SP);
+        emit_c(vm, "M=D");
+        translate_call(vm, VM_ENTRY, "0");
+    }
+
+    for (size_t i = first; i < vm->files_n && !vm->failed; i++) {
+        if (!(file = fopen(vm->files[i], "r"))) {
+            fprintf(stderr, "HackAssembler: can't open %s\n", vm->files[i]);
+            vm->failed = true;
+            return;
+        }
+        vm_translate(vm, file, vm->files[i], vm->files[i]);
+        fclose(file);
+    }
+}
+
+/*
+ * Function: vm_commands
+ * ---------------------
+ *  hands generated commands over to the caller
+ *  fails translation if any called function or 'goto' target isn't
+ *  defined
+ *
+ *  !!! user in charge of freeing commands (before the translator, they
+ *      point to its file paths)
+ *
+ *  vm: translator
+ *  n_ptr: amount of commands
+ *
+ *  returns: list of generated commands
+ */
+asm_command_t **vm_commands(vm_translator_t *vm, size_t *n_ptr)
+{
+    asm_command_t **commands = vm->commands;
+
+    /* undefined calls of failed translation may follow from its error */
+    for (size_t i = 0; i < vm->calls->buckets_n && !vm->failed; i++) {
+        for (table_node_t *node = vm->calls->data[i]; node;
+                node = node->next) {
+            if (!table_contains(vm->table, node->key)) {
+                fprintf(stderr, "HackAssembler: function %s is called but "
+                        "never defined\n", node->key);
+                vm->failed = true;
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < vm->jumps->buckets_n && !vm->failed; i++) {
+        for (table_node_t *node = vm->jumps->data[i]; node;
+                node = node->next) {
+            if (!table_contains(vm->labels, node->key)) {
+                fprintf(stderr, "HackAssembler: %s:%zu: label %s is used "
+                        "but never defined\n", vm->sites[node->val].path,
+                        vm->sites[node->val].line, node->key);
+                vm->failed = true;
+                break;
+            }
+        }
+    }
+
+    *n_ptr = vm->n;
+    vm->commands = NULL;
+    vm->n = vm->capacity = 0;
+    return commands;
+}
+
+/*
+ * Function: vm_translator_del
+ * ---------------------------
+ *  frees memory allocated by translator
+ *
+ *  vm: translator to be deleted
+ */
+void vm_translator_del(vm_translator_t *vm)
+{
+    for (size_t i = 0; i < vm->n; i++) {
+        command_del(vm->commands[i]);
+    }
+    for (size_t i = 0; i < vm->files_n; i++) {
+        free(vm->files[i]);
+    }
+    free(vm->commands);
+    free(vm->files);
+    free(vm->module);
+    free(vm->function);
+    table_del(vm->calls);
+    table_del(vm->labels);
+    table_del(vm->jumps);
+    free(vm->sites);
+    free(vm);
+}
@@ -0,0 +1,161 @@
+/*
+ * File: vm.h
+ * ----------
+ *  types, constants and function declarations for vm module
+ *
+ *  translates stack VM code straight into assembler commands: C commands
+ *  come out already encoded, function and VM labels go into the symbol
+ *  table at the ROM address of the next generated word and return and
+ *  comparison targets (code laid out right after the jump) are loaded as
+ *  plain addresses, so VM program reaches hack encodings without writing,
+ *  lexing or label-resolving assembly text
+ *
+ *  single '.vm' file is translated on its own, directory is translated as
+ *  whole project (its '.vm' files in name order), starting with bootstrap
+ *  code calling 'Sys.init' if the project has 'Sys.vm'
+ */
+
+#ifndef HACK_ASM_VM_H
+#define HACK_ASM_VM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "parser.h"
+#include "table.h"
+
+#define VM_SUFFIX ".vm"
+#define VM_MAXLINE 256
+#define VM_SP 0
+#define VM_LCL 1
+#define VM_ARG 2
+#define VM_THIS 3
+#define VM_THAT 4
+#define VM_R13 13
+#define VM_R14 14
+#define VM_STACK_BASE 256
+#define VM_TEMP_BASE 5
+#define VM_TEMP_SIZE 8
+#define VM_POINTER_BASE 3
+#define VM_POINTER_SIZE 2
+#define VM_FRAME_SIZE 5 /* return address, LCL, ARG, THIS, THAT */
+#define VM_ENTRY "Sys.init"
+#define VM_ENTRY_FILE "Sys.vm"
+
+typedef struct {
+    const char *path;  /* path of the file for diagnostics */
+    size_t line;
+} vm_site_t;
+
+typedef struct {
+    table_t *table;    /* symbol table receiving labels */
+    int32_t limit;     /* largest valid ROM address */
+    asm_command_t **commands;
+    size_t n;
+    size_t capacity;
+    int64_t words;     /* ROM address of the next command */
+    const char *file;  /* file being translated (NULL for the source) */
+    const char *path;  /* path of file being translated for diagnostics */
+    size_t line;
+    char *module;      /* file name without suffix, prefix of statics */
+    char *function;    /* current function, prefix of its labels */
+    table_t *calls;    /* called function -> 1 */
+    table_t *labels;   /* defined label -> site of its definition */
+    table_t *jumps;    /* 'goto' target -> site of its first use */
+    vm_site_t *sites;  /* definitions and first uses of labels */
+    size_t sites_n;
+    char **files;      /* paths of project files (commands point to them) */
+    size_t files_n;
+    bool failed;       /* error was reported, program must not be written */
+} vm_translator_t;
+
+/*
+ * Function: vm_is_source
+ * ----------------------
+ *  checks wether the path names VM code: '.vm' file (plain or compressed
+ *  with format supported by this build) or project directory
+ *
+ *  path: file path
+ *
+ *  returns: true if path is VM file or directory
+ *           false otherwise
+ */
+bool vm_is_source(const char *path);
+
+/*
+ * Function: vm_is_project
+ * -----------------------
+ *  checks wether the path names VM project directory
+ *
+ *  path: file path
+ *
+ *  returns: true if path is directory
+ *           false otherwise
+ */
+bool vm_is_project(const char *path);
+
+/*
+ * Function: vm_translator_new
+ * ---------------------------
+ *  creates translator placing labels into given table
+ *
+ *  table: symbol table (builtins already added)
+ *  limit: largest valid ROM address
+ *
+ *  returns: pointer to allocated translator
+ */
+vm_translator_t *vm_translator_new(table_t *table, int32_t limit);
+
+/*
+ * Function: vm_translate
+ * ----------------------
+ *  translates every VM command of the stream, stopping at the first
+ *  invalid one (translation is failed then)
+ *
+ *  vm: translator
+ *  stream: VM code stream
+ *  path: path of VM file (names its static variables)
+ *  file: file recorded in generated commands (NULL for the source itself)
+ */
+void vm_translate(vm_translator_t *vm, FILE *stream, const char *path,
+        const char *file);
+
+/*
+ * Function: vm_translate_project
+ * ------------------------------
+ *  translates every '.vm' file of the directory in name order, after
+ *  bootstrap code if there is 'Sys.vm' among them
+ *  fails translation if any file can't be read or is invalid
+ *
+ *  vm: translator
+ *  dir: project directory
+ */
+void vm_translate_project(vm_translator_t *vm, const char *dir);
+
+/*
+ * Function: vm_commands
+ * ---------------------
+ *  hands generated commands over to the caller
+ *  fails translation if any called function isn't defined
+ *
+ *  !!! user in charge of freeing commands (before the translator, they
+ *      point to its file paths)
+ *
+ *  vm: translator
+ *  n_ptr: amount of commands
+ *
+ *  returns: list of generated commands
+ */
+asm_command_t **vm_commands(vm_translator_t *vm, size_t *n_ptr);
+
+/*
+ * Function: vm_translator_del
+ * ---------------------------
+ *  frees memory allocated by translator
+ *
+ *  vm: translator to be deleted
+ */
+void vm_translator_del(vm_translator_t *vm);
+
+#endif // !HACK_ASM_VM_H